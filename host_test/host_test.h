@@ -0,0 +1,46 @@
+/*
+ * host_test.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ *
+ * Minimal assertions for the host tests: a failed check prints where
+ * and the test executable exits non-zero at the end.
+ */
+
+#ifndef HOST_TEST_H_
+#define HOST_TEST_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+
+extern int host_test_failures;
+
+#define TEST_CHECK(cond) do {                                                       \
+        if (!(cond)) {                                                              \
+            printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond);                  \
+            host_test_failures++;                                                   \
+        }                                                                           \
+    } while (0)
+
+#define TEST_CHECK_EQ(expected, actual) do {                                        \
+        long long e_ = (long long)(expected);                                       \
+        long long a_ = (long long)(actual);                                         \
+        if (e_ != a_) {                                                             \
+            printf("FAIL %s:%d: %s == %s, expected %lld, got %lld\n",               \
+                   __FILE__, __LINE__, #expected, #actual, e_, a_);                 \
+            host_test_failures++;                                                   \
+        }                                                                           \
+    } while (0)
+
+#define RUN_TEST(fn) do {                                                           \
+        int before_ = host_test_failures;                                           \
+        fn();                                                                       \
+        printf("%s %s\n", host_test_failures == before_ ? "PASS" : "FAIL", #fn);   \
+    } while (0)
+
+#define TEST_DEFINE_FAILURES    int host_test_failures = 0
+
+#define TEST_EXIT()             return host_test_failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE
+
+#endif /* HOST_TEST_H_ */
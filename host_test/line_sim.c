@@ -0,0 +1,289 @@
+/*
+ * line_sim.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ *
+ * The whole line on the host: io_task, adc_task, logic_task and
+ * tcp_client_task as on the controller, against the plant model, the
+ * stand-in robot and the stand-in inverter over loopback. Reports cubes
+ * per hour, how well the rejects matched the true weights, and the
+ * latency of each stage, so a change can be measured before it goes
+ * near the line.
+ *
+ * Without arguments it runs the default scenario as a test. Options
+ * change the scenario:
+ *   --cubes N --rate CUBES_PER_H --pitch MM --belt MM_S
+ *   --weight G --sd G --outliers PERMILLE --outlier G --noise G
+ *   --pick MS --place MS --wrap MS --layers N --seed N
+ */
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "logic.h"
+#include "io.h"
+#include "adc.h"
+#include "tcp.h"
+#include "conveyor.h"
+#include "outputs.h"
+#include "trace.h"
+#include "throughput.h"
+#include "json_writer.h"
+#include "plant.h"
+#include "robot_server.h"
+#include "modbus_server.h"
+#include "host_port.h"
+#include "host_test.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define INVERTER_UNIT       0x01        // DELTA_INVERTER_ADDRESS
+#define STALL_US            (120LL * 1000000)   // nothing placed or ejected for this long
+#define GROSS_ERROR_G       2000        // outside the band by more than any weighing error
+
+TEST_DEFINE_FAILURES;
+
+QueueHandle_t logic_event_queue = NULL;
+
+static plant_config_t plant_cfg = {
+    .cubes = 120,
+    .rate_per_hour = 900,
+    .pitch_min_mm = PLANT_PLATFORM_MM + PLANT_CUBE_MM,
+    .belt_mm_s = 500,
+    .weight_mean_g = 50000,
+    .weight_sd_g = 500,
+    .outlier_permille = 30,
+    .outlier_g = 4000,
+    .noise_g = 40,
+    .wrap_ms = 60000,
+    .seed = 1,
+};
+
+static robot_server_config_t robot_cfg = {
+    .ack_ms = 20,
+    .pick_ms = 1500,
+    .place_ms = 2500,
+    .on_pick = plant_robot_pick,
+    .on_place = plant_robot_place,
+};
+
+static uint8_t layers = 0;          // 0 keeps the controller's default
+
+static bool parse_args(int argc, char **argv)
+{
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 >= argc) {
+            return false;
+        }
+        const char *opt = argv[i];
+        long v = strtol(argv[++i], NULL, 10);
+
+        if (strcmp(opt, "--cubes") == 0)            plant_cfg.cubes = (uint32_t)v;
+        else if (strcmp(opt, "--rate") == 0)        plant_cfg.rate_per_hour = (uint32_t)v;
+        else if (strcmp(opt, "--pitch") == 0)       plant_cfg.pitch_min_mm = (uint32_t)v;
+        else if (strcmp(opt, "--belt") == 0)        plant_cfg.belt_mm_s = (int32_t)v;
+        else if (strcmp(opt, "--weight") == 0)      plant_cfg.weight_mean_g = (int32_t)v;
+        else if (strcmp(opt, "--sd") == 0)          plant_cfg.weight_sd_g = (int32_t)v;
+        else if (strcmp(opt, "--outliers") == 0)    plant_cfg.outlier_permille = (uint16_t)v;
+        else if (strcmp(opt, "--outlier") == 0)     plant_cfg.outlier_g = (int32_t)v;
+        else if (strcmp(opt, "--noise") == 0)       plant_cfg.noise_g = (int32_t)v;
+        else if (strcmp(opt, "--pick") == 0)        robot_cfg.pick_ms = (uint32_t)v;
+        else if (strcmp(opt, "--place") == 0)       robot_cfg.place_ms = (uint32_t)v;
+        else if (strcmp(opt, "--wrap") == 0)        plant_cfg.wrap_ms = (uint32_t)v;
+        else if (strcmp(opt, "--layers") == 0)      layers = (uint8_t)v;
+        else if (strcmp(opt, "--seed") == 0)        plant_cfg.seed = (uint32_t)v;
+        else return false;
+    }
+    return plant_cfg.cubes > 0 && plant_cfg.rate_per_hour > 0 && plant_cfg.belt_mm_s > 0;
+}
+
+static bool in_band(int32_t weight_g)
+{
+    return weight_g >= PLANT_WEIGHT_MIN_G && weight_g <= PLANT_WEIGHT_MAX_G;
+}
+
+static int cmp_i64(const void *a, const void *b)
+{
+    int64_t x = *(const int64_t *)a;
+    int64_t y = *(const int64_t *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+// p50 and p99 of n durations in microseconds, printed in milliseconds
+static void print_stage(const char *name, int64_t *us, int n)
+{
+    if (n == 0) {
+        printf("  %-22s no samples\n", name);
+        return;
+    }
+    qsort(us, (size_t)n, sizeof(us[0]), cmp_i64);
+    printf("  %-22s p50 %8.1f ms  p99 %8.1f ms  max %8.1f ms  (%d)\n", name,
+           us[n / 2] / 1000.0, us[(n * 99 + 99) / 100 - 1] / 1000.0, us[n - 1] / 1000.0, n);
+}
+
+static void print_json(const char *title, void (*write)(json_writer_t *w))
+{
+    char buf[1024];
+    json_writer_t w;
+
+    json_writer_init(&w, buf, sizeof(buf));
+    write(&w);
+    printf("%s\n  %s\n", title, json_writer_finish(&w) > 0 ? buf : "(too long)");
+}
+
+static void write_line_counters(json_writer_t *w)
+{
+    throughput_write_json(w, NULL);
+}
+
+static void start_line(void)
+{
+    io_init();
+    conveyor_init();
+    outputs_init();
+    start_io_task();
+    adc_task_start();
+    start_logic_task();
+    start_tcp_client_task();
+
+    if (layers != 0) {
+        logic_event_t evt = {
+            .type = LOGIC_EVT_HMI,
+            .hmi = { .id = HMI_CMD_SET_LAYERS, .layers = layers },
+        };
+        logic_post_event_wait(&evt, portMAX_DELAY);
+    }
+}
+
+// Until every cube is on a pallet or off the line, or the line stops moving
+static bool run_line(void)
+{
+    plant_stats_t st;
+    uint32_t resolved = 0;
+    int64_t last_change = host_now_us();
+
+    while (!plant_done()) {
+        host_sleep_us(1000000);
+        plant_get_stats(&st);
+        if (st.placed + st.ejected != resolved) {
+            resolved = st.placed + st.ejected;
+            last_change = host_now_us();
+        } else if (host_now_us() - last_change > STALL_US && !st.wrapping) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void report(robot_server_t *robot)
+{
+    const plant_cube_t *cubes = plant_cubes();
+    const uint32_t n = plant_cfg.cubes;
+    int64_t *infeed = calloc(n, sizeof(int64_t));
+    int64_t *to_t3 = calloc(n, sizeof(int64_t));
+    int64_t *to_pallet = calloc(n, sizeof(int64_t));
+    int n_infeed = 0, n_t3 = 0, n_pallet = 0;
+    uint32_t good_placed = 0, good_ejected = 0, bad_ejected = 0, bad_placed = 0, lost = 0, gross_placed = 0;
+    int64_t first_us = INT64_MAX, last_us = 0;
+    plant_stats_t st;
+
+    for (uint32_t i = 0; i < n; i++) {
+        const plant_cube_t *c = &cubes[i];
+        bool good = in_band(c->weight_g);
+
+        if (c->fate == PLANT_CUBE_PLACED) {
+            good ? good_placed++ : bad_placed++;
+            if (c->weight_g < PLANT_WEIGHT_MIN_G - GROSS_ERROR_G || c->weight_g > PLANT_WEIGHT_MAX_G + GROSS_ERROR_G) {
+                gross_placed++;
+            }
+            to_pallet[n_pallet++] = c->done_us - c->t3_us;
+            if (c->done_us > last_us) {
+                last_us = c->done_us;
+            }
+        } else if (c->fate == PLANT_CUBE_EJECTED) {
+            good ? good_ejected++ : bad_ejected++;
+        } else {
+            lost++;
+        }
+        if (c->t1_us != 0) {
+            infeed[n_infeed++] = c->t1_us - c->arrive_us;
+            if (c->t1_us < first_us) {
+                first_us = c->t1_us;
+            }
+        }
+        if (c->t3_us != 0) {
+            to_t3[n_t3++] = c->t3_us - c->t1_us;
+        }
+    }
+    plant_get_stats(&st);
+
+    uint32_t placed = good_placed + bad_placed;
+    double hours = last_us > first_us ? (last_us - first_us) / 3.6e9 : 0;
+    uint32_t decided = placed + good_ejected + bad_ejected;
+    uint32_t robot_per_hour = 3600000u / (robot_cfg.pick_ms + robot_cfg.place_ms);
+
+    printf("Scenario: %lu cubes at %lu/h, %ld g sd %ld g, %u permille off by %ld g, noise %ld g, "
+           "belt %ld mm/s, robot %lu+%lu ms, wrap %lu ms, seed %lu\n",
+           (unsigned long)n, (unsigned long)plant_cfg.rate_per_hour, (long)plant_cfg.weight_mean_g,
+           (long)plant_cfg.weight_sd_g, plant_cfg.outlier_permille, (long)plant_cfg.outlier_g,
+           (long)plant_cfg.noise_g, (long)plant_cfg.belt_mm_s, (unsigned long)robot_cfg.pick_ms,
+           (unsigned long)robot_cfg.place_ms, (unsigned long)plant_cfg.wrap_ms, (unsigned long)plant_cfg.seed);
+    printf("Throughput: %lu placed in %.1f min: %.0f cubes/h (robot alone %lu/h), %lu pallets wrapped\n",
+           (unsigned long)placed, hours * 60, hours > 0 ? placed / hours : 0.0, (unsigned long)robot_per_hour,
+           (unsigned long)st.wraps_done);
+    printf("Reject accuracy: %.2f %% of %lu cubes\n", decided ? 100.0 * (good_placed + bad_ejected) / decided : 0.0,
+           (unsigned long)decided);
+    printf("  in band:      %5lu placed, %5lu ejected (false rejects)\n",
+           (unsigned long)good_placed, (unsigned long)good_ejected);
+    printf("  out of band:  %5lu ejected, %5lu placed (escapes)\n", (unsigned long)bad_ejected, (unsigned long)bad_placed);
+    printf("Plant stages:\n");
+    print_stage("infeed wait", infeed, n_infeed);
+    print_stage("T1 to T3", to_t3, n_t3);
+    print_stage("T3 to pallet", to_pallet, n_pallet);
+    print_json("Controller stages, /api/trace (us):", trace_write_json);
+    print_json("Line counters, /api/diag line:", write_line_counters);
+
+    // Every cube accounted for, the robot never sent for a cube that was not there
+    TEST_CHECK_EQ(0, lost);
+    TEST_CHECK_EQ(n, decided);
+    TEST_CHECK_EQ(0, robot_server_errors(robot));
+    TEST_CHECK_EQ(0, gross_placed);
+    TEST_CHECK(placed > 0);
+
+    free(infeed);
+    free(to_t3);
+    free(to_pallet);
+}
+
+int main(int argc, char **argv)
+{
+    if (!parse_args(argc, argv)) {
+        printf("usage: %s [--option value]..., see line_sim.c\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    host_port_init();
+    logic_event_queue = xQueueCreate(32, sizeof(logic_event_t));
+
+    modbus_server_t *inverter = modbus_server_start(SIM_INVERTER_PORT, INVERTER_UNIT);
+    robot_server_t *robot = robot_server_start(SIM_ROBOT_PORT, &robot_cfg);
+    if (inverter == NULL || robot == NULL) {
+        printf("FAIL cannot listen on ports %d and %d\n", SIM_INVERTER_PORT, SIM_ROBOT_PORT);
+        return EXIT_FAILURE;
+    }
+
+    plant_start(&plant_cfg, inverter);
+    start_line();
+
+    int64_t wall = host_wall_us();
+    bool finished = run_line();
+    if (!finished) {
+        printf("FAIL line stalled at %.1f s\n", host_now_us() / 1e6);
+        host_test_failures++;
+    }
+    report(robot);
+    printf("%.0f s of line time in %.1f s\n", host_now_us() / 1e6, (host_wall_us() - wall) / 1e6);
+    TEST_EXIT();
+}
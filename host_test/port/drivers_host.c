@@ -0,0 +1,214 @@
+/*
+ * drivers_host.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ *
+ * PCNT and continuous ADC drivers fed by the simulation. The count and
+ * the samples are functions of virtual time, so they are exact whenever
+ * the control code looks.
+ */
+
+#include "driver/pulse_cnt.h"
+#include "esp_adc/adc_continuous.h"
+#include "esp_timer.h"
+#include "host_port.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* ------------------------------------------------------------------ */
+/* PCNT                                                               */
+/* ------------------------------------------------------------------ */
+
+struct host_pcnt_unit {
+    int unused;
+};
+
+struct host_pcnt_channel {
+    int unused;
+};
+
+static struct host_pcnt_unit pcnt_unit;
+static struct host_pcnt_channel pcnt_channels[2];
+static host_pcnt_source_t pcnt_source = NULL;
+static void *pcnt_ctx = NULL;
+
+void host_pcnt_set_source(host_pcnt_source_t fn, void *ctx)
+{
+    pcnt_ctx = ctx;
+    pcnt_source = fn;
+}
+
+esp_err_t pcnt_new_unit(const pcnt_unit_config_t *config, pcnt_unit_handle_t *ret_unit)
+{
+    *ret_unit = &pcnt_unit;
+    return ESP_OK;
+}
+
+esp_err_t pcnt_unit_set_glitch_filter(pcnt_unit_handle_t unit, const pcnt_glitch_filter_config_t *config)
+{
+    return ESP_OK;
+}
+
+esp_err_t pcnt_new_channel(pcnt_unit_handle_t unit, const pcnt_chan_config_t *config,
+                           pcnt_channel_handle_t *ret_chan)
+{
+    static int n = 0;
+
+    *ret_chan = &pcnt_channels[n++ % 2];
+    return ESP_OK;
+}
+
+esp_err_t pcnt_channel_set_edge_action(pcnt_channel_handle_t chan, pcnt_channel_edge_action_t pos_act,
+                                       pcnt_channel_edge_action_t neg_act)
+{
+    return ESP_OK;
+}
+
+esp_err_t pcnt_channel_set_level_action(pcnt_channel_handle_t chan, pcnt_channel_level_action_t high_act,
+                                        pcnt_channel_level_action_t low_act)
+{
+    return ESP_OK;
+}
+
+esp_err_t pcnt_unit_add_watch_point(pcnt_unit_handle_t unit, int watch_point)
+{
+    return ESP_OK;
+}
+
+esp_err_t pcnt_unit_enable(pcnt_unit_handle_t unit)
+{
+    return ESP_OK;
+}
+
+esp_err_t pcnt_unit_clear_count(pcnt_unit_handle_t unit)
+{
+    return ESP_OK;
+}
+
+esp_err_t pcnt_unit_start(pcnt_unit_handle_t unit)
+{
+    return ESP_OK;
+}
+
+esp_err_t pcnt_unit_get_count(pcnt_unit_handle_t unit, int *value)
+{
+    host_pcnt_source_t fn = pcnt_source;
+
+    *value = fn != NULL ? fn(esp_timer_get_time(), pcnt_ctx) : 0;
+    return ESP_OK;
+}
+
+/* ------------------------------------------------------------------ */
+/* Continuous ADC                                                     */
+/* ------------------------------------------------------------------ */
+
+struct host_adc_continuous {
+    uint32_t frame_size;
+    uint32_t sample_freq_hz;
+    uint8_t  channel;
+    int64_t  start_us;
+    uint64_t next_sample;           // index of the next sample handed out
+    adc_continuous_evt_cbs_t cbs;
+    void    *user_data;
+    esp_timer_handle_t frame_timer;
+};
+
+static struct host_adc_continuous adc_unit;
+static host_adc_source_t adc_source = NULL;
+static void *adc_ctx = NULL;
+
+void host_adc_set_source(host_adc_source_t fn, void *ctx)
+{
+    adc_ctx = ctx;
+    adc_source = fn;
+}
+
+static int64_t adc_sample_time(const struct host_adc_continuous *a, uint64_t index)
+{
+    return a->start_us + (int64_t)(index * 1000000 / a->sample_freq_hz);
+}
+
+static uint32_t adc_frame_samples(const struct host_adc_continuous *a)
+{
+    return a->frame_size / SOC_ADC_DIGI_RESULT_BYTES;
+}
+
+// DMA end-of-frame interrupt
+static void adc_frame_cb(void *arg)
+{
+    struct host_adc_continuous *a = arg;
+    adc_continuous_evt_data_t edata = { .size = a->frame_size };
+
+    if (a->cbs.on_conv_done != NULL) {
+        a->cbs.on_conv_done(a, &edata, a->user_data);
+    }
+}
+
+esp_err_t adc_continuous_new_handle(const adc_continuous_handle_cfg_t *cfg, adc_continuous_handle_t *ret)
+{
+    memset(&adc_unit, 0, sizeof(adc_unit));
+    adc_unit.frame_size = cfg->conv_frame_size;
+    *ret = &adc_unit;
+    return ESP_OK;
+}
+
+esp_err_t adc_continuous_config(adc_continuous_handle_t handle, const adc_continuous_config_t *config)
+{
+    if (config->pattern_num != 1 || config->sample_freq_hz == 0) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    handle->sample_freq_hz = config->sample_freq_hz;
+    handle->channel = config->adc_pattern[0].channel;
+    return ESP_OK;
+}
+
+esp_err_t adc_continuous_register_event_callbacks(adc_continuous_handle_t handle,
+                                                  const adc_continuous_evt_cbs_t *cbs, void *user_data)
+{
+    handle->cbs = *cbs;
+    handle->user_data = user_data;
+    return ESP_OK;
+}
+
+esp_err_t adc_continuous_start(adc_continuous_handle_t handle)
+{
+    esp_timer_create_args_t args = {
+        .callback = adc_frame_cb,
+        .arg = handle,
+        .name = "adc_dma",
+    };
+    esp_err_t err = esp_timer_create(&args, &handle->frame_timer);
+
+    if (err != ESP_OK) {
+        return err;
+    }
+    handle->start_us = esp_timer_get_time();
+    handle->next_sample = 0;
+    uint64_t frame_us = (uint64_t)adc_frame_samples(handle) * 1000000 / handle->sample_freq_hz;
+    return esp_timer_start_periodic(handle->frame_timer, frame_us);
+}
+
+esp_err_t adc_continuous_read(adc_continuous_handle_t handle, uint8_t *buf, uint32_t length_max,
+                              uint32_t *out_length, uint32_t timeout_ms)
+{
+    uint32_t n = adc_frame_samples(handle);
+    int64_t now = esp_timer_get_time();
+
+    *out_length = 0;
+    // Only whole frames are handed out, as by the DMA
+    if (length_max < handle->frame_size || adc_sample_time(handle, handle->next_sample + n - 1) > now) {
+        return ESP_ERR_TIMEOUT;
+    }
+
+    host_adc_source_t fn = adc_source;
+    for (uint32_t i = 0; i < n; i++) {
+        int64_t t = adc_sample_time(handle, handle->next_sample++);
+        adc_digi_output_data_t d = { 0 };
+        d.type1.channel = handle->channel;
+        d.type1.data = (fn != NULL ? fn(t, adc_ctx) : 0) & 0xFFF;
+        memcpy(buf + i * SOC_ADC_DIGI_RESULT_BYTES, &d, SOC_ADC_DIGI_RESULT_BYTES);
+    }
+    *out_length = handle->frame_size;
+    return ESP_OK;
+}
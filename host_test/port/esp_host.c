@@ -0,0 +1,300 @@
+/*
+ * esp_host.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ *
+ * System services of the host port: logging, error names, reset reason,
+ * heap statistics, the flash partition and NVS in RAM.
+ */
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_system.h"
+#include "esp_heap_caps.h"
+#include "esp_partition.h"
+#include "esp_timer.h"
+#include "nvs.h"
+#include "host_port.h"
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HOST_LOG_DEFAULT        ESP_LOG_WARN
+#define HOST_NVS_MAX_ENTRIES    16
+#define HOST_NVS_MAX_BLOB       256
+#define HOST_FLASH_SECTOR       4096
+
+/* ------------------------------------------------------------------ */
+/* Logging                                                            */
+/* ------------------------------------------------------------------ */
+
+static int log_level = -1;
+static pthread_mutex_t log_lock = PTHREAD_MUTEX_INITIALIZER;
+
+esp_log_level_t esp_log_level_get(const char *tag)
+{
+    if (log_level < 0) {
+        const char *env = getenv("HOST_LOG_LEVEL");
+        log_level = env != NULL ? atoi(env) : HOST_LOG_DEFAULT;
+    }
+    return (esp_log_level_t)log_level;
+}
+
+void esp_log_level_set(const char *tag, esp_log_level_t level)
+{
+    log_level = level;
+}
+
+uint32_t esp_log_timestamp(void)
+{
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+void esp_log_write(esp_log_level_t level, const char *tag, const char *format, ...)
+{
+    va_list ap;
+
+    if (level > esp_log_level_get(tag)) {
+        return;
+    }
+    pthread_mutex_lock(&log_lock);
+    va_start(ap, format);
+    vprintf(format, ap);
+    va_end(ap);
+    pthread_mutex_unlock(&log_lock);
+}
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    switch (code) {
+        case ESP_OK:                return "ESP_OK";
+        case ESP_FAIL:              return "ESP_FAIL";
+        case ESP_ERR_NO_MEM:        return "ESP_ERR_NO_MEM";
+        case ESP_ERR_INVALID_ARG:   return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_INVALID_STATE: return "ESP_ERR_INVALID_STATE";
+        case ESP_ERR_INVALID_SIZE:  return "ESP_ERR_INVALID_SIZE";
+        case ESP_ERR_NOT_FOUND:     return "ESP_ERR_NOT_FOUND";
+        case ESP_ERR_NOT_SUPPORTED: return "ESP_ERR_NOT_SUPPORTED";
+        case ESP_ERR_TIMEOUT:       return "ESP_ERR_TIMEOUT";
+        case ESP_ERR_NVS_NOT_FOUND: return "ESP_ERR_NVS_NOT_FOUND";
+        default:                    return "UNKNOWN ERROR";
+    }
+}
+
+esp_reset_reason_t esp_reset_reason(void)
+{
+    return ESP_RST_POWERON;
+}
+
+size_t heap_caps_get_free_size(uint32_t caps)
+{
+    return 0;
+}
+
+size_t heap_caps_get_minimum_free_size(uint32_t caps)
+{
+    return 0;
+}
+
+size_t heap_caps_get_largest_free_block(uint32_t caps)
+{
+    return 0;
+}
+
+/* ------------------------------------------------------------------ */
+/* Flash partition                                                    */
+/* ------------------------------------------------------------------ */
+
+static esp_partition_t flash_part;
+static uint8_t *flash = NULL;
+static int32_t flash_budget = -1;   // bytes still written before the simulated power loss
+static pthread_mutex_t flash_lock = PTHREAD_MUTEX_INITIALIZER;
+
+void host_flash_init(size_t size)
+{
+    free(flash);
+    flash = malloc(size);
+    memset(flash, 0xFF, size);
+    flash_budget = -1;
+    flash_part = (esp_partition_t){
+        .type = ESP_PARTITION_TYPE_DATA,
+        .subtype = 0x40,
+        .size = (uint32_t)size,
+        .erase_size = HOST_FLASH_SECTOR,
+        .label = "evlog",
+    };
+}
+
+uint8_t *host_flash_data(void)
+{
+    return flash;
+}
+
+void host_flash_fail_after(int32_t bytes)
+{
+    pthread_mutex_lock(&flash_lock);
+    flash_budget = bytes;
+    pthread_mutex_unlock(&flash_lock);
+}
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+                                                const char *label)
+{
+    if (flash == NULL || type != flash_part.type || subtype != flash_part.subtype ||
+        (label != NULL && strcmp(label, flash_part.label) != 0)) {
+        return NULL;
+    }
+    return &flash_part;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t *part, size_t offset, void *dst, size_t size)
+{
+    if (offset + size > part->size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    pthread_mutex_lock(&flash_lock);
+    memcpy(dst, flash + offset, size);
+    pthread_mutex_unlock(&flash_lock);
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t *part, size_t offset, const void *src, size_t size)
+{
+    const uint8_t *p = src;
+
+    if (offset + size > part->size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    pthread_mutex_lock(&flash_lock);
+    for (size_t i = 0; i < size; i++) {
+        if (flash_budget == 0) {
+            break;
+        }
+        if (flash_budget > 0) {
+            flash_budget--;
+        }
+        // NOR flash: programming only clears bits
+        flash[offset + i] &= p[i];
+    }
+    pthread_mutex_unlock(&flash_lock);
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t *part, size_t offset, size_t size)
+{
+    if (offset % HOST_FLASH_SECTOR != 0 || size % HOST_FLASH_SECTOR != 0 || offset + size > part->size) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pthread_mutex_lock(&flash_lock);
+    if (flash_budget != 0) {
+        memset(flash + offset, 0xFF, size);
+    }
+    pthread_mutex_unlock(&flash_lock);
+    return ESP_OK;
+}
+
+/* ------------------------------------------------------------------ */
+/* NVS                                                                */
+/* ------------------------------------------------------------------ */
+
+typedef struct {
+    bool    used;
+    char    ns[16];
+    char    key[16];
+    size_t  len;
+    uint8_t data[HOST_NVS_MAX_BLOB];
+} nvs_entry_t;
+
+static nvs_entry_t nvs_entries[HOST_NVS_MAX_ENTRIES];
+static char nvs_open_ns[HOST_NVS_MAX_ENTRIES][16];
+static pthread_mutex_t nvs_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static nvs_entry_t *nvs_find(nvs_handle_t handle, const char *key, bool create)
+{
+    const char *ns = nvs_open_ns[handle];
+    nvs_entry_t *free_entry = NULL;
+
+    for (int i = 0; i < HOST_NVS_MAX_ENTRIES; i++) {
+        nvs_entry_t *e = &nvs_entries[i];
+        if (!e->used) {
+            free_entry = free_entry ? free_entry : e;
+        } else if (strcmp(e->ns, ns) == 0 && strcmp(e->key, key) == 0) {
+            return e;
+        }
+    }
+    if (create && free_entry != NULL) {
+        free_entry->used = true;
+        snprintf(free_entry->ns, sizeof(free_entry->ns), "%s", ns);
+        snprintf(free_entry->key, sizeof(free_entry->key), "%s", key);
+        return free_entry;
+    }
+    return NULL;
+}
+
+esp_err_t nvs_open(const char *name, nvs_open_mode_t mode, nvs_handle_t *out)
+{
+    pthread_mutex_lock(&nvs_lock);
+    for (nvs_handle_t h = 1; h < HOST_NVS_MAX_ENTRIES; h++) {
+        if (nvs_open_ns[h][0] == '\0') {
+            snprintf(nvs_open_ns[h], sizeof(nvs_open_ns[h]), "%s", name);
+            *out = h;
+            pthread_mutex_unlock(&nvs_lock);
+            return ESP_OK;
+        }
+    }
+    pthread_mutex_unlock(&nvs_lock);
+    return ESP_ERR_NO_MEM;
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out, size_t *length)
+{
+    esp_err_t err = ESP_ERR_NVS_NOT_FOUND;
+
+    pthread_mutex_lock(&nvs_lock);
+    nvs_entry_t *e = nvs_find(handle, key, false);
+    if (e != NULL) {
+        if (out == NULL) {
+            *length = e->len;
+            err = ESP_OK;
+        } else if (*length < e->len) {
+            err = ESP_ERR_INVALID_SIZE;
+        } else {
+            memcpy(out, e->data, e->len);
+            *length = e->len;
+            err = ESP_OK;
+        }
+    }
+    pthread_mutex_unlock(&nvs_lock);
+    return err;
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length)
+{
+    if (length > HOST_NVS_MAX_BLOB) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    pthread_mutex_lock(&nvs_lock);
+    nvs_entry_t *e = nvs_find(handle, key, true);
+    if (e != NULL) {
+        memcpy(e->data, value, length);
+        e->len = length;
+    }
+    pthread_mutex_unlock(&nvs_lock);
+    return e != NULL ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle)
+{
+    return ESP_OK;
+}
+
+void nvs_close(nvs_handle_t handle)
+{
+    pthread_mutex_lock(&nvs_lock);
+    nvs_open_ns[handle][0] = '\0';
+    pthread_mutex_unlock(&nvs_lock);
+}
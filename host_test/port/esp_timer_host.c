@@ -0,0 +1,149 @@
+/*
+ * esp_timer_host.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ *
+ * esp_timer on the virtual clock. One dispatcher task runs the due
+ * callbacks in expiry order and sleeps until the next expiry otherwise.
+ */
+
+#include "esp_timer.h"
+#include "host_port.h"
+#include "host_sched.h"
+#include <stdlib.h>
+
+struct esp_timer {
+    esp_timer_cb_t  cb;
+    void           *arg;
+    const char     *name;
+    int64_t         expiry;
+    uint64_t        period;         // 0 for one-shot
+    bool            armed;
+    struct esp_timer *next;
+};
+
+static struct esp_timer *timers = NULL;
+static pthread_once_t dispatcher_once = PTHREAD_ONCE_INIT;
+
+static void esp_timer_task(void *arg)
+{
+    pthread_mutex_lock(&host_lock);
+    for (;;) {
+        struct esp_timer *due = NULL;
+        for (struct esp_timer *t = timers; t != NULL; t = t->next) {
+            if (t->armed && (due == NULL || t->expiry < due->expiry)) {
+                due = t;
+            }
+        }
+
+        if (due == NULL || due->expiry > host_now_us()) {
+            host_block(&timers, due != NULL ? due->expiry : HOST_FOREVER);
+            continue;
+        }
+
+        if (due->period != 0) {
+            due->expiry += (int64_t)due->period;
+        } else {
+            due->armed = false;
+        }
+        pthread_mutex_unlock(&host_lock);
+        due->cb(due->arg);
+        pthread_mutex_lock(&host_lock);
+    }
+}
+
+static void esp_timer_dispatcher_start(void)
+{
+    host_task_start(esp_timer_task, "esp_timer", NULL);
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *out)
+{
+    struct esp_timer *t = calloc(1, sizeof(*t));
+
+    if (t == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    pthread_once(&dispatcher_once, esp_timer_dispatcher_start);
+
+    t->cb = args->callback;
+    t->arg = args->arg;
+    t->name = args->name;
+    pthread_mutex_lock(&host_lock);
+    t->next = timers;
+    timers = t;
+    pthread_mutex_unlock(&host_lock);
+    *out = t;
+    return ESP_OK;
+}
+
+static esp_err_t esp_timer_arm(esp_timer_handle_t t, uint64_t timeout_us, uint64_t period_us)
+{
+    esp_err_t err = ESP_ERR_INVALID_STATE;
+
+    pthread_mutex_lock(&host_lock);
+    if (!t->armed) {
+        t->expiry = host_now_us() + (int64_t)timeout_us;
+        t->period = period_us;
+        t->armed = true;
+        host_wake_all(&timers);
+        err = ESP_OK;
+    }
+    pthread_mutex_unlock(&host_lock);
+    return err;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us)
+{
+    return esp_timer_arm(timer, timeout_us, 0);
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period_us)
+{
+    return esp_timer_arm(timer, period_us, period_us);
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+    esp_err_t err = ESP_ERR_INVALID_STATE;
+
+    pthread_mutex_lock(&host_lock);
+    if (timer->armed) {
+        timer->armed = false;
+        err = ESP_OK;
+    }
+    pthread_mutex_unlock(&host_lock);
+    return err;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer)
+{
+    pthread_mutex_lock(&host_lock);
+    if (timer->armed) {
+        pthread_mutex_unlock(&host_lock);
+        return ESP_ERR_INVALID_STATE;
+    }
+    for (struct esp_timer **pp = &timers; *pp != NULL; pp = &(*pp)->next) {
+        if (*pp == timer) {
+            *pp = timer->next;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&host_lock);
+    free(timer);
+    return ESP_OK;
+}
+
+bool esp_timer_is_active(esp_timer_handle_t timer)
+{
+    pthread_mutex_lock(&host_lock);
+    bool armed = timer->armed;
+    pthread_mutex_unlock(&host_lock);
+    return armed;
+}
+
+int64_t esp_timer_get_time(void)
+{
+    return host_now_us();
+}
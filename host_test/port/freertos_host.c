@@ -0,0 +1,635 @@
+/*
+ * freertos_host.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ *
+ * FreeRTOS tasks, queues, notifications and the timer service on POSIX
+ * threads, on a virtual clock. Every task is a thread; a task that
+ * blocks leaves the runnable count, and when that count reaches zero the
+ * clock jumps to the earliest deadline of the blocked tasks. Sockets
+ * waited for in select() are polled before the clock moves.
+ */
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/timers.h"
+#include "lwip/sockets.h"
+#include "host_port.h"
+#include "host_sched.h"
+#include <errno.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define HOST_TICK_US    (1000000 / configTICK_RATE_HZ)
+
+struct host_task {
+    pthread_t       thread;
+    pthread_cond_t  cond;
+    char            name[16];
+    TaskFunction_t  fn;
+    void           *arg;
+    bool            blocked;
+    bool            timed_out;
+    const void     *wait_obj;       // what a blocked task waits for
+    int64_t         deadline;       // virtual us, HOST_FOREVER for none
+    uint32_t        notify;
+    // select() waiters
+    int             sel_nfds;
+    fd_set          sel_r;
+    fd_set          sel_w;
+    bool            sel_has_r;
+    bool            sel_has_w;
+    struct host_task *next;
+};
+
+struct host_queue {
+    uint8_t    *buf;
+    size_t      item_size;
+    UBaseType_t length;
+    UBaseType_t count;
+    UBaseType_t head;
+    char        not_empty;          // wait objects
+    char        not_full;
+};
+
+pthread_mutex_t host_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t crit_lock;
+static int64_t now_us = 0;
+static int runnable = 0;
+static struct host_task *tasks = NULL;
+static __thread struct host_task *self = NULL;
+static const char select_obj = 0;
+
+static bool host_poll_selects(int timeout_ms);
+
+/*
+ * Called whenever a task stops running. With no task left runnable the
+ * sockets are checked, then the clock moves to the next deadline.
+ */
+static void host_advance(void)
+{
+    while (runnable == 0) {
+        if (host_poll_selects(0)) {
+            return;
+        }
+
+        int64_t next = HOST_FOREVER;
+        bool selecting = false;
+        for (struct host_task *t = tasks; t != NULL; t = t->next) {
+            if (!t->blocked) {
+                continue;
+            }
+            selecting |= t->wait_obj == &select_obj;
+            if (t->deadline != HOST_FOREVER && (next == HOST_FOREVER || t->deadline < next)) {
+                next = t->deadline;
+            }
+        }
+
+        if (next == HOST_FOREVER) {
+            // Only sockets can still make progress: give the peer real time
+            if (selecting && host_poll_selects(1000)) {
+                return;
+            }
+            fprintf(stderr, "host: every task is blocked forever at %lld us\n", (long long)now_us);
+            for (struct host_task *t = tasks; t != NULL; t = t->next) {
+                fprintf(stderr, "host:   %s%s\n", t->name, t->blocked ? " (blocked)" : "");
+            }
+            abort();
+        }
+
+        if (next > now_us) {
+            __atomic_store_n(&now_us, next, __ATOMIC_RELEASE);
+        }
+        for (struct host_task *t = tasks; t != NULL; t = t->next) {
+            if (t->blocked && t->deadline != HOST_FOREVER && t->deadline <= now_us) {
+                t->blocked = false;
+                t->timed_out = true;
+                runnable++;
+                pthread_cond_signal(&t->cond);
+            }
+        }
+    }
+}
+
+static void host_wake(struct host_task *t)
+{
+    t->blocked = false;
+    t->timed_out = false;
+    runnable++;
+    pthread_cond_signal(&t->cond);
+}
+
+void host_wake_all(const void *obj)
+{
+    for (struct host_task *t = tasks; t != NULL; t = t->next) {
+        if (t->blocked && t->wait_obj == obj) {
+            host_wake(t);
+        }
+    }
+}
+
+bool host_block(const void *obj, int64_t deadline)
+{
+    struct host_task *t = self;
+
+    if (t == NULL) {
+        fprintf(stderr, "host: blocking call from a thread that is not a task\n");
+        abort();
+    }
+    t->wait_obj = obj;
+    t->deadline = deadline;
+    t->timed_out = false;
+    t->blocked = true;
+    runnable--;
+    host_advance();
+    while (t->blocked) {
+        pthread_cond_wait(&t->cond, &host_lock);
+    }
+    return !t->timed_out;
+}
+
+int64_t host_tick_deadline(uint32_t ticks)
+{
+    if (ticks == portMAX_DELAY) {
+        return HOST_FOREVER;
+    }
+    return (now_us / HOST_TICK_US + ticks) * HOST_TICK_US;
+}
+
+/* ------------------------------------------------------------------ */
+/* Port control                                                       */
+/* ------------------------------------------------------------------ */
+
+static struct host_task *host_task_new(const char *name)
+{
+    struct host_task *t = calloc(1, sizeof(*t));
+
+    pthread_cond_init(&t->cond, NULL);
+    snprintf(t->name, sizeof(t->name), "%s", name);
+    t->next = tasks;
+    tasks = t;
+    runnable++;
+    return t;
+}
+
+void host_port_init(void)
+{
+    pthread_mutexattr_t attr;
+
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&crit_lock, &attr);
+    // A peer closing the connection must not kill the process
+    signal(SIGPIPE, SIG_IGN);
+    setvbuf(stdout, NULL, _IOLBF, 0);
+
+    pthread_mutex_lock(&host_lock);
+    self = host_task_new("main");
+    self->thread = pthread_self();
+    pthread_mutex_unlock(&host_lock);
+}
+
+int64_t host_now_us(void)
+{
+    return __atomic_load_n(&now_us, __ATOMIC_ACQUIRE);
+}
+
+void host_sleep_until(int64_t t_us)
+{
+    pthread_mutex_lock(&host_lock);
+    while (now_us < t_us) {
+        host_block(&now_us, t_us);
+    }
+    pthread_mutex_unlock(&host_lock);
+}
+
+void host_sleep_us(int64_t us)
+{
+    host_sleep_until(host_now_us() + us);
+}
+
+void host_settle(void)
+{
+    pthread_mutex_lock(&host_lock);
+    // Due now: woken once no other task is runnable, before the clock can move
+    host_block(&now_us, now_us);
+    pthread_mutex_unlock(&host_lock);
+}
+
+int64_t host_wall_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+void host_enter_critical(void)
+{
+    pthread_mutex_lock(&crit_lock);
+}
+
+void host_exit_critical(void)
+{
+    pthread_mutex_unlock(&crit_lock);
+}
+
+/* ------------------------------------------------------------------ */
+/* Tasks                                                              */
+/* ------------------------------------------------------------------ */
+
+static void host_task_exit(void)
+{
+    pthread_mutex_lock(&host_lock);
+    for (struct host_task **pp = &tasks; *pp != NULL; pp = &(*pp)->next) {
+        if (*pp == self) {
+            *pp = self->next;
+            break;
+        }
+    }
+    runnable--;
+    host_advance();
+    pthread_mutex_unlock(&host_lock);
+    pthread_exit(NULL);
+}
+
+static void *host_task_main(void *arg)
+{
+    struct host_task *t = arg;
+
+    self = t;
+    t->fn(t->arg);
+    host_task_exit();
+    return NULL;
+}
+
+struct host_task *host_task_start(void (*fn)(void *), const char *name, void *arg)
+{
+    pthread_attr_t attr;
+
+    pthread_mutex_lock(&host_lock);
+    struct host_task *t = host_task_new(name);
+    t->fn = fn;
+    t->arg = arg;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    if (pthread_create(&t->thread, &attr, host_task_main, t) != 0) {
+        fprintf(stderr, "host: cannot start task %s\n", name);
+        abort();
+    }
+    pthread_attr_destroy(&attr);
+    pthread_mutex_unlock(&host_lock);
+    return t;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack_depth,
+                                   void *arg, UBaseType_t priority, TaskHandle_t *created,
+                                   BaseType_t core_id)
+{
+    struct host_task *t = host_task_start(fn, name, arg);
+
+    if (created != NULL) {
+        *created = t;
+    }
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    if (task != NULL && task != self) {
+        fprintf(stderr, "host: only a task can delete itself\n");
+        abort();
+    }
+    host_task_exit();
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    pthread_mutex_lock(&host_lock);
+    int64_t deadline = host_tick_deadline(ticks);
+    while (deadline == HOST_FOREVER || now_us < deadline) {
+        host_block(&now_us, deadline);
+    }
+    pthread_mutex_unlock(&host_lock);
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)(host_now_us() / HOST_TICK_US);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return self;
+}
+
+const char *pcTaskGetName(TaskHandle_t task)
+{
+    return task != NULL ? task->name : self->name;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks)
+{
+    struct host_task *t = self;
+
+    pthread_mutex_lock(&host_lock);
+    int64_t deadline = host_tick_deadline(ticks);
+    while (t->notify == 0 && ticks != 0) {
+        if (!host_block(&t->notify, deadline)) {
+            break;
+        }
+    }
+    uint32_t value = t->notify;
+    if (value != 0) {
+        t->notify = clear_on_exit ? 0 : value - 1;
+    }
+    pthread_mutex_unlock(&host_lock);
+    return value;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    pthread_mutex_lock(&host_lock);
+    task->notify++;
+    host_wake_all(&task->notify);
+    pthread_mutex_unlock(&host_lock);
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *woken)
+{
+    xTaskNotifyGive(task);
+    if (woken != NULL) {
+        *woken = pdTRUE;
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/* Queues and semaphores                                              */
+/* ------------------------------------------------------------------ */
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size)
+{
+    struct host_queue *q = calloc(1, sizeof(*q));
+
+    q->length = length;
+    q->item_size = item_size;
+    if (item_size != 0) {
+        q->buf = calloc(length, item_size);
+    }
+    return q;
+}
+
+void vQueueDelete(QueueHandle_t queue)
+{
+    free(queue->buf);
+    free(queue);
+}
+
+static BaseType_t host_queue_send(QueueHandle_t q, const void *item, TickType_t ticks, bool front)
+{
+    pthread_mutex_lock(&host_lock);
+    int64_t deadline = host_tick_deadline(ticks);
+    while (q->count == q->length) {
+        if (ticks == 0 || !host_block(&q->not_full, deadline)) {
+            pthread_mutex_unlock(&host_lock);
+            return errQUEUE_FULL;
+        }
+    }
+
+    UBaseType_t slot;
+    if (front) {
+        q->head = (q->head + q->length - 1) % q->length;
+        slot = q->head;
+    } else {
+        slot = (q->head + q->count) % q->length;
+    }
+    if (q->item_size != 0) {
+        memcpy(q->buf + slot * q->item_size, item, q->item_size);
+    }
+    q->count++;
+    host_wake_all(&q->not_empty);
+    pthread_mutex_unlock(&host_lock);
+    return pdPASS;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks)
+{
+    return host_queue_send(queue, item, ticks, false);
+}
+
+BaseType_t xQueueSendToFront(QueueHandle_t queue, const void *item, TickType_t ticks)
+{
+    return host_queue_send(queue, item, ticks, true);
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void *item, BaseType_t *woken)
+{
+    if (woken != NULL) {
+        *woken = pdFALSE;
+    }
+    return host_queue_send(queue, item, 0, false);
+}
+
+BaseType_t xQueueReceive(QueueHandle_t q, void *item, TickType_t ticks)
+{
+    pthread_mutex_lock(&host_lock);
+    int64_t deadline = host_tick_deadline(ticks);
+    while (q->count == 0) {
+        if (ticks == 0 || !host_block(&q->not_empty, deadline)) {
+            pthread_mutex_unlock(&host_lock);
+            return pdFALSE;
+        }
+    }
+
+    if (q->item_size != 0) {
+        memcpy(item, q->buf + q->head * q->item_size, q->item_size);
+    }
+    q->head = (q->head + 1) % q->length;
+    q->count--;
+    host_wake_all(&q->not_full);
+    pthread_mutex_unlock(&host_lock);
+    return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue)
+{
+    pthread_mutex_lock(&host_lock);
+    UBaseType_t n = queue->count;
+    pthread_mutex_unlock(&host_lock);
+    return n;
+}
+
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t queue)
+{
+    pthread_mutex_lock(&host_lock);
+    UBaseType_t n = queue->length - queue->count;
+    pthread_mutex_unlock(&host_lock);
+    return n;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    SemaphoreHandle_t sem = xQueueCreate(1, 0);
+
+    sem->count = 1;
+    return sem;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+    return xQueueCreate(1, 0);
+}
+
+/* ------------------------------------------------------------------ */
+/* Timer service task                                                 */
+/* ------------------------------------------------------------------ */
+
+typedef struct {
+    PendedFunction_t fn;
+    void *arg1;
+    uint32_t arg2;
+} host_pended_t;
+
+static QueueHandle_t timer_queue = NULL;
+static pthread_once_t timer_once = PTHREAD_ONCE_INIT;
+
+static void host_timer_task(void *arg)
+{
+    host_pended_t call;
+
+    for (;;) {
+        if (xQueueReceive(timer_queue, &call, portMAX_DELAY) == pdTRUE) {
+            call.fn(call.arg1, call.arg2);
+        }
+    }
+}
+
+static void host_timer_start(void)
+{
+    timer_queue = xQueueCreate(10, sizeof(host_pended_t));
+    host_task_start(host_timer_task, "Tmr Svc", NULL);
+}
+
+BaseType_t xTimerPendFunctionCall(PendedFunction_t fn, void *arg1, uint32_t arg2, TickType_t ticks)
+{
+    host_pended_t call = { .fn = fn, .arg1 = arg1, .arg2 = arg2 };
+
+    pthread_once(&timer_once, host_timer_start);
+    return xQueueSend(timer_queue, &call, ticks);
+}
+
+/* ------------------------------------------------------------------ */
+/* select()                                                           */
+/* ------------------------------------------------------------------ */
+
+// Zero-timeout select on copies of a waiter's sets
+static int host_select_now(int nfds, fd_set *r, fd_set *w, int timeout_ms)
+{
+    struct timeval tv = { .tv_sec = 0, .tv_usec = timeout_ms * 1000 };
+    int n;
+
+    do {
+        n = (select)(nfds, r, w, NULL, &tv);
+    } while (n < 0 && errno == EINTR);
+    return n;
+}
+
+static bool host_poll_selects(int timeout_ms)
+{
+    fd_set r, w;
+    int nfds = 0;
+    bool any = false;
+
+    FD_ZERO(&r);
+    FD_ZERO(&w);
+    for (struct host_task *t = tasks; t != NULL; t = t->next) {
+        if (!t->blocked || t->wait_obj != &select_obj) {
+            continue;
+        }
+        for (int fd = 0; fd < t->sel_nfds; fd++) {
+            if (t->sel_has_r && FD_ISSET(fd, &t->sel_r)) {
+                FD_SET(fd, &r);
+            }
+            if (t->sel_has_w && FD_ISSET(fd, &t->sel_w)) {
+                FD_SET(fd, &w);
+            }
+        }
+        if (t->sel_nfds > nfds) {
+            nfds = t->sel_nfds;
+        }
+        any = true;
+    }
+    if (!any || host_select_now(nfds, &r, &w, timeout_ms) <= 0) {
+        return false;
+    }
+
+    bool woke = false;
+    for (struct host_task *t = tasks; t != NULL; t = t->next) {
+        if (!t->blocked || t->wait_obj != &select_obj) {
+            continue;
+        }
+        for (int fd = 0; fd < t->sel_nfds; fd++) {
+            if ((t->sel_has_r && FD_ISSET(fd, &t->sel_r) && FD_ISSET(fd, &r)) ||
+                (t->sel_has_w && FD_ISSET(fd, &t->sel_w) && FD_ISSET(fd, &w))) {
+                host_wake(t);
+                woke = true;
+                break;
+            }
+        }
+    }
+    return woke;
+}
+
+int host_select(int nfds, fd_set *readfds, fd_set *writefds, fd_set *exceptfds, struct timeval *timeout)
+{
+    struct host_task *t = self;
+    fd_set r, w;
+
+    pthread_mutex_lock(&host_lock);
+    int64_t deadline = timeout == NULL ? HOST_FOREVER :
+                       now_us + (int64_t)timeout->tv_sec * 1000000 + timeout->tv_usec;
+    t->sel_nfds = nfds;
+    t->sel_has_r = readfds != NULL;
+    t->sel_has_w = writefds != NULL;
+    FD_ZERO(&t->sel_r);
+    FD_ZERO(&t->sel_w);
+    if (readfds != NULL) {
+        t->sel_r = *readfds;
+    }
+    if (writefds != NULL) {
+        t->sel_w = *writefds;
+    }
+
+    int n;
+    for (;;) {
+        r = t->sel_r;
+        w = t->sel_w;
+        n = host_select_now(nfds, readfds ? &r : NULL, writefds ? &w : NULL, 0);
+        if (n != 0 || (deadline != HOST_FOREVER && now_us >= deadline)) {
+            break;
+        }
+        host_block(&select_obj, deadline);
+    }
+    pthread_mutex_unlock(&host_lock);
+
+    if (n >= 0) {
+        if (readfds != NULL) {
+            *readfds = r;
+        }
+        if (writefds != NULL) {
+            *writefds = w;
+        }
+        if (exceptfds != NULL) {
+            FD_ZERO(exceptfds);
+        }
+    }
+    return n;
+}
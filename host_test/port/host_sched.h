@@ -0,0 +1,43 @@
+/*
+ * host_sched.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ *
+ * Scheduler internals shared by the port files. Everything here is
+ * called with host_lock held.
+ */
+
+#ifndef HOST_SCHED_H_
+#define HOST_SCHED_H_
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define HOST_FOREVER    (-1)
+
+extern pthread_mutex_t host_lock;
+
+/**
+ * @brief Block the calling task on obj until woken or the virtual clock reaches deadline.
+ * @return false on timeout.
+ */
+bool host_block(const void *obj, int64_t deadline);
+
+/**
+ * @brief Make every task blocked on obj runnable.
+ */
+void host_wake_all(const void *obj);
+
+/**
+ * @brief Deadline of a FreeRTOS timeout, on the next tick boundaries like the tick interrupt.
+ */
+int64_t host_tick_deadline(uint32_t ticks);
+
+/**
+ * @brief Start a thread as a task; it counts as runnable until it blocks.
+ */
+struct host_task *host_task_start(void (*fn)(void *), const char *name, void *arg);
+
+#endif /* HOST_SCHED_H_ */
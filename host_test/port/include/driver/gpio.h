@@ -0,0 +1,17 @@
+/*
+ * gpio.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ *
+ * Pins are simulated by hal_io_host.c; nothing here is called.
+ */
+
+#ifndef HOST_DRIVER_GPIO_H_
+#define HOST_DRIVER_GPIO_H_
+
+#include "esp_err.h"
+
+typedef int gpio_num_t;
+
+#endif /* HOST_DRIVER_GPIO_H_ */
@@ -0,0 +1,15 @@
+/*
+ * esp_attr.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ */
+
+#ifndef HOST_ESP_ATTR_H_
+#define HOST_ESP_ATTR_H_
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define RTC_NOINIT_ATTR
+
+#endif /* HOST_ESP_ATTR_H_ */
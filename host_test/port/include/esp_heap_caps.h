@@ -0,0 +1,24 @@
+/*
+ * esp_heap_caps.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ *
+ * The host heap has no capabilities; sizes are reported as zero.
+ */
+
+#ifndef HOST_ESP_HEAP_CAPS_H_
+#define HOST_ESP_HEAP_CAPS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define MALLOC_CAP_INTERNAL     (1 << 11)
+#define MALLOC_CAP_8BIT         (1 << 2)
+#define MALLOC_CAP_DEFAULT      (1 << 12)
+
+size_t heap_caps_get_free_size(uint32_t caps);
+size_t heap_caps_get_minimum_free_size(uint32_t caps);
+size_t heap_caps_get_largest_free_block(uint32_t caps);
+
+#endif /* HOST_ESP_HEAP_CAPS_H_ */
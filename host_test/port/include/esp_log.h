@@ -0,0 +1,48 @@
+/*
+ * esp_log.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ *
+ * Log output to stdout. The level of every tag is the global level,
+ * taken from the HOST_LOG_LEVEL environment variable (0..5, default 2).
+ */
+
+#ifndef HOST_ESP_LOG_H_
+#define HOST_ESP_LOG_H_
+
+#include <stdint.h>
+#include <inttypes.h>
+#include "sdkconfig.h"
+
+typedef enum {
+    ESP_LOG_NONE = 0,
+    ESP_LOG_ERROR,
+    ESP_LOG_WARN,
+    ESP_LOG_INFO,
+    ESP_LOG_DEBUG,
+    ESP_LOG_VERBOSE,
+} esp_log_level_t;
+
+esp_log_level_t esp_log_level_get(const char *tag);
+void esp_log_level_set(const char *tag, esp_log_level_t level);
+uint32_t esp_log_timestamp(void);
+void esp_log_write(esp_log_level_t level, const char *tag, const char *format, ...)
+    __attribute__((format(printf, 3, 4)));
+
+#define LOG_FORMAT(letter, format)  #letter " (%" PRIu32 ") %s: " format "\n"
+
+#define ESP_LOG_LEVEL_LOCAL(level, letter, tag, format, ...) do {                  \
+        if (CONFIG_LOG_MAXIMUM_LEVEL >= (level) && esp_log_level_get(tag) >= (level)) { \
+            esp_log_write(level, tag, LOG_FORMAT(letter, format),                   \
+                          esp_log_timestamp(), tag, ##__VA_ARGS__);                 \
+        }                                                                           \
+    } while (0)
+
+#define ESP_LOGE(tag, format, ...)  ESP_LOG_LEVEL_LOCAL(ESP_LOG_ERROR, E, tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...)  ESP_LOG_LEVEL_LOCAL(ESP_LOG_WARN, W, tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...)  ESP_LOG_LEVEL_LOCAL(ESP_LOG_INFO, I, tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...)  ESP_LOG_LEVEL_LOCAL(ESP_LOG_DEBUG, D, tag, format, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...)  ESP_LOG_LEVEL_LOCAL(ESP_LOG_VERBOSE, V, tag, format, ##__VA_ARGS__)
+
+#endif /* HOST_ESP_LOG_H_ */
@@ -0,0 +1,40 @@
+/*
+ * esp_partition.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ *
+ * One data partition in RAM with NOR flash semantics: erase sets bytes
+ * to 0xFF, writes can only clear bits. Created with host_flash_init().
+ */
+
+#ifndef HOST_ESP_PARTITION_H_
+#define HOST_ESP_PARTITION_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+typedef enum {
+    ESP_PARTITION_TYPE_APP = 0x00,
+    ESP_PARTITION_TYPE_DATA = 0x01,
+} esp_partition_type_t;
+
+typedef int esp_partition_subtype_t;
+
+typedef struct {
+    esp_partition_type_t type;
+    esp_partition_subtype_t subtype;
+    uint32_t address;
+    uint32_t size;
+    uint32_t erase_size;
+    char label[17];
+} esp_partition_t;
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+                                                const char *label);
+esp_err_t esp_partition_read(const esp_partition_t *part, size_t offset, void *dst, size_t size);
+esp_err_t esp_partition_write(const esp_partition_t *part, size_t offset, const void *src, size_t size);
+esp_err_t esp_partition_erase_range(const esp_partition_t *part, size_t offset, size_t size);
+
+#endif /* HOST_ESP_PARTITION_H_ */
@@ -0,0 +1,23 @@
+/*
+ * esp_system.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ */
+
+#ifndef HOST_ESP_SYSTEM_H_
+#define HOST_ESP_SYSTEM_H_
+
+#include "esp_err.h"
+
+typedef enum {
+    ESP_RST_UNKNOWN,
+    ESP_RST_POWERON,
+    ESP_RST_EXT,
+    ESP_RST_SW,
+    ESP_RST_PANIC,
+} esp_reset_reason_t;
+
+esp_reset_reason_t esp_reset_reason(void);
+
+#endif /* HOST_ESP_SYSTEM_H_ */
@@ -0,0 +1,66 @@
+/*
+ * FreeRTOS.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ *
+ * FreeRTOS on POSIX threads for the host build. Tasks are threads;
+ * time is virtual and only advances when every task is blocked, see
+ * host_port.h. Priorities and core affinity are ignored.
+ */
+
+#ifndef HOST_FREERTOS_H_
+#define HOST_FREERTOS_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <assert.h>
+#include "sdkconfig.h"
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+typedef uint32_t StackType_t;
+
+#define pdFALSE                     ((BaseType_t)0)
+#define pdTRUE                      ((BaseType_t)1)
+#define pdPASS                      pdTRUE
+#define pdFAIL                      pdFALSE
+#define errQUEUE_FULL               ((BaseType_t)0)
+
+#define portMAX_DELAY               ((TickType_t)0xffffffffUL)
+#define configTICK_RATE_HZ          CONFIG_FREERTOS_HZ
+#define portTICK_PERIOD_MS          ((TickType_t)1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(ms)           ((TickType_t)(((uint64_t)(ms) * configTICK_RATE_HZ) / 1000U))
+#define pdTICKS_TO_MS(ticks)        ((TickType_t)(((uint64_t)(ticks) * 1000U) / configTICK_RATE_HZ))
+
+#define configASSERT(x)             assert(x)
+#define configUSE_TRACE_FACILITY    0
+#define configGENERATE_RUN_TIME_STATS 0
+#define configTASKLIST_INCLUDE_COREID 0
+#define configRUN_TIME_COUNTER_TYPE uint32_t
+#define tskNO_AFFINITY              ((BaseType_t)0x7FFFFFFF)
+
+// One recursive lock stands in for every spinlock
+typedef struct {
+    int unused;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED    { 0 }
+
+void host_enter_critical(void);
+void host_exit_critical(void);
+
+#define portENTER_CRITICAL(mux)         do { (void)(mux); host_enter_critical(); } while (0)
+#define portEXIT_CRITICAL(mux)          do { (void)(mux); host_exit_critical(); } while (0)
+#define portENTER_CRITICAL_ISR(mux)     portENTER_CRITICAL(mux)
+#define portEXIT_CRITICAL_ISR(mux)      portEXIT_CRITICAL(mux)
+#define taskENTER_CRITICAL(mux)         portENTER_CRITICAL(mux)
+#define taskEXIT_CRITICAL(mux)          portEXIT_CRITICAL(mux)
+#define portYIELD_FROM_ISR(...)         ((void)0)
+
+typedef struct host_task *TaskHandle_t;
+typedef struct host_queue *QueueHandle_t;
+typedef void (*TaskFunction_t)(void *arg);
+
+#endif /* HOST_FREERTOS_H_ */
@@ -0,0 +1,24 @@
+/*
+ * semphr.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ *
+ * Semaphores are queues of zero-sized items, without priority inheritance.
+ */
+
+#ifndef HOST_FREERTOS_SEMPHR_H_
+#define HOST_FREERTOS_SEMPHR_H_
+
+#include "freertos/queue.h"
+
+typedef QueueHandle_t SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+SemaphoreHandle_t xSemaphoreCreateBinary(void);
+
+#define xSemaphoreTake(sem, ticks)      xQueueReceive(sem, NULL, ticks)
+#define xSemaphoreGive(sem)             xQueueSend(sem, NULL, 0)
+#define vSemaphoreDelete(sem)           vQueueDelete(sem)
+
+#endif /* HOST_FREERTOS_SEMPHR_H_ */
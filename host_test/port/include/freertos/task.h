@@ -0,0 +1,30 @@
+/*
+ * task.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ */
+
+#ifndef HOST_FREERTOS_TASK_H_
+#define HOST_FREERTOS_TASK_H_
+
+#include "freertos/FreeRTOS.h"
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack_depth,
+                                   void *arg, UBaseType_t priority, TaskHandle_t *created,
+                                   BaseType_t core_id);
+
+#define xTaskCreate(fn, name, stack, arg, prio, created) \
+    xTaskCreatePinnedToCore(fn, name, stack, arg, prio, created, tskNO_AFFINITY)
+
+void vTaskDelete(TaskHandle_t task);
+void vTaskDelay(TickType_t ticks);
+TickType_t xTaskGetTickCount(void);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+const char *pcTaskGetName(TaskHandle_t task);
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks);
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *woken);
+
+#endif /* HOST_FREERTOS_TASK_H_ */
@@ -0,0 +1,19 @@
+/*
+ * timers.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ *
+ * Only the deferred function calls of the timer service task.
+ */
+
+#ifndef HOST_FREERTOS_TIMERS_H_
+#define HOST_FREERTOS_TIMERS_H_
+
+#include "freertos/FreeRTOS.h"
+
+typedef void (*PendedFunction_t)(void *arg1, uint32_t arg2);
+
+BaseType_t xTimerPendFunctionCall(PendedFunction_t fn, void *arg1, uint32_t arg2, TickType_t ticks);
+
+#endif /* HOST_FREERTOS_TIMERS_H_ */
@@ -0,0 +1,82 @@
+/*
+ * host_port.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ *
+ * Control of the host port from tests and the simulator.
+ *
+ * Time is virtual: esp_timer_get_time() and the tick count only move
+ * when every task is blocked in a port primitive (queue, notification,
+ * delay, select, esp_timer), and then jump to the earliest deadline.
+ * Computation takes no virtual time, so measured latencies contain the
+ * waiting the code does (debounce, polling, queueing), not CPU time.
+ * Threads that take part must be created with xTaskCreatePinnedToCore()
+ * and must not block outside the port, or the clock stops.
+ */
+
+#ifndef HOST_PORT_H_
+#define HOST_PORT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Register the calling thread as a task; call first in main().
+ */
+void host_port_init(void);
+
+/**
+ * @brief Virtual time in microseconds, the same clock as esp_timer_get_time().
+ */
+int64_t host_now_us(void);
+
+/**
+ * @brief Block the calling task until the virtual clock reaches t_us.
+ */
+void host_sleep_until(int64_t t_us);
+
+void host_sleep_us(int64_t us);
+
+/**
+ * @brief Let every other task run until it blocks, without moving the
+ * clock: work due at the current time (timer callbacks woken together
+ * with the caller) is done when this returns.
+ */
+void host_settle(void);
+
+/**
+ * @brief Monotonic wall clock in microseconds, for benchmarks.
+ */
+int64_t host_wall_us(void);
+
+/**
+ * @brief Create the "evlog" data partition, erased, size bytes.
+ */
+void host_flash_init(size_t size);
+
+/**
+ * @brief Raw flash contents, for corrupting records in tests.
+ */
+uint8_t *host_flash_data(void);
+
+/**
+ * @brief Stop flash writes after this many more bytes, simulating power loss; -1 disables.
+ */
+void host_flash_fail_after(int32_t bytes);
+
+/**
+ * @brief Belt position source for the PCNT unit, in encoder counts at a virtual time.
+ */
+typedef int (*host_pcnt_source_t)(int64_t t_us, void *ctx);
+
+void host_pcnt_set_source(host_pcnt_source_t fn, void *ctx);
+
+/**
+ * @brief Load cell source for the continuous ADC, 12-bit raw value at a virtual time.
+ */
+typedef uint16_t (*host_adc_source_t)(int64_t t_us, void *ctx);
+
+void host_adc_set_source(host_adc_source_t fn, void *ctx);
+
+#endif /* HOST_PORT_H_ */
@@ -0,0 +1,13 @@
+/*
+ * netdb.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ */
+
+#ifndef HOST_LWIP_NETDB_H_
+#define HOST_LWIP_NETDB_H_
+
+#include <netdb.h>
+
+#endif /* HOST_LWIP_NETDB_H_ */
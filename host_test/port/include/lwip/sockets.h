@@ -0,0 +1,29 @@
+/*
+ * sockets.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ *
+ * BSD sockets of the host. select() goes through the scheduler so a
+ * task waiting for a socket lets the virtual clock run.
+ */
+
+#ifndef HOST_LWIP_SOCKETS_H_
+#define HOST_LWIP_SOCKETS_H_
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+int host_select(int nfds, fd_set *readfds, fd_set *writefds, fd_set *exceptfds, struct timeval *timeout);
+
+#define select(nfds, readfds, writefds, exceptfds, timeout) \
+    host_select(nfds, readfds, writefds, exceptfds, timeout)
+
+#endif /* HOST_LWIP_SOCKETS_H_ */
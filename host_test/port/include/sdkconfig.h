@@ -0,0 +1,21 @@
+/*
+ * sdkconfig.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ *
+ * Host build configuration: the options of ../../../sdkconfig the main
+ * component reads, for the linux target.
+ */
+
+#ifndef HOST_SDKCONFIG_H_
+#define HOST_SDKCONFIG_H_
+
+#define CONFIG_IDF_TARGET_LINUX             1
+#define CONFIG_IDF_TARGET                   "linux"
+#define CONFIG_FREERTOS_HZ                  100
+#define CONFIG_LOG_MAXIMUM_LEVEL            3
+#define CONFIG_LOG_DEFAULT_LEVEL            3
+#define CONFIG_LWIP_MAX_SOCKETS             10
+
+#endif /* HOST_SDKCONFIG_H_ */
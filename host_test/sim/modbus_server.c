@@ -0,0 +1,390 @@
+/*
+ * modbus_server.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ */
+
+#include "modbus_server.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "lwip/sockets.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MODBUS_SERVER_IDLE_MS   100
+#define MODBUS_SERVER_RX_MAX    300
+#define MODBUS_SERVER_TX_MAX    260
+
+#define EXC_ILLEGAL_FUNCTION    0x01
+#define EXC_ILLEGAL_ADDRESS     0x02
+#define EXC_ILLEGAL_VALUE       0x03
+
+typedef struct {
+    int      fd;
+    uint8_t  rx[MODBUS_SERVER_RX_MAX];
+    uint16_t rx_len;
+} server_client_t;
+
+typedef struct {
+    bool     used;
+    int      fd;
+    int64_t  due_us;
+    uint32_t order;             // arrival, for reordering answers due together
+    uint16_t len;
+    uint8_t  frame[MODBUS_SERVER_TX_MAX];
+} held_answer_t;
+
+struct modbus_server {
+    int              listen_fd;
+    uint8_t          unit_id;
+    pthread_mutex_t  lock;
+    uint16_t         regs[MODBUS_SERVER_REGS];
+    uint32_t         delay_ms;
+    bool             reverse;
+    uint32_t         drop;
+    uint32_t         requests;
+    uint32_t         connections;
+    uint32_t         arrivals;
+    server_client_t  clients[MODBUS_SERVER_MAX_CLIENTS];
+    held_answer_t    held[MODBUS_SERVER_MAX_HELD];
+};
+
+static void server_put16(uint8_t *p, uint16_t v)
+{
+    p[0] = v >> 8;
+    p[1] = v & 0xFF;
+}
+
+static uint16_t server_get16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] << 8 | p[1]);
+}
+
+static uint16_t server_exception(const uint8_t *req, uint8_t code, uint8_t *out)
+{
+    out[7] = req[7] | 0x80;
+    out[8] = code;
+    return 9;
+}
+
+/*
+ * Build the answer to one complete request frame; the MBAP header is
+ * copied and its length set. Called with the lock held.
+ */
+static uint16_t server_execute(modbus_server_t *s, const uint8_t *req, uint16_t len, uint8_t *out)
+{
+    uint8_t fc = req[7];
+    uint16_t n;
+
+    memcpy(out, req, 7);
+    out[7] = fc;
+
+    if (fc == 0x03 && len >= 12) {
+        uint16_t addr = server_get16(&req[8]);
+        uint16_t count = server_get16(&req[10]);
+        if (count == 0 || count > 125) {
+            n = server_exception(req, EXC_ILLEGAL_VALUE, out);
+        } else if ((uint32_t)addr + count > MODBUS_SERVER_REGS) {
+            n = server_exception(req, EXC_ILLEGAL_ADDRESS, out);
+        } else {
+            out[8] = (uint8_t)(count * 2);
+            for (uint16_t i = 0; i < count; i++) {
+                server_put16(&out[9 + 2 * i], s->regs[addr + i]);
+            }
+            n = (uint16_t)(9 + count * 2);
+        }
+    } else if (fc == 0x06 && len >= 12) {
+        uint16_t addr = server_get16(&req[8]);
+        if (addr >= MODBUS_SERVER_REGS) {
+            n = server_exception(req, EXC_ILLEGAL_ADDRESS, out);
+        } else {
+            s->regs[addr] = server_get16(&req[10]);
+            memcpy(&out[8], &req[8], 4);
+            n = 12;
+        }
+    } else if (fc == 0x10 && len >= 13) {
+        uint16_t addr = server_get16(&req[8]);
+        uint16_t count = server_get16(&req[10]);
+        if (count == 0 || count > 123 || req[12] != count * 2 || len < 13 + count * 2) {
+            n = server_exception(req, EXC_ILLEGAL_VALUE, out);
+        } else if ((uint32_t)addr + count > MODBUS_SERVER_REGS) {
+            n = server_exception(req, EXC_ILLEGAL_ADDRESS, out);
+        } else {
+            for (uint16_t i = 0; i < count; i++) {
+                s->regs[addr + i] = server_get16(&req[13 + 2 * i]);
+            }
+            memcpy(&out[8], &req[8], 4);
+            n = 12;
+        }
+    } else {
+        n = server_exception(req, EXC_ILLEGAL_FUNCTION, out);
+    }
+
+    server_put16(&out[4], (uint16_t)(n - 6));
+    return n;
+}
+
+static void server_close(modbus_server_t *s, server_client_t *c)
+{
+    for (int i = 0; i < MODBUS_SERVER_MAX_HELD; i++) {
+        if (s->held[i].used && s->held[i].fd == c->fd) {
+            s->held[i].used = false;
+        }
+    }
+    close(c->fd);
+    c->fd = -1;
+    c->rx_len = 0;
+}
+
+static void server_hold(modbus_server_t *s, int fd, const uint8_t *frame, uint16_t len)
+{
+    for (int i = 0; i < MODBUS_SERVER_MAX_HELD; i++) {
+        held_answer_t *h = &s->held[i];
+        if (!h->used) {
+            h->used = true;
+            h->fd = fd;
+            h->due_us = esp_timer_get_time() + (int64_t)s->delay_ms * 1000;
+            h->order = s->arrivals++;
+            h->len = len;
+            memcpy(h->frame, frame, len);
+            return;
+        }
+    }
+}
+
+static void server_receive(modbus_server_t *s, server_client_t *c)
+{
+    int n = recv(c->fd, c->rx + c->rx_len, sizeof(c->rx) - c->rx_len, 0);
+
+    if (n <= 0) {
+        if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+            server_close(s, c);
+        }
+        return;
+    }
+    c->rx_len += n;
+
+    while (c->rx_len >= 8) {
+        uint16_t total = 6 + server_get16(&c->rx[4]);
+        if (total < 8 || total > sizeof(c->rx)) {
+            server_close(s, c);
+            return;
+        }
+        if (c->rx_len < total) {
+            break;
+        }
+
+        s->requests++;
+        if (s->drop > 0) {
+            s->drop--;
+        } else if (c->rx[6] == s->unit_id) {
+            uint8_t out[MODBUS_SERVER_TX_MAX];
+            uint16_t len = server_execute(s, c->rx, total, out);
+            server_hold(s, c->fd, out, len);
+        }
+        memmove(c->rx, c->rx + total, c->rx_len - total);
+        c->rx_len -= total;
+    }
+}
+
+// Send the answers that are due, oldest first or newest first
+static int64_t server_send_due(modbus_server_t *s)
+{
+    int64_t now = esp_timer_get_time();
+
+    for (;;) {
+        held_answer_t *pick = NULL;
+        for (int i = 0; i < MODBUS_SERVER_MAX_HELD; i++) {
+            held_answer_t *h = &s->held[i];
+            if (!h->used || h->due_us > now) {
+                continue;
+            }
+            if (pick == NULL || (s->reverse ? h->order > pick->order : h->order < pick->order)) {
+                pick = h;
+            }
+        }
+        if (pick == NULL) {
+            break;
+        }
+        send(pick->fd, pick->frame, pick->len, 0);
+        pick->used = false;
+    }
+
+    int64_t next = now + MODBUS_SERVER_IDLE_MS * 1000;
+    for (int i = 0; i < MODBUS_SERVER_MAX_HELD; i++) {
+        if (s->held[i].used && s->held[i].due_us < next) {
+            next = s->held[i].due_us;
+        }
+    }
+    return next;
+}
+
+static void server_accept(modbus_server_t *s)
+{
+    int fd = accept(s->listen_fd, NULL, NULL);
+
+    if (fd < 0) {
+        return;
+    }
+    for (int i = 0; i < MODBUS_SERVER_MAX_CLIENTS; i++) {
+        server_client_t *c = &s->clients[i];
+        if (c->fd < 0) {
+            int one = 1;
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            c->fd = fd;
+            c->rx_len = 0;
+            s->connections++;
+            return;
+        }
+    }
+    close(fd);
+}
+
+static void modbus_server_task(void *arg)
+{
+    modbus_server_t *s = arg;
+    int64_t next = esp_timer_get_time();
+
+    for (;;) {
+        fd_set rfds;
+        int maxfd = s->listen_fd;
+
+        FD_ZERO(&rfds);
+        FD_SET(s->listen_fd, &rfds);
+        pthread_mutex_lock(&s->lock);
+        for (int i = 0; i < MODBUS_SERVER_MAX_CLIENTS; i++) {
+            if (s->clients[i].fd >= 0) {
+                FD_SET(s->clients[i].fd, &rfds);
+                if (s->clients[i].fd > maxfd) {
+                    maxfd = s->clients[i].fd;
+                }
+            }
+        }
+        pthread_mutex_unlock(&s->lock);
+
+        int64_t wait_us = next - esp_timer_get_time();
+        struct timeval tv = {
+            .tv_sec = wait_us > 0 ? wait_us / 1000000 : 0,
+            .tv_usec = wait_us > 0 ? wait_us % 1000000 : 0,
+        };
+        int ready = select(maxfd + 1, &rfds, NULL, NULL, &tv);
+
+        pthread_mutex_lock(&s->lock);
+        if (ready > 0) {
+            if (FD_ISSET(s->listen_fd, &rfds)) {
+                server_accept(s);
+            }
+            for (int i = 0; i < MODBUS_SERVER_MAX_CLIENTS; i++) {
+                server_client_t *c = &s->clients[i];
+                if (c->fd >= 0 && FD_ISSET(c->fd, &rfds)) {
+                    server_receive(s, c);
+                }
+            }
+        }
+        next = server_send_due(s);
+        pthread_mutex_unlock(&s->lock);
+    }
+}
+
+modbus_server_t *modbus_server_start(uint16_t port, uint8_t unit_id)
+{
+    modbus_server_t *s = calloc(1, sizeof(*s));
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(port),
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    int one = 1;
+
+    s->unit_id = unit_id;
+    pthread_mutex_init(&s->lock, NULL);
+    for (int i = 0; i < MODBUS_SERVER_MAX_CLIENTS; i++) {
+        s->clients[i].fd = -1;
+    }
+
+    s->listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    setsockopt(s->listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (bind(s->listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(s->listen_fd, 4) != 0) {
+        close(s->listen_fd);
+        free(s);
+        return NULL;
+    }
+    fcntl(s->listen_fd, F_SETFL, fcntl(s->listen_fd, F_GETFL, 0) | O_NONBLOCK);
+
+    xTaskCreatePinnedToCore(modbus_server_task, "modbus_server", 4096, s, 5, NULL, tskNO_AFFINITY);
+    return s;
+}
+
+uint16_t modbus_server_get_reg(modbus_server_t *s, uint16_t addr)
+{
+    pthread_mutex_lock(&s->lock);
+    uint16_t v = addr < MODBUS_SERVER_REGS ? s->regs[addr] : 0;
+    pthread_mutex_unlock(&s->lock);
+    return v;
+}
+
+void modbus_server_set_reg(modbus_server_t *s, uint16_t addr, uint16_t value)
+{
+    pthread_mutex_lock(&s->lock);
+    if (addr < MODBUS_SERVER_REGS) {
+        s->regs[addr] = value;
+    }
+    pthread_mutex_unlock(&s->lock);
+}
+
+void modbus_server_set_delay_ms(modbus_server_t *s, uint32_t ms)
+{
+    pthread_mutex_lock(&s->lock);
+    s->delay_ms = ms;
+    pthread_mutex_unlock(&s->lock);
+}
+
+void modbus_server_set_reverse(modbus_server_t *s, bool reverse)
+{
+    pthread_mutex_lock(&s->lock);
+    s->reverse = reverse;
+    pthread_mutex_unlock(&s->lock);
+}
+
+void modbus_server_drop_next(modbus_server_t *s, uint32_t n)
+{
+    pthread_mutex_lock(&s->lock);
+    s->drop = n;
+    pthread_mutex_unlock(&s->lock);
+}
+
+void modbus_server_disconnect_all(modbus_server_t *s)
+{
+    pthread_mutex_lock(&s->lock);
+    for (int i = 0; i < MODBUS_SERVER_MAX_CLIENTS; i++) {
+        if (s->clients[i].fd >= 0) {
+            // Wakes the server task with an end of file, which then closes the socket
+            shutdown(s->clients[i].fd, SHUT_RDWR);
+        }
+    }
+    for (int i = 0; i < MODBUS_SERVER_MAX_HELD; i++) {
+        s->held[i].used = false;
+    }
+    pthread_mutex_unlock(&s->lock);
+}
+
+uint32_t modbus_server_requests(modbus_server_t *s)
+{
+    pthread_mutex_lock(&s->lock);
+    uint32_t n = s->requests;
+    pthread_mutex_unlock(&s->lock);
+    return n;
+}
+
+uint32_t modbus_server_connections(modbus_server_t *s)
+{
+    pthread_mutex_lock(&s->lock);
+    uint32_t n = s->connections;
+    pthread_mutex_unlock(&s->lock);
+    return n;
+}
@@ -0,0 +1,59 @@
+/*
+ * modbus_server.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ *
+ * Stand-in Modbus TCP server for the host build: a holding register
+ * table served on 127.0.0.1 by its own task, with functions 0x03, 0x06
+ * and 0x10. Answers can be delayed, reordered or dropped and
+ * connections cut, to exercise the client's matching and recovery.
+ */
+
+#ifndef SIM_MODBUS_SERVER_H_
+#define SIM_MODBUS_SERVER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define MODBUS_SERVER_REGS          0x2100      // registers 0..0x20FF, covers the Delta control block
+#define MODBUS_SERVER_MAX_CLIENTS   4
+#define MODBUS_SERVER_MAX_HELD      32          // answers waiting for their delay
+
+typedef struct modbus_server modbus_server_t;
+
+/**
+ * @brief Listen on 127.0.0.1:port and start the server task.
+ * @return NULL if the port cannot be bound.
+ */
+modbus_server_t *modbus_server_start(uint16_t port, uint8_t unit_id);
+
+uint16_t modbus_server_get_reg(modbus_server_t *s, uint16_t addr);
+
+void modbus_server_set_reg(modbus_server_t *s, uint16_t addr, uint16_t value);
+
+/**
+ * @brief Delay every answer by ms of virtual time.
+ */
+void modbus_server_set_delay_ms(modbus_server_t *s, uint32_t ms);
+
+/**
+ * @brief Answer requests that are due together newest first.
+ */
+void modbus_server_set_reverse(modbus_server_t *s, bool reverse);
+
+/**
+ * @brief Swallow the next n requests without answering them.
+ */
+void modbus_server_drop_next(modbus_server_t *s, uint32_t n);
+
+/**
+ * @brief Close every client connection; unsent answers are lost.
+ */
+void modbus_server_disconnect_all(modbus_server_t *s);
+
+uint32_t modbus_server_requests(modbus_server_t *s);
+
+uint32_t modbus_server_connections(modbus_server_t *s);
+
+#endif /* SIM_MODBUS_SERVER_H_ */
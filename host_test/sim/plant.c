@@ -0,0 +1,322 @@
+/*
+ * plant.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ */
+
+#include "plant.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "hal_io.h"
+#include "logic.h"
+#include "conveyor.h"
+#include "host_port.h"
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PLANT_STEP_US           1000
+#define PLANT_SPAWN_MM          10          // released just before T1
+#define PLANT_WRAP_DONE_MS      500         // length of the WRAP_DONE pulse
+#define PLANT_NONE              UINT32_MAX
+
+#define UM(mm)                  ((int64_t)(mm) * 1000)
+#define CH(ch)                  (1u << (ch))
+
+typedef struct {
+    uint32_t cube;
+    int64_t  front_um;
+} belt_slot_t;
+
+static plant_config_t cfg;
+static modbus_server_t *inverter;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static plant_cube_t *cubes;
+static uint32_t next_release = 0;       // first cube still in the infeed
+static belt_slot_t belt[PLANT_BELT_MAX_CUBES];     // oldest first
+static int belt_len = 0;
+static int64_t step_belt_um = 0;        // belt travel at the last step
+static uint32_t gripped = PLANT_NONE;
+static uint32_t levels = 0;
+static int64_t wrap_end_us = -1;
+static int64_t wrap_done_off_us = -1;
+static plant_stats_t stats;
+static uint32_t noise_rng;              // load cell noise, adc_task only
+static bool hold_during_wrap = false;
+static bool held = false;               // STOP sent for the running wrap
+static int hold_cmd = -1;               // HMI command to post after the step
+
+static uint32_t plant_rand(uint32_t *state)
+{
+    // xorshift32: the same scenario for the same seed on every host
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+// Uniform in (0, 1]
+static double plant_uniform(uint32_t *state)
+{
+    return (plant_rand(state) + 1.0) / 4294967296.0;
+}
+
+static double plant_gauss(uint32_t *state)
+{
+    double u1 = plant_uniform(state);
+    double u2 = plant_uniform(state);
+
+    return sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+
+static int64_t plant_belt_um(int64_t t_us)
+{
+    return t_us * cfg.belt_mm_s / 1000;
+}
+
+static int plant_encoder(int64_t t_us, void *ctx)
+{
+    return (int)(plant_belt_um(t_us) * CONVEYOR_COUNTS_PER_M / 1000000);
+}
+
+/*
+ * Load on the platform at t_us: each cube weighs in with the share of
+ * its length that is on the platform. Positions are taken from the last
+ * step and moved on with the belt, as nothing on the scale is held back.
+ */
+static uint16_t plant_load_cell(int64_t t_us, void *ctx)
+{
+    double load_g = 0;
+
+    pthread_mutex_lock(&lock);
+    int64_t moved = plant_belt_um(t_us) - step_belt_um;
+    for (int i = 0; i < belt_len; i++) {
+        int64_t front = belt[i].front_um + moved;
+        int64_t on = (front < UM(PLANT_PLATFORM_MM) ? front : UM(PLANT_PLATFORM_MM)) -
+                     (front - UM(PLANT_CUBE_MM) > 0 ? front - UM(PLANT_CUBE_MM) : 0);
+        if (on > 0) {
+            load_g += (double)cubes[belt[i].cube].weight_g * on / UM(PLANT_CUBE_MM);
+        }
+    }
+    pthread_mutex_unlock(&lock);
+
+    load_g += plant_gauss(&noise_rng) * cfg.noise_g;
+    // 12-bit ADC over ADC_FULL_SCALE_KG
+    long raw = lround(load_g * 4095 / 100000);
+    return (uint16_t)(raw < 0 ? 0 : raw > 4095 ? 4095 : raw);
+}
+
+static bool plant_covers(int64_t front_um, int32_t at_mm)
+{
+    return front_um >= UM(at_mm) && front_um - UM(PLANT_CUBE_MM) < UM(at_mm);
+}
+
+static void plant_remove(int i)
+{
+    memmove(&belt[i], &belt[i + 1], (size_t)(belt_len - i - 1) * sizeof(belt[0]));
+    belt_len--;
+}
+
+// Belt, ejector, infeed and wrapper for one step; called with the lock held
+static void plant_step(int64_t now)
+{
+    int64_t belt_now = plant_belt_um(now);
+    int64_t moved = belt_now - step_belt_um;
+    int64_t limit = UM(PLANT_END_STOP_MM);
+
+    step_belt_um = belt_now;
+
+    // The belt slides under cubes held by the end stop or by the cube in front
+    for (int i = 0; i < belt_len; i++) {
+        belt_slot_t *b = &belt[i];
+        b->front_um = b->front_um + moved < limit ? b->front_um + moved : limit;
+        limit = b->front_um - UM(PLANT_CUBE_MM);
+        if (cubes[b->cube].t3_us == 0 && plant_covers(b->front_um, PLANT_T3_MM)) {
+            cubes[b->cube].t3_us = now;
+        }
+    }
+
+    // The extended paddle pushes off whatever it touches
+    if (hal_io_read_outputs() & IO_OUT_BIT(IO_OUT_EJECTOR)) {
+        for (int i = belt_len - 1; i >= 0; i--) {
+            int64_t front = belt[i].front_um;
+            if (front > UM(PLANT_EJECTOR_MM - PLANT_PADDLE_MM / 2) &&
+                front - UM(PLANT_CUBE_MM) < UM(PLANT_EJECTOR_MM + PLANT_PADDLE_MM / 2)) {
+                plant_cube_t *c = &cubes[belt[i].cube];
+                c->fate = PLANT_CUBE_EJECTED;
+                c->done_us = now;
+                stats.ejected++;
+                plant_remove(i);
+            }
+        }
+    }
+
+    // Infeed: one cube at a time, spaced, and only while the belt has room
+    if (next_release < cfg.cubes && cubes[next_release].arrive_us <= now && belt_len < PLANT_BELT_MAX_CUBES &&
+        (belt_len == 0 || belt[belt_len - 1].front_um >= UM((int32_t)cfg.pitch_min_mm - PLANT_SPAWN_MM))) {
+        cubes[next_release].fate = PLANT_CUBE_ON_BELT;
+        cubes[next_release].t1_us = now;
+        belt[belt_len++] = (belt_slot_t){ next_release, -UM(PLANT_SPAWN_MM) };
+        next_release++;
+        stats.fed++;
+    }
+
+    // Wrapper, started through the inverter
+    if (wrap_end_us < 0 && modbus_server_get_reg(inverter, PLANT_INVERTER_START_REG) == 1) {
+        modbus_server_set_reg(inverter, PLANT_INVERTER_START_REG, 0);
+        wrap_end_us = now + (int64_t)cfg.wrap_ms * 1000;
+        if (stats.wraps_started < PLANT_MAX_WRAPS) {
+            stats.wrap_start_us[stats.wraps_started] = now;
+        }
+        stats.wraps_started++;
+        if (hold_during_wrap) {
+            held = true;
+            hold_cmd = HMI_CMD_STOP;
+        }
+    }
+    if (wrap_end_us >= 0 && now >= wrap_end_us) {
+        wrap_end_us = -1;
+        if (held) {
+            held = false;
+            hold_cmd = HMI_CMD_START;
+        }
+        wrap_done_off_us = now + PLANT_WRAP_DONE_MS * 1000;
+        stats.wraps_done++;
+    }
+    if (wrap_done_off_us >= 0 && now >= wrap_done_off_us) {
+        wrap_done_off_us = -1;
+    }
+    stats.wrapping = wrap_end_us >= 0;
+    stats.on_belt = (uint32_t)belt_len;
+}
+
+static uint32_t plant_levels(void)
+{
+    uint32_t l = wrap_done_off_us >= 0 ? CH(IO_CH_WRAP_DONE) : 0;
+
+    for (int i = 0; i < belt_len; i++) {
+        l |= plant_covers(belt[i].front_um, 0) ? CH(IO_CH_SENSOR_1) : 0;
+        l |= plant_covers(belt[i].front_um, PLANT_T2_MM) ? CH(IO_CH_SENSOR_2) : 0;
+        l |= plant_covers(belt[i].front_um, PLANT_T3_MM) ? CH(IO_CH_SENSOR_3) : 0;
+    }
+    return l;
+}
+
+static void plant_task(void *arg)
+{
+    int64_t next = host_now_us();
+
+    for (;;) {
+        pthread_mutex_lock(&lock);
+        plant_step(next);
+        uint32_t l = plant_levels();
+        int cmd = hold_cmd;
+        hold_cmd = -1;
+        pthread_mutex_unlock(&lock);
+
+        // The operator holding the line for the wrap, from the panel
+        if (cmd >= 0) {
+            logic_event_t evt = { .type = LOGIC_EVT_HMI, .hmi = { .id = (uint8_t)cmd } };
+            logic_post_event_wait(&evt, portMAX_DELAY);
+        }
+
+        // Through the GPIO ISR, as the photo-eyes would
+        if (l != levels) {
+            levels = l;
+            hal_io_host_set_inputs(l);
+        }
+        next += PLANT_STEP_US;
+        host_sleep_until(next);
+    }
+}
+
+void plant_start(const plant_config_t *config, modbus_server_t *inverter_server)
+{
+    uint32_t rng = config->seed ? config->seed : 1;
+    int64_t now = host_now_us();
+    int64_t arrive = now;
+
+    cfg = *config;
+    inverter = inverter_server;
+    cubes = calloc(cfg.cubes, sizeof(*cubes));
+    noise_rng = rng ^ 0x9E3779B9u;
+
+    for (uint32_t i = 0; i < cfg.cubes; i++) {
+        plant_cube_t *c = &cubes[i];
+        arrive += (int64_t)(-log(plant_uniform(&rng)) * 3600e6 / cfg.rate_per_hour);
+        c->arrive_us = arrive;
+        c->weight_g = cfg.weight_mean_g + (int32_t)lround(plant_gauss(&rng) * cfg.weight_sd_g);
+        if (plant_rand(&rng) % 1000 < cfg.outlier_permille) {
+            c->weight_g += plant_rand(&rng) & 1 ? cfg.outlier_g : -cfg.outlier_g;
+        }
+    }
+
+    step_belt_um = plant_belt_um(now);
+    host_pcnt_set_source(plant_encoder, NULL);
+    host_adc_set_source(plant_load_cell, NULL);
+    xTaskCreatePinnedToCore(plant_task, "plant", 4096, NULL, 5, NULL, tskNO_AFFINITY);
+}
+
+void plant_set_hold_during_wrap(bool hold)
+{
+    pthread_mutex_lock(&lock);
+    hold_during_wrap = hold;
+    pthread_mutex_unlock(&lock);
+}
+
+void plant_get_stats(plant_stats_t *out)
+{
+    pthread_mutex_lock(&lock);
+    *out = stats;
+    pthread_mutex_unlock(&lock);
+}
+
+const plant_cube_t *plant_cubes(void)
+{
+    return cubes;
+}
+
+bool plant_done(void)
+{
+    pthread_mutex_lock(&lock);
+    bool done = next_release == cfg.cubes && belt_len == 0 && gripped == PLANT_NONE && wrap_end_us < 0;
+    pthread_mutex_unlock(&lock);
+    return done;
+}
+
+bool plant_robot_pick(void *ctx, uint16_t slot)
+{
+    bool picked = false;
+
+    pthread_mutex_lock(&lock);
+    for (int i = 0; i < belt_len; i++) {
+        if (plant_covers(belt[i].front_um, PLANT_T3_MM)) {
+            gripped = belt[i].cube;
+            cubes[gripped].fate = PLANT_CUBE_GRIPPED;
+            plant_remove(i);
+            picked = true;
+            break;
+        }
+    }
+    stats.on_belt = (uint32_t)belt_len;
+    pthread_mutex_unlock(&lock);
+    return picked;
+}
+
+void plant_robot_place(void *ctx, uint16_t slot)
+{
+    pthread_mutex_lock(&lock);
+    if (gripped != PLANT_NONE) {
+        plant_cube_t *c = &cubes[gripped];
+        c->fate = PLANT_CUBE_PLACED;
+        c->done_us = host_now_us();
+        c->slot = slot;
+        stats.placed++;
+        gripped = PLANT_NONE;
+    }
+    pthread_mutex_unlock(&lock);
+}
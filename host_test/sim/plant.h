@@ -0,0 +1,114 @@
+/*
+ * plant.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ *
+ * Plant model of the line for the host build. An infeed releases cubes
+ * onto the belt at a scenario rate with a scenario weight distribution;
+ * the belt drives the encoder, the cubes drive the photo-eyes (through
+ * the GPIO ISR), the load cell (through the continuous ADC) and are
+ * pushed off by the ejector or lifted by the robot. The wrapper runs
+ * when the inverter's start register is written and reports WRAP_DONE.
+ * The plant knows every cube's true weight and fate, which is what the
+ * controller's decisions are scored against.
+ */
+
+#ifndef SIM_PLANT_H_
+#define SIM_PLANT_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "modbus_server.h"
+
+// Geometry, positions of the cube front from T1 in mm
+#define PLANT_CUBE_MM           600
+#define PLANT_PLATFORM_MM       800         // scale platform, from T1 (ADC_DYN_PLATFORM_MM)
+#define PLANT_T2_MM             1400
+#define PLANT_EJECTOR_MM        1550        // paddle centre, EJECTOR_OFFSET_MM after T2
+#define PLANT_PADDLE_MM         300
+#define PLANT_T3_MM             5000        // pickup
+#define PLANT_END_STOP_MM       5500        // cubes wait here for the robot
+#define PLANT_BELT_MAX_CUBES    6           // more would back up over T2
+
+// Accept range of logic.c, for scoring
+#define PLANT_WEIGHT_MIN_G      49000
+#define PLANT_WEIGHT_MAX_G      51000
+
+#define PLANT_INVERTER_START_REG    0x2000  // written with 1 by tcp.c to start the wrapper
+#define PLANT_MAX_WRAPS             64
+
+typedef struct {
+    uint32_t cubes;                 // cubes fed in the scenario
+    uint32_t rate_per_hour;         // mean rate of the infeed, Poisson arrivals
+    uint32_t pitch_min_mm;          // infeed spacing front to front, keeps one cube on the scale
+    int32_t  belt_mm_s;
+    int32_t  weight_mean_g;
+    int32_t  weight_sd_g;           // normal spread of good production
+    uint16_t outlier_permille;      // broken or wrong cubes
+    int32_t  outlier_g;             // their weight offset, sign random
+    int32_t  noise_g;               // load cell noise per ADC sample
+    uint32_t wrap_ms;
+    uint32_t seed;
+} plant_config_t;
+
+typedef enum {
+    PLANT_CUBE_WAITING = 0,         // in the infeed
+    PLANT_CUBE_ON_BELT,
+    PLANT_CUBE_GRIPPED,
+    PLANT_CUBE_PLACED,
+    PLANT_CUBE_EJECTED
+} plant_fate_t;
+
+typedef struct {
+    int32_t      weight_g;          // true weight
+    int64_t      arrive_us;         // at the infeed
+    int64_t      t1_us;             // released onto the belt
+    int64_t      t3_us;             // reached T3, 0 if it never did
+    int64_t      done_us;           // placed or ejected
+    plant_fate_t fate;
+    uint16_t     slot;              // when placed
+} plant_cube_t;
+
+typedef struct {
+    uint32_t fed;                   // released onto the belt
+    uint32_t placed;
+    uint32_t ejected;
+    uint32_t on_belt;
+    uint32_t wraps_started;
+    uint32_t wraps_done;
+    int64_t  wrap_start_us[PLANT_MAX_WRAPS];
+    bool     wrapping;
+} plant_stats_t;
+
+/**
+ * @brief Set up the scenario and start the plant task; feeds the encoder and the load cell from now on.
+ */
+void plant_start(const plant_config_t *cfg, modbus_server_t *inverter);
+
+/**
+ * @brief Play the single pallet station the line had before: STOP from the
+ * panel when a wrap starts and START when it is done, so the robot waits.
+ */
+void plant_set_hold_during_wrap(bool hold);
+
+void plant_get_stats(plant_stats_t *out);
+
+/**
+ * @brief Every cube of the scenario, in infeed order; stable once plant_done().
+ */
+const plant_cube_t *plant_cubes(void);
+
+/**
+ * @brief Every cube fed and gone from the belt, no wrap running.
+ */
+bool plant_done(void);
+
+/**
+ * @brief Robot hooks, see robot_server.h: the cube at T3 goes into the gripper, then onto the pallet.
+ */
+bool plant_robot_pick(void *ctx, uint16_t slot);
+
+void plant_robot_place(void *ctx, uint16_t slot);
+
+#endif /* SIM_PLANT_H_ */
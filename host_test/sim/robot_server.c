@@ -0,0 +1,332 @@
+/*
+ * robot_server.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ */
+
+#include "robot_server.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "lwip/sockets.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ROBOT_SERVER_IDLE_MS    100
+#define ROBOT_SERVER_LINE_MAX   128
+
+typedef enum {
+    JOB_QUEUED = 0,     // waiting for the arm
+    JOB_PICKING,
+    JOB_PLACING
+} job_phase_t;
+
+typedef struct {
+    int      fd;
+    char     rx[ROBOT_SERVER_LINE_MAX];
+    uint16_t rx_len;
+} server_client_t;
+
+typedef struct {
+    bool        used;
+    bool        acked;
+    int         fd;
+    uint32_t    seq;
+    uint16_t    slot;
+    uint32_t    order;      // arrival, the arm works in this order
+    job_phase_t phase;
+    int64_t     due_us;     // of the ACK, then of the end of the phase
+} robot_job_t;
+
+struct robot_server {
+    int                   listen_fd;
+    robot_server_config_t cfg;
+    pthread_mutex_t       lock;
+    uint32_t              commands;
+    uint32_t              errors;
+    uint32_t              connections;
+    uint32_t              arrivals;
+    server_client_t       clients[ROBOT_SERVER_MAX_CLIENTS];
+    robot_job_t           jobs[ROBOT_SERVER_MAX_JOBS];
+};
+
+static void server_reply(int fd, uint32_t seq, const char *word)
+{
+    char line[ROBOT_SERVER_LINE_MAX];
+    int len = snprintf(line, sizeof(line), "%lu %s\n", (unsigned long)seq, word);
+
+    send(fd, line, (size_t)len, 0);
+}
+
+static void server_close(robot_server_t *s, server_client_t *c)
+{
+    // The arm stops with the connection: unfinished commands are forgotten
+    for (int i = 0; i < ROBOT_SERVER_MAX_JOBS; i++) {
+        if (s->jobs[i].used && s->jobs[i].fd == c->fd) {
+            s->jobs[i].used = false;
+        }
+    }
+    close(c->fd);
+    c->fd = -1;
+    c->rx_len = 0;
+}
+
+// One command line; called with the lock held
+static void server_command(robot_server_t *s, int fd, char *line)
+{
+    char *end = NULL;
+    unsigned long seq = strtoul(line, &end, 10);
+    unsigned slot = 0;
+
+    if (end == line || *end != ' ') {
+        return;
+    }
+    s->commands++;
+    if (sscanf(end + 1, "PLACE_CUBE %u", &slot) != 1) {
+        s->errors++;
+        server_reply(fd, seq, "ERROR unknown command");
+        return;
+    }
+
+    for (int i = 0; i < ROBOT_SERVER_MAX_JOBS; i++) {
+        robot_job_t *j = &s->jobs[i];
+        if (!j->used) {
+            *j = (robot_job_t){
+                .used = true,
+                .fd = fd,
+                .seq = seq,
+                .slot = (uint16_t)slot,
+                .order = s->arrivals++,
+                .phase = JOB_QUEUED,
+                .due_us = esp_timer_get_time() + (int64_t)s->cfg.ack_ms * 1000,
+            };
+            return;
+        }
+    }
+    s->errors++;
+    server_reply(fd, seq, "ERROR busy");
+}
+
+static void server_receive(robot_server_t *s, server_client_t *c)
+{
+    int n = recv(c->fd, c->rx + c->rx_len, sizeof(c->rx) - 1 - c->rx_len, 0);
+
+    if (n <= 0) {
+        if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+            server_close(s, c);
+        }
+        return;
+    }
+    c->rx_len += n;
+    c->rx[c->rx_len] = '\0';
+
+    char *start = c->rx;
+    char *nl;
+    while ((nl = strchr(start, '\n')) != NULL) {
+        *nl = '\0';
+        server_command(s, c->fd, start);
+        start = nl + 1;
+    }
+    c->rx_len -= (uint16_t)(start - c->rx);
+    memmove(c->rx, start, c->rx_len);
+    if (c->rx_len >= sizeof(c->rx) - 1) {
+        c->rx_len = 0;
+    }
+}
+
+/*
+ * Send the ACKs that are due and move the arm: the oldest acknowledged
+ * command is picked, then placed. Returns when the next thing is due.
+ */
+static int64_t server_run(robot_server_t *s)
+{
+    int64_t now = esp_timer_get_time();
+    robot_job_t *arm = NULL;
+
+    for (int i = 0; i < ROBOT_SERVER_MAX_JOBS; i++) {
+        robot_job_t *j = &s->jobs[i];
+        if (j->used && !j->acked && j->due_us <= now) {
+            j->acked = true;
+            server_reply(j->fd, j->seq, "ACK");
+        }
+    }
+
+    for (;;) {
+        arm = NULL;
+        for (int i = 0; i < ROBOT_SERVER_MAX_JOBS; i++) {
+            robot_job_t *j = &s->jobs[i];
+            if (j->used && j->acked && (arm == NULL || j->order < arm->order)) {
+                arm = j;
+            }
+        }
+        if (arm == NULL || arm->due_us > now) {
+            break;
+        }
+
+        if (arm->phase == JOB_QUEUED) {
+            arm->phase = JOB_PICKING;
+            arm->due_us = now + (int64_t)s->cfg.pick_ms * 1000;
+        } else if (arm->phase == JOB_PICKING) {
+            if (s->cfg.on_pick != NULL && !s->cfg.on_pick(s->cfg.ctx, arm->slot)) {
+                s->errors++;
+                server_reply(arm->fd, arm->seq, "ERROR no cube at pickup");
+                arm->used = false;
+            } else {
+                arm->phase = JOB_PLACING;
+                arm->due_us = now + (int64_t)s->cfg.place_ms * 1000;
+            }
+        } else {
+            if (s->cfg.on_place != NULL) {
+                s->cfg.on_place(s->cfg.ctx, arm->slot);
+            }
+            server_reply(arm->fd, arm->seq, "DONE");
+            arm->used = false;
+        }
+    }
+
+    int64_t next = now + ROBOT_SERVER_IDLE_MS * 1000;
+    for (int i = 0; i < ROBOT_SERVER_MAX_JOBS; i++) {
+        robot_job_t *j = &s->jobs[i];
+        if (j->used && (!j->acked || j == arm) && j->due_us < next) {
+            next = j->due_us;
+        }
+    }
+    return next;
+}
+
+static void server_accept(robot_server_t *s)
+{
+    int fd = accept(s->listen_fd, NULL, NULL);
+
+    if (fd < 0) {
+        return;
+    }
+    for (int i = 0; i < ROBOT_SERVER_MAX_CLIENTS; i++) {
+        server_client_t *c = &s->clients[i];
+        if (c->fd < 0) {
+            int one = 1;
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            c->fd = fd;
+            c->rx_len = 0;
+            s->connections++;
+            return;
+        }
+    }
+    close(fd);
+}
+
+static void robot_server_task(void *arg)
+{
+    robot_server_t *s = arg;
+    int64_t next = esp_timer_get_time();
+
+    for (;;) {
+        fd_set rfds;
+        int maxfd = s->listen_fd;
+
+        FD_ZERO(&rfds);
+        FD_SET(s->listen_fd, &rfds);
+        pthread_mutex_lock(&s->lock);
+        for (int i = 0; i < ROBOT_SERVER_MAX_CLIENTS; i++) {
+            if (s->clients[i].fd >= 0) {
+                FD_SET(s->clients[i].fd, &rfds);
+                if (s->clients[i].fd > maxfd) {
+                    maxfd = s->clients[i].fd;
+                }
+            }
+        }
+        pthread_mutex_unlock(&s->lock);
+
+        int64_t wait_us = next - esp_timer_get_time();
+        struct timeval tv = {
+            .tv_sec = wait_us > 0 ? wait_us / 1000000 : 0,
+            .tv_usec = wait_us > 0 ? wait_us % 1000000 : 0,
+        };
+        int ready = select(maxfd + 1, &rfds, NULL, NULL, &tv);
+
+        pthread_mutex_lock(&s->lock);
+        if (ready > 0) {
+            if (FD_ISSET(s->listen_fd, &rfds)) {
+                server_accept(s);
+            }
+            for (int i = 0; i < ROBOT_SERVER_MAX_CLIENTS; i++) {
+                server_client_t *c = &s->clients[i];
+                if (c->fd >= 0 && FD_ISSET(c->fd, &rfds)) {
+                    server_receive(s, c);
+                }
+            }
+        }
+        next = server_run(s);
+        pthread_mutex_unlock(&s->lock);
+    }
+}
+
+robot_server_t *robot_server_start(uint16_t port, const robot_server_config_t *cfg)
+{
+    robot_server_t *s = calloc(1, sizeof(*s));
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(port),
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    int one = 1;
+
+    s->cfg = *cfg;
+    pthread_mutex_init(&s->lock, NULL);
+    for (int i = 0; i < ROBOT_SERVER_MAX_CLIENTS; i++) {
+        s->clients[i].fd = -1;
+    }
+
+    s->listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    setsockopt(s->listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (bind(s->listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(s->listen_fd, 2) != 0) {
+        close(s->listen_fd);
+        free(s);
+        return NULL;
+    }
+    fcntl(s->listen_fd, F_SETFL, fcntl(s->listen_fd, F_GETFL, 0) | O_NONBLOCK);
+
+    xTaskCreatePinnedToCore(robot_server_task, "robot_server", 4096, s, 5, NULL, tskNO_AFFINITY);
+    return s;
+}
+
+uint32_t robot_server_commands(robot_server_t *s)
+{
+    pthread_mutex_lock(&s->lock);
+    uint32_t n = s->commands;
+    pthread_mutex_unlock(&s->lock);
+    return n;
+}
+
+uint32_t robot_server_errors(robot_server_t *s)
+{
+    pthread_mutex_lock(&s->lock);
+    uint32_t n = s->errors;
+    pthread_mutex_unlock(&s->lock);
+    return n;
+}
+
+uint32_t robot_server_connections(robot_server_t *s)
+{
+    pthread_mutex_lock(&s->lock);
+    uint32_t n = s->connections;
+    pthread_mutex_unlock(&s->lock);
+    return n;
+}
+
+bool robot_server_idle(robot_server_t *s)
+{
+    bool idle = true;
+
+    pthread_mutex_lock(&s->lock);
+    for (int i = 0; i < ROBOT_SERVER_MAX_JOBS; i++) {
+        idle &= !s->jobs[i].used;
+    }
+    pthread_mutex_unlock(&s->lock);
+    return idle;
+}
@@ -0,0 +1,62 @@
+/*
+ * robot_server.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ *
+ * Stand-in robot controller for the host build: the line protocol of
+ * robot_link on 127.0.0.1, served by its own task. Every command is
+ * acknowledged on arrival; PLACE_CUBE commands are then carried out one
+ * after the other, each a pick from T3 and a place on the pallet, with
+ * the plant told about both so the cube leaves the belt when the
+ * gripper takes it.
+ */
+
+#ifndef SIM_ROBOT_SERVER_H_
+#define SIM_ROBOT_SERVER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define ROBOT_SERVER_MAX_CLIENTS    2
+#define ROBOT_SERVER_MAX_JOBS       8       // commands acknowledged and not yet done
+
+/**
+ * @brief Lift the cube off T3 for slot; false if there is none, which the robot reports as an error.
+ */
+typedef bool (*robot_server_pick_t)(void *ctx, uint16_t slot);
+
+/**
+ * @brief The cube lifted last is on the pallet at slot.
+ */
+typedef void (*robot_server_place_t)(void *ctx, uint16_t slot);
+
+typedef struct {
+    uint32_t             ack_ms;        // command received to ACK
+    uint32_t             pick_ms;       // start of a command to the cube lifted off T3
+    uint32_t             place_ms;      // cube lifted to placed, DONE sent
+    robot_server_pick_t  on_pick;
+    robot_server_place_t on_place;
+    void                *ctx;
+} robot_server_config_t;
+
+typedef struct robot_server robot_server_t;
+
+/**
+ * @brief Listen on 127.0.0.1:port and start the server task.
+ * @return NULL if the port cannot be bound.
+ */
+robot_server_t *robot_server_start(uint16_t port, const robot_server_config_t *cfg);
+
+uint32_t robot_server_commands(robot_server_t *s);
+
+uint32_t robot_server_errors(robot_server_t *s);
+
+uint32_t robot_server_connections(robot_server_t *s);
+
+/**
+ * @brief No command waiting and the arm at rest.
+ */
+bool robot_server_idle(robot_server_t *s);
+
+#endif /* SIM_ROBOT_SERVER_H_ */
@@ -0,0 +1,404 @@
+/*
+ * test_cube_tracking.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ *
+ * Deterministic multi-cube simulation of the logic engine. A scripted
+ * plant turns a list of cubes into sensor edges, weighing results and
+ * robot replies in virtual time; the test thread hands them to
+ * logic_process() one by one, so the same scenario always gives the
+ * same decisions at the same times.
+ */
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "hal_io.h"
+#include "logic.h"
+#include "conveyor.h"
+#include "outputs.h"
+#include "line_status.h"
+#include "host_port.h"
+#include "host_test.h"
+#include <string.h>
+
+#define CH(ch)              (1u << (ch))
+#define MS(ms)              ((int64_t)(ms) * 1000)
+
+// Plant: belt speed and positions of the cube front, from T1
+#define BELT_MM_S           500
+#define CUBE_MM             600
+#define WEIGH_AT_MM         700         // fully on the 800 mm platform
+#define T2_MM               1400
+#define T3_MM               2600
+#define EJECT_DONE_MM       (150 + 200) // paddle offset plus stroke, from the T2 edge
+#define CUBE_PITCH_MS       2000        // three cubes between T1 and T3
+#define ROBOT_ACK_MS        50
+#define ROBOT_PICKED_MS     350         // cube lifted off T3
+#define ROBOT_DONE_MS       1500
+#define WRAP_MS             3000
+
+#define SCENARIO_CUBES      56
+#define PALLET_CUBES        (5 * PALLET_CUBES_PER_LAYER)     // default max_layers
+#define MAX_AGENDA          64
+#define MAX_OUTCOMES        128
+
+TEST_DEFINE_FAILURES;
+
+QueueHandle_t logic_event_queue = NULL;
+
+typedef enum {
+    SIM_T1_ON = 0,
+    SIM_T1_OFF,
+    SIM_WEIGHED,
+    SIM_T2_ON,
+    SIM_T2_OFF,
+    SIM_T3_ON,
+    SIM_T3_OFF,
+    SIM_ROBOT_ACK,
+    SIM_ROBOT_DONE,
+    SIM_WRAP_ON,
+    SIM_WRAP_OFF
+} sim_kind_t;
+
+typedef struct {
+    int64_t    at_us;
+    uint32_t   order;       // ties are applied in the order they were scheduled
+    sim_kind_t kind;
+    uint16_t   cube;        // index into the scenario
+    uint16_t   seq;         // robot command
+} sim_event_t;
+
+// What the line did, as seen from outside the controller
+typedef struct {
+    int64_t  at_us;         // from the start of the scenario
+    char     what;          // 'P' place command, 'E' ejector retracted, 'W' wrap started
+    uint16_t cube_id;
+    uint16_t slot;
+} outcome_t;
+
+typedef struct {
+    int32_t weight_g[SCENARIO_CUBES];
+    int64_t t2_us[SCENARIO_CUBES];
+    sim_event_t agenda[MAX_AGENDA];
+    int     agenda_len;
+    uint32_t order;
+    uint32_t levels;
+    uint16_t seq;
+    int64_t start_us;
+    outcome_t out[MAX_OUTCOMES];
+    int     outcomes;
+    uint8_t max_in_flight;
+} sim_t;
+
+static sim_t sim;
+
+static int belt_counts(int64_t t_us, void *ctx)
+{
+    return (int)(t_us * BELT_MM_S / 1000 * CONVEYOR_COUNTS_PER_M / 1000000);
+}
+
+static int64_t travel_us(int32_t mm)
+{
+    return (int64_t)mm * 1000000 / BELT_MM_S;
+}
+
+static void sim_at(int64_t at_us, sim_kind_t kind, uint16_t cube, uint16_t seq)
+{
+    TEST_CHECK(sim.agenda_len < MAX_AGENDA);
+    if (sim.agenda_len < MAX_AGENDA) {
+        sim.agenda[sim.agenda_len++] = (sim_event_t){ at_us, sim.order++, kind, cube, seq };
+    }
+}
+
+static bool sim_next(int64_t now, sim_event_t *out)
+{
+    int best = -1;
+
+    for (int i = 0; i < sim.agenda_len; i++) {
+        const sim_event_t *e = &sim.agenda[i];
+        if (e->at_us <= now && (best < 0 || e->at_us < sim.agenda[best].at_us ||
+                                (e->at_us == sim.agenda[best].at_us && e->order < sim.agenda[best].order))) {
+            best = i;
+        }
+    }
+    if (best < 0) {
+        return false;
+    }
+    *out = sim.agenda[best];
+    sim.agenda[best] = sim.agenda[--sim.agenda_len];
+    return true;
+}
+
+static void sim_record(char what, uint16_t cube_id, uint16_t slot)
+{
+    TEST_CHECK(sim.outcomes < MAX_OUTCOMES);
+    if (sim.outcomes < MAX_OUTCOMES) {
+        sim.out[sim.outcomes++] = (outcome_t){ host_now_us() - sim.start_us, what, cube_id, slot };
+    }
+}
+
+static void sim_edge(int ch, bool level)
+{
+    sim.levels = level ? sim.levels | CH(ch) : sim.levels & ~CH(ch);
+
+    logic_event_t evt = {
+        .type = LOGIC_EVT_INPUTS,
+        .inputs = {
+            .sensor1 = sim.levels & CH(IO_CH_SENSOR_1),
+            .sensor2 = sim.levels & CH(IO_CH_SENSOR_2),
+            .sensor3 = sim.levels & CH(IO_CH_SENSOR_3),
+            .wrap_done = sim.levels & CH(IO_CH_WRAP_DONE),
+            .changed = CH(ch),
+            .timestamp_us = host_now_us(),
+        },
+    };
+    logic_process(&evt);
+}
+
+static void sim_robot(uint16_t seq, robot_reply_t reply, uint16_t cube_id)
+{
+    logic_event_t evt = {
+        .type = LOGIC_EVT_ROBOT,
+        .robot = { .seq = seq, .reply = reply, .cube_id = cube_id },
+    };
+    logic_process(&evt);
+}
+
+// Cube ids are handed out on T1 in scenario order, from 1
+static uint16_t sim_cube_id(uint16_t cube)
+{
+    return (uint16_t)(cube + 1);
+}
+
+static uint16_t sim_cube_index(uint16_t cube_id)
+{
+    return (uint16_t)(cube_id - 1);
+}
+
+static bool sim_good(uint16_t cube)
+{
+    return sim.weight_g[cube] >= 49000 && sim.weight_g[cube] <= 51000;
+}
+
+static void sim_apply(const sim_event_t *e)
+{
+    switch (e->kind) {
+        case SIM_T1_ON:     sim_edge(IO_CH_SENSOR_1, true); break;
+        case SIM_T1_OFF:    sim_edge(IO_CH_SENSOR_1, false); break;
+        case SIM_T2_OFF:    sim_edge(IO_CH_SENSOR_2, false); break;
+        case SIM_T3_ON:     sim_edge(IO_CH_SENSOR_3, true); break;
+        case SIM_T3_OFF:    sim_edge(IO_CH_SENSOR_3, false); break;
+        case SIM_WRAP_ON:   sim_edge(IO_CH_WRAP_DONE, true); break;
+        case SIM_WRAP_OFF:  sim_edge(IO_CH_WRAP_DONE, false); break;
+
+        case SIM_T2_ON:
+            sim.t2_us[e->cube] = host_now_us() - sim.start_us;
+            sim_edge(IO_CH_SENSOR_2, true);
+            break;
+
+        case SIM_WEIGHED: {
+            logic_event_t evt = {
+                .type = LOGIC_EVT_WEIGH_DONE,
+                .weigh = {
+                    .status = WEIGH_RESULT_STABLE,
+                    .mean_g = sim.weight_g[e->cube],
+                    .raw_g = sim.weight_g[e->cube],
+                    .cube_id = sim_cube_id(e->cube),
+                },
+            };
+            logic_process(&evt);
+            break;
+        }
+
+        case SIM_ROBOT_ACK:
+            sim_robot(e->seq, ROBOT_REPLY_ACK, 0);
+            break;
+
+        case SIM_ROBOT_DONE:
+            sim_robot(e->seq, ROBOT_REPLY_DONE, 0);
+            break;
+    }
+}
+
+// tcp_client_task, the robot and the wrapper
+static void sim_commands(void)
+{
+    tcp_command_t cmd;
+    int64_t now = host_now_us();
+
+    while (xQueueReceive(tcp_command_queue, &cmd, 0) == pdTRUE) {
+        if (cmd.type == CMD_ROBOT_PLACE) {
+            uint16_t seq = ++sim.seq;
+            sim_record('P', cmd.cube_id, cmd.slot);
+            sim_robot(seq, ROBOT_REPLY_QUEUED, cmd.cube_id);
+            sim_at(now + MS(ROBOT_ACK_MS), SIM_ROBOT_ACK, 0, seq);
+            sim_at(now + MS(ROBOT_PICKED_MS), SIM_T3_OFF, sim_cube_index(cmd.cube_id), 0);
+            sim_at(now + MS(ROBOT_DONE_MS), SIM_ROBOT_DONE, 0, seq);
+        } else if (cmd.type == CMD_INVERTER_START) {
+            sim_record('W', 0, 0);
+            sim_at(now + MS(WRAP_MS), SIM_WRAP_ON, 0, 0);
+            sim_at(now + MS(WRAP_MS + 200), SIM_WRAP_OFF, 0, 0);
+        }
+    }
+}
+
+/*
+ * Run the scenario in 1 ms steps. Ejector reports come from the conveyor
+ * actions in the esp_timer task; once those due in the step have run,
+ * their reports are handed to logic ahead of the plant events, as
+ * logic_task takes them off the front of its queue.
+ */
+static void sim_run(void)
+{
+    int next_cube = 0;
+    int64_t end_us = 0;
+    line_status_t st;
+
+    // Same phase of the conveyor timers for every run
+    sim.start_us = (host_now_us() / 1000000 + 1) * 1000000;
+    sim.agenda_len = 0;
+    sim.levels = 0;
+    sim.outcomes = 0;
+    sim.max_in_flight = 0;
+    logic_init();
+
+    for (int64_t now = sim.start_us; next_cube < SCENARIO_CUBES || sim.agenda_len > 0 || now < end_us;
+         now += MS(1)) {
+        host_sleep_until(now);
+        host_settle();
+
+        logic_event_t evt;
+        while (xQueueReceive(logic_event_queue, &evt, 0) == pdTRUE) {
+            if (evt.type == LOGIC_EVT_EJECTED) {
+                sim_record('E', 0, 0);
+            }
+            logic_process(&evt);
+        }
+
+        if (next_cube < SCENARIO_CUBES && now >= sim.start_us + MS(next_cube * CUBE_PITCH_MS)) {
+            uint16_t c = (uint16_t)next_cube++;
+            sim_at(now, SIM_T1_ON, c, 0);
+            sim_at(now + travel_us(CUBE_MM), SIM_T1_OFF, c, 0);
+            sim_at(now + travel_us(WEIGH_AT_MM), SIM_WEIGHED, c, 0);
+            sim_at(now + travel_us(T2_MM), SIM_T2_ON, c, 0);
+            sim_at(now + travel_us(T2_MM + CUBE_MM), SIM_T2_OFF, c, 0);
+            if (sim_good(c)) {
+                sim_at(now + travel_us(T3_MM), SIM_T3_ON, c, 0);
+            }
+            // Leave time for the last ejector stroke
+            end_us = now + travel_us(T2_MM + EJECT_DONE_MM) + MS(100);
+        }
+
+        sim_event_t e;
+        while (sim_next(now, &e)) {
+            sim_apply(&e);
+            sim_commands();
+        }
+
+        line_status_get(&st);
+        if (st.cubes > sim.max_in_flight) {
+            sim.max_in_flight = st.cubes;
+        }
+    }
+}
+
+static void sim_scenario(void)
+{
+    // Every fifth cube heavy, one light one in between
+    for (int i = 0; i < SCENARIO_CUBES; i++) {
+        sim.weight_g[i] = i % 5 == 4 ? 53000 : i == 7 ? 47000 : 50000 + (i % 3 - 1) * 400;
+    }
+}
+
+static void test_cubes_in_flight(void)
+{
+    int good = 0;
+    int rejects = 0;
+    int places = 0;
+    int ejects = 0;
+    int wraps = 0;
+    line_status_t st;
+
+    sim_scenario();
+    sim_run();
+
+    for (int i = 0; i < SCENARIO_CUBES; i++) {
+        good += sim_good(i);
+    }
+    rejects = SCENARIO_CUBES - good;
+
+    // Several cubes are tracked at once along the line
+    TEST_CHECK(sim.max_in_flight >= 3);
+
+    int next_good = 0;
+    int next_reject = 0;
+    for (int i = 0; i < sim.outcomes; i++) {
+        const outcome_t *o = &sim.out[i];
+        if (o->what == 'P') {
+            // Good cubes go to the robot in line order, slots in plan order across pallets
+            while (next_good < SCENARIO_CUBES && !sim_good(next_good)) {
+                next_good++;
+            }
+            TEST_CHECK_EQ(sim_cube_id(next_good), o->cube_id);
+            TEST_CHECK_EQ(places % PALLET_CUBES, o->slot);
+            next_good++;
+            places++;
+        } else if (o->what == 'E') {
+            // Each reject retracts the ejector after its stroke, measured from its own T2 edge
+            while (next_reject < SCENARIO_CUBES && sim_good(next_reject)) {
+                next_reject++;
+            }
+            int64_t after_t2 = o->at_us - sim.t2_us[next_reject];
+            TEST_CHECK(after_t2 >= travel_us(EJECT_DONE_MM));
+            TEST_CHECK(after_t2 <= travel_us(EJECT_DONE_MM) + MS(2));
+            next_reject++;
+            ejects++;
+        } else if (o->what == 'W') {
+            TEST_CHECK_EQ(PALLET_CUBES, places);
+            wraps++;
+        }
+    }
+    TEST_CHECK_EQ(good, places);
+    TEST_CHECK_EQ(rejects, ejects);
+    TEST_CHECK_EQ(good / PALLET_CUBES, wraps);
+
+    line_status_get(&st);
+    TEST_CHECK_EQ(0, st.cubes);
+    TEST_CHECK_EQ(0, hal_io_read_outputs() & IO_OUT_BIT(IO_OUT_EJECTOR));
+    printf("%d cubes, %d placed, %d ejected, %d wraps, up to %u in flight\n",
+           SCENARIO_CUBES, places, ejects, wraps, sim.max_in_flight);
+}
+
+static void test_deterministic(void)
+{
+    static outcome_t first[MAX_OUTCOMES];
+    int n;
+
+    sim_scenario();
+    sim_run();
+    n = sim.outcomes;
+    memcpy(first, sim.out, sizeof(first));
+
+    sim_run();
+    TEST_CHECK_EQ(n, sim.outcomes);
+    for (int i = 0; i < n && i < sim.outcomes; i++) {
+        TEST_CHECK_EQ(first[i].at_us, sim.out[i].at_us);
+        TEST_CHECK_EQ(first[i].what, sim.out[i].what);
+        TEST_CHECK_EQ(first[i].cube_id, sim.out[i].cube_id);
+        TEST_CHECK_EQ(first[i].slot, sim.out[i].slot);
+    }
+}
+
+int main(void)
+{
+    host_port_init();
+    logic_event_queue = xQueueCreate(32, sizeof(logic_event_t));
+    host_pcnt_set_source(belt_counts, NULL);
+    conveyor_init();
+    outputs_init();
+
+    RUN_TEST(test_cubes_in_flight);
+    RUN_TEST(test_deterministic);
+    TEST_EXIT();
+}
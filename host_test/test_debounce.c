@@ -0,0 +1,308 @@
+/*
+ * test_debounce.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ *
+ * Replays synthetic edge trains through the debouncer: clean steps,
+ * contact bounce, glitches, lost edges and random trains checked
+ * against a reference model.
+ */
+
+#include "debounce.h"
+#include "host_test.h"
+#include <stdint.h>
+#include <stdlib.h>
+
+#define HOLD_US     5000
+
+TEST_DEFINE_FAILURES;
+
+typedef struct {
+    int64_t ts_us;
+    uint8_t channel;
+    bool    level;
+} edge_t;
+
+typedef struct {
+    int64_t  at_us;             // update time that reported the change
+    int64_t  changed_at_us;     // edge the change is dated to
+    uint8_t  channel;
+    bool     level;
+} change_t;
+
+/*
+ * Feed edges in order as io_task does: update at every edge and at every
+ * debounce deadline in between, then run to the end time.
+ */
+static int replay(debounce_t *d, const edge_t *edges, int n, int64_t end_us, change_t *out, int max)
+{
+    int changes = 0;
+    int i = 0;
+
+    for (;;) {
+        int64_t deadline = debounce_next_deadline(d);
+        int64_t next_edge = i < n ? edges[i].ts_us : INT64_MAX;
+        int64_t now = deadline >= 0 && deadline < next_edge ? deadline : next_edge;
+
+        if (now > end_us) {
+            now = end_us;
+        }
+        uint32_t changed = debounce_update(d, now);
+        for (uint8_t ch = 0; ch < d->count; ch++) {
+            if ((changed & (1u << ch)) && changes < max) {
+                out[changes++] = (change_t){
+                    .at_us = now,
+                    .changed_at_us = d->ch[ch].changed_at_us,
+                    .channel = ch,
+                    .level = d->ch[ch].stable,
+                };
+            }
+        }
+        if (now == end_us) {
+            return changes;
+        }
+        while (i < n && edges[i].ts_us == now) {
+            debounce_edge(d, edges[i].channel, edges[i].level, edges[i].ts_us);
+            i++;
+        }
+    }
+}
+
+static void test_clean_step(void)
+{
+    debounce_t d;
+    change_t c[4];
+    const edge_t edges[] = { { 1000, 0, true } };
+
+    debounce_init(&d, 1, HOLD_US, 0, 0);
+    int n = replay(&d, edges, 1, 100000, c, 4);
+
+    TEST_CHECK_EQ(1, n);
+    TEST_CHECK_EQ(1000 + HOLD_US, c[0].at_us);
+    TEST_CHECK_EQ(1000, c[0].changed_at_us);
+    TEST_CHECK_EQ(1, c[0].level);
+    TEST_CHECK_EQ(1, debounce_levels(&d));
+    TEST_CHECK_EQ(-1, debounce_next_deadline(&d));
+}
+
+static void test_not_confirmed_early(void)
+{
+    debounce_t d;
+
+    debounce_init(&d, 1, HOLD_US, 0, 0);
+    debounce_edge(&d, 0, true, 1000);
+    TEST_CHECK_EQ(0, debounce_update(&d, 1000 + HOLD_US - 1));
+    TEST_CHECK_EQ(1000 + HOLD_US, debounce_next_deadline(&d));
+    TEST_CHECK_EQ(1, debounce_update(&d, 1000 + HOLD_US));
+}
+
+static void test_contact_bounce(void)
+{
+    debounce_t d;
+    change_t c[4];
+    // A photo-eye chattering for 1.2 ms before it settles high
+    const edge_t edges[] = {
+        { 10000, 0, true }, { 10150, 0, false }, { 10400, 0, true },
+        { 10500, 0, false }, { 10900, 0, true }, { 11200, 0, false },
+        { 11210, 0, true },
+    };
+
+    debounce_init(&d, 1, HOLD_US, 0, 0);
+    int n = replay(&d, edges, 7, 100000, c, 4);
+
+    TEST_CHECK_EQ(1, n);
+    TEST_CHECK_EQ(11210 + HOLD_US, c[0].at_us);
+    TEST_CHECK_EQ(11210, c[0].changed_at_us);
+    TEST_CHECK_EQ(1, c[0].level);
+}
+
+static void test_glitch_rejected(void)
+{
+    debounce_t d;
+    change_t c[4];
+    const edge_t edges[] = {
+        { 1000, 0, true }, { 1000 + HOLD_US - 1, 0, false },
+        { 20000, 0, true }, { 20001, 0, false },
+    };
+
+    debounce_init(&d, 1, HOLD_US, 0, 0);
+    int n = replay(&d, edges, 4, 100000, c, 4);
+
+    TEST_CHECK_EQ(0, n);
+    TEST_CHECK_EQ(0, debounce_levels(&d));
+}
+
+static void test_repeated_level_keeps_start(void)
+{
+    debounce_t d;
+
+    // The falling edge between the two rising edges was lost
+    debounce_init(&d, 1, HOLD_US, 0, 0);
+    debounce_edge(&d, 0, true, 1000);
+    debounce_edge(&d, 0, true, 4000);
+    TEST_CHECK_EQ(1, debounce_update(&d, 1000 + HOLD_US));
+    TEST_CHECK_EQ(1000, d.ch[0].changed_at_us);
+}
+
+static void test_resync_after_lost_edge(void)
+{
+    debounce_t d;
+
+    // The only edge was dropped by an overrun: the channel is high but never saw it
+    debounce_init(&d, 2, HOLD_US, 0, 0);
+    TEST_CHECK_EQ(0, debounce_update(&d, 50000));
+    TEST_CHECK_EQ(-1, debounce_next_deadline(&d));
+
+    debounce_resync(&d, 0x1, 50000);
+    TEST_CHECK_EQ(50000 + HOLD_US, debounce_next_deadline(&d));
+    TEST_CHECK_EQ(0, debounce_update(&d, 50000 + HOLD_US - 1));
+    TEST_CHECK_EQ(0x1, debounce_update(&d, 50000 + HOLD_US));
+    TEST_CHECK_EQ(0x1, debounce_levels(&d));
+}
+
+static void test_resync_keeps_pending_edge(void)
+{
+    debounce_t d;
+
+    // An edge that did arrive keeps its timestamp when the levels agree
+    debounce_init(&d, 1, HOLD_US, 0, 0);
+    debounce_edge(&d, 0, true, 1000);
+    debounce_resync(&d, 0x1, 3000);
+    TEST_CHECK_EQ(1000 + HOLD_US, debounce_next_deadline(&d));
+
+    // A stale pending level is replaced by the actual one
+    debounce_resync(&d, 0x0, 4000);
+    TEST_CHECK_EQ(-1, debounce_next_deadline(&d));
+    TEST_CHECK_EQ(0, debounce_update(&d, 100000));
+}
+
+static void test_channels_independent(void)
+{
+    debounce_t d;
+    change_t c[8];
+    const edge_t edges[] = {
+        { 1000, 0, true }, { 2000, 1, true }, { 2500, 0, false },
+        { 2600, 0, true }, { 3000, 2, true }, { 3100, 2, false },
+    };
+
+    debounce_init(&d, 3, HOLD_US, 0, 0);
+    int n = replay(&d, edges, 6, 100000, c, 8);
+
+    TEST_CHECK_EQ(2, n);
+    TEST_CHECK_EQ(1, c[0].channel);
+    TEST_CHECK_EQ(2000 + HOLD_US, c[0].at_us);
+    TEST_CHECK_EQ(0, c[1].channel);
+    TEST_CHECK_EQ(2600 + HOLD_US, c[1].at_us);
+    TEST_CHECK_EQ(0x3, debounce_levels(&d));
+}
+
+/*
+ * Reference: a level is accepted hold_us after the edge that set it,
+ * provided no later edge of the channel comes before that.
+ */
+static int reference(const edge_t *edges, int n, uint8_t channels, uint32_t initial, change_t *out, int max)
+{
+    int changes = 0;
+
+    for (uint8_t ch = 0; ch < channels; ch++) {
+        bool stable = (initial >> ch) & 1u;
+        for (int i = 0; i < n; i++) {
+            if (edges[i].channel != ch || edges[i].level == stable) {
+                continue;
+            }
+            int j = i + 1;
+            while (j < n && edges[j].channel != ch) {
+                j++;
+            }
+            int64_t confirm = edges[i].ts_us + HOLD_US;
+            if (j == n || edges[j].ts_us >= confirm) {
+                stable = edges[i].level;
+                if (changes < max) {
+                    out[changes++] = (change_t){ confirm, edges[i].ts_us, ch, stable };
+                }
+            }
+        }
+    }
+    return changes;
+}
+
+static int change_cmp(const void *a, const void *b)
+{
+    const change_t *x = a;
+    const change_t *y = b;
+
+    if (x->at_us != y->at_us) {
+        return x->at_us < y->at_us ? -1 : 1;
+    }
+    return (int)x->channel - (int)y->channel;
+}
+
+static void test_random_trains(void)
+{
+    enum { TRAINS = 200, EDGES = 400, CHANNELS = 4, MAX_CHANGES = EDGES };
+    static edge_t edges[EDGES];
+    static change_t got[MAX_CHANGES];
+    static change_t want[MAX_CHANGES];
+    int mismatches = 0;
+
+    srand(12345);
+    for (int train = 0; train < TRAINS; train++) {
+        uint32_t raw = (uint32_t)rand() & 0xF;
+        int64_t t = 0;
+
+        // Cube passages with bounce at both ends, interleaved over the channels
+        for (int i = 0; i < EDGES; i++) {
+            uint8_t ch = (uint8_t)(rand() % CHANNELS);
+            int r = rand() % 10;
+            int64_t gap = r < 6 ? rand() % 800 : r < 9 ? HOLD_US - 200 + rand() % 400 : rand() % 40000;
+            t += gap + 1;
+            raw ^= 1u << ch;
+            edges[i] = (edge_t){ t, ch, (raw >> ch) & 1u };
+        }
+
+        // Initial levels: before the first edge of each channel, the opposite of it
+        debounce_t d;
+        uint32_t initial = 0;
+        for (uint8_t ch = 0; ch < CHANNELS; ch++) {
+            for (int i = 0; i < EDGES; i++) {
+                if (edges[i].channel == ch) {
+                    initial |= (uint32_t)!edges[i].level << ch;
+                    break;
+                }
+            }
+        }
+        debounce_init(&d, CHANNELS, HOLD_US, initial, 0);
+
+        int n_got = replay(&d, edges, EDGES, t + 2 * HOLD_US, got, MAX_CHANGES);
+        int n_want = reference(edges, EDGES, CHANNELS, initial, want, MAX_CHANGES);
+        qsort(want, n_want, sizeof(want[0]), change_cmp);
+
+        if (n_got != n_want) {
+            mismatches++;
+            continue;
+        }
+        for (int i = 0; i < n_got; i++) {
+            if (got[i].at_us != want[i].at_us || got[i].changed_at_us != want[i].changed_at_us ||
+                got[i].channel != want[i].channel || got[i].level != want[i].level) {
+                mismatches++;
+                break;
+            }
+        }
+    }
+    TEST_CHECK_EQ(0, mismatches);
+}
+
+int main(void)
+{
+    RUN_TEST(test_clean_step);
+    RUN_TEST(test_not_confirmed_early);
+    RUN_TEST(test_contact_bounce);
+    RUN_TEST(test_glitch_rejected);
+    RUN_TEST(test_repeated_level_keeps_start);
+    RUN_TEST(test_resync_after_lost_edge);
+    RUN_TEST(test_resync_keeps_pending_edge);
+    RUN_TEST(test_channels_independent);
+    RUN_TEST(test_random_trains);
+    TEST_EXIT();
+}
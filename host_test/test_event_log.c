@@ -0,0 +1,309 @@
+/*
+ * test_event_log.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ *
+ * The event log on the RAM flash partition of the host port: recovery
+ * of the write position from a log left by an earlier boot with torn
+ * records in it, reads with a flush in between their chunks or racing
+ * the flush task, and the record layout left behind when power is lost
+ * in the middle of a flush.
+ */
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "event_log.h"
+#include "esp_system.h"
+#include "host_port.h"
+#include "host_test.h"
+#include <string.h>
+
+#define SECTOR_SIZE         4096
+#define SECTOR_RECORDS      (SECTOR_SIZE / sizeof(event_log_record_t))
+#define SECTORS             4
+#define SEQ_EMPTY           0xFFFFFFFFu
+#define FLUSH_WAIT_US       ((EVENT_LOG_FLUSH_MS + 100) * 1000LL)
+#define READ_BACK           150         // records behind the newest each concurrent read starts at
+#define READ_ROUNDS         200
+#define READS_PER_TICK      20
+#define FLUSH_INSIDE_QUEUED 40          // in the ring when the read starts, more than one read chunk
+
+TEST_DEFINE_FAILURES;
+
+static volatile bool reader_stop = false;
+static volatile bool reader_done = false;
+static volatile uint32_t written_seq = 0;  // newest record whose event_log_add() returned
+static uint32_t reader_reads = 0;
+static uint32_t reader_errors = 0;
+
+typedef struct {
+    uint32_t next;              // seq the next record must have
+    uint32_t errors;            // gaps, duplicates or records out of order
+    uint32_t last;
+    uint8_t  last_type;
+} read_check_t;
+
+static bool check_record(void *ctx, const event_log_record_t *rec)
+{
+    read_check_t *c = ctx;
+
+    if (rec->seq != c->next) {
+        c->errors++;
+    }
+    c->next = rec->seq + 1;
+    c->last = rec->seq;
+    c->last_type = rec->type;
+    return true;
+}
+
+static event_log_record_t *flash_slot(uint32_t sector, uint32_t slot)
+{
+    return (event_log_record_t *)(host_flash_data() + sector * SECTOR_SIZE + slot * sizeof(event_log_record_t));
+}
+
+// A record as event_log_write() leaves it; torn ones lack the seq
+static void put_record(uint32_t sector, uint32_t slot, uint32_t seq, bool torn)
+{
+    event_log_record_t rec = {
+        .seq = torn ? SEQ_EMPTY : seq,
+        .time_ms = seq * 10,
+        .weight_g = 50000,
+        .cube_id = (uint16_t)seq,
+        .type = EVENT_LOG_ACCEPT,
+        .state = EVENT_LOG_STATE_NONE,
+    };
+
+    memcpy(flash_slot(sector, slot), &rec, sizeof(rec));
+}
+
+static uint32_t newest_seq(void)
+{
+    read_check_t c = { .next = 1 };
+
+    event_log_read(1, SIZE_MAX, check_record, &c);
+    return c.last;
+}
+
+// Slot holding seq, -1 if it is not on flash
+static long find_slot(uint32_t seq)
+{
+    for (uint32_t i = 0; i < SECTORS * SECTOR_RECORDS; i++) {
+        if (flash_slot(0, i)->seq == seq) {
+            return (long)i;
+        }
+    }
+    return -1;
+}
+
+/*
+ * The previous boot filled sector 0 and lost power twice in sector 1:
+ * once on its first record, which leaves the sector without a seq in
+ * slot 0, and once part way into the body of slot 10.
+ */
+static void make_previous_boot(void)
+{
+    for (uint32_t slot = 0; slot < SECTOR_RECORDS; slot++) {
+        put_record(0, slot, slot + 1, false);
+    }
+    put_record(1, 0, 257, true);
+    for (uint32_t slot = 1; slot <= 9; slot++) {
+        put_record(1, slot, 256 + slot, false);
+    }
+    put_record(1, 10, 266, true);
+    memset((uint8_t *)flash_slot(1, 10) + sizeof(uint32_t) + 5, 0xFF, sizeof(event_log_record_t) - sizeof(uint32_t) - 5);
+}
+
+static void test_recover_after_torn_writes(void)
+{
+    read_check_t c = { .next = 1 };
+
+    host_sleep_us(FLUSH_WAIT_US);
+
+    // BOOT continues the sequence after the torn slot, which is left alone
+    event_log_record_t *boot = flash_slot(1, 11);
+    TEST_CHECK_EQ(266, boot->seq);
+    TEST_CHECK_EQ(EVENT_LOG_BOOT, boot->type);
+    TEST_CHECK_EQ(ESP_RST_POWERON, boot->weight_g);
+    TEST_CHECK_EQ(SEQ_EMPTY, flash_slot(1, 10)->seq);
+
+    TEST_CHECK_EQ(266, event_log_read(1, SIZE_MAX, check_record, &c));
+    TEST_CHECK_EQ(0, c.errors);
+    TEST_CHECK_EQ(266, c.last);
+    TEST_CHECK_EQ(EVENT_LOG_BOOT, c.last_type);
+
+    // Starting in the middle, across the sector boundary and the torn slot 0
+    c = (read_check_t){ .next = 250 };
+    TEST_CHECK_EQ(12, event_log_read(250, 12, check_record, &c));
+    TEST_CHECK_EQ(0, c.errors);
+    TEST_CHECK_EQ(261, c.last);
+}
+
+static void reader_task(void *arg)
+{
+    while (!reader_stop) {
+        uint32_t newest = written_seq;
+        uint32_t from = newest > READ_BACK ? newest - READ_BACK : 1;
+        read_check_t c = { .next = from };
+
+        event_log_read(from, SIZE_MAX, check_record, &c);
+        // Every record added before the read started, each once and in order
+        if (c.errors != 0 || c.last < newest) {
+            reader_errors++;
+        }
+        // Several reads a tick, so that some of them overlap the flush
+        if (++reader_reads % READS_PER_TICK == 0) {
+            vTaskDelay(1);
+        }
+    }
+    reader_done = true;
+    vTaskDelete(NULL);
+}
+
+/*
+ * Each tick adds half a ring, which wakes the flush task, while the
+ * reader walks flash and ring in the same tick on its own thread, across
+ * sector erases as the log wraps around the partition.
+ */
+static void test_read_during_flush(void)
+{
+    uint32_t seq = newest_seq();
+    uint32_t dropped = event_log_dropped();
+
+    written_seq = seq;
+    xTaskCreatePinnedToCore(reader_task, "reader", 4096, NULL, 3, NULL, tskNO_AFFINITY);
+
+    for (int round = 0; round < READ_ROUNDS; round++) {
+        for (int i = 0; i < EVENT_LOG_RAM_RECORDS / 2; i++) {
+            event_log_add(EVENT_LOG_CUBE_IN, (uint16_t)i, 50000, EVENT_LOG_STATE_NONE);
+            written_seq = ++seq;
+        }
+        vTaskDelay(1);
+    }
+    reader_stop = true;
+    while (!reader_done) {
+        vTaskDelay(1);
+    }
+
+    printf("%lu reads while %d records were flushed through %d sectors\n", (unsigned long)reader_reads,
+           READ_ROUNDS * EVENT_LOG_RAM_RECORDS / 2, SECTORS);
+    TEST_CHECK(reader_reads >= READ_ROUNDS * READS_PER_TICK);
+    TEST_CHECK_EQ(0, reader_errors);
+    TEST_CHECK_EQ(dropped, event_log_dropped());
+    TEST_CHECK_EQ(seq, newest_seq());
+}
+
+typedef struct {
+    read_check_t check;
+    uint32_t     trigger_seq;
+} flush_inside_t;
+
+// Fill the ring to half on the first record and let the flush task run before returning
+static bool flush_on_first(void *ctx, const event_log_record_t *rec)
+{
+    flush_inside_t *f = ctx;
+
+    if (rec->seq == f->trigger_seq) {
+        for (int i = 0; i < EVENT_LOG_RAM_RECORDS / 2 - FLUSH_INSIDE_QUEUED; i++) {
+            event_log_add(EVENT_LOG_CUBE_IN, (uint16_t)i, 50000, EVENT_LOG_STATE_NONE);
+        }
+        vTaskDelay(1);
+    }
+    return check_record(&f->check, rec);
+}
+
+/*
+ * A client streaming /api/events is slow between chunks: the whole ring
+ * can be flushed after the first ring chunk has been passed on. The
+ * records that moved to flash must still come, in order.
+ */
+static void test_flush_inside_read(void)
+{
+    host_sleep_us(FLUSH_WAIT_US);
+
+    uint32_t from = newest_seq() + 1;
+    flush_inside_t f = { .check = { .next = from }, .trigger_seq = from };
+
+    for (int i = 0; i < FLUSH_INSIDE_QUEUED; i++) {
+        event_log_add(EVENT_LOG_ACCEPT, (uint16_t)i, 50000, EVENT_LOG_STATE_NONE);
+    }
+    size_t n = event_log_read(from, SIZE_MAX, flush_on_first, &f);
+
+    TEST_CHECK_EQ(EVENT_LOG_RAM_RECORDS / 2, n);
+    TEST_CHECK_EQ(0, f.check.errors);
+    TEST_CHECK_EQ(from + EVENT_LOG_RAM_RECORDS / 2 - 1, f.check.last);
+}
+
+/*
+ * Power lost after budget bytes of a flush, for every byte of the body
+ * and with the whole record: the body goes first, so a slot carries a
+ * seq only when all of the record made it. seq itself is one 4-byte
+ * program.
+ */
+static void test_torn_flush(void)
+{
+    static const int32_t budgets[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 16 };
+    const size_t body = sizeof(event_log_record_t) - sizeof(uint32_t);
+
+    host_sleep_us(FLUSH_WAIT_US);
+
+    // Torn slots stay in the sector, so follow seq and slot here rather than read them back
+    uint32_t prev = newest_seq();
+    long slot = find_slot(prev);
+    TEST_CHECK(slot >= 0);
+    if (slot < 0) {
+        return;
+    }
+
+    for (size_t i = 0; i < sizeof(budgets) / sizeof(budgets[0]); i++) {
+        slot = (slot + 1) % (SECTORS * SECTOR_RECORDS);
+        prev++;
+        // A torn erase is not what this looks at: stay inside the sector
+        if (slot % SECTOR_RECORDS == 0) {
+            event_log_add(EVENT_LOG_CUBE_IN, 0, 0, EVENT_LOG_STATE_NONE);
+            host_sleep_us(FLUSH_WAIT_US);
+            slot++;
+            prev++;
+        }
+
+        event_log_record_t expected = {
+            .seq = prev,
+            .time_ms = (uint32_t)(host_now_us() / 1000),
+            .weight_g = 1000 + budgets[i],
+            .cube_id = (uint16_t)i,
+            .type = EVENT_LOG_REJECT,
+            .state = EVENT_LOG_STATE_NONE,
+        };
+        event_log_add(expected.type, expected.cube_id, expected.weight_g, expected.state);
+        host_flash_fail_after(budgets[i]);
+        host_sleep_us(FLUSH_WAIT_US);
+        host_flash_fail_after(-1);
+
+        const uint8_t *got = (const uint8_t *)flash_slot(0, (uint32_t)slot);
+        const uint8_t *want = (const uint8_t *)&expected;
+        size_t written = (size_t)budgets[i] < body ? (size_t)budgets[i] : body;
+        bool complete = (size_t)budgets[i] >= sizeof(expected);
+        uint32_t seq;
+
+        memcpy(&seq, got, sizeof(seq));
+        TEST_CHECK_EQ(complete ? expected.seq : SEQ_EMPTY, seq);
+        TEST_CHECK(memcmp(got + sizeof(uint32_t), want + sizeof(uint32_t), written) == 0);
+        for (size_t b = sizeof(uint32_t) + written; b < sizeof(expected); b++) {
+            TEST_CHECK_EQ(0xFF, got[b]);
+        }
+    }
+}
+
+int main(void)
+{
+    host_port_init();
+    host_flash_init(SECTORS * SECTOR_SIZE);
+    make_previous_boot();
+    event_log_init();
+
+    RUN_TEST(test_recover_after_torn_writes);
+    RUN_TEST(test_flush_inside_read);
+    RUN_TEST(test_read_during_flush);
+    RUN_TEST(test_torn_flush);
+    TEST_EXIT();
+}
@@ -0,0 +1,293 @@
+/*
+ * test_hmi_latency.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ *
+ * Operator commands share the logic event queue with sensor, weighing
+ * and robot events. Measures the time from posting a command, as the
+ * HMI handler does, to logic_task applying it: while a plant task keeps
+ * the line busy with cubes, rejects and pallet changes, and on an idle
+ * line.
+ */
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "hal_io.h"
+#include "logic.h"
+#include "conveyor.h"
+#include "outputs.h"
+#include "line_status.h"
+#include "host_port.h"
+#include "host_test.h"
+#include <stdlib.h>
+
+#define CH(ch)              (1u << (ch))
+#define TICK_US             (1000000 / configTICK_RATE_HZ)
+#define BELT_MM_S           500
+#define PLANT_STEP_US       5000        // one input change per debounce time
+#define REJECT_EVERY        8
+#define WRAP_US             1000000
+#define COMMANDS            200
+#define COMMAND_GAP_US      100000      // on a plant step: the command races the plant events
+
+TEST_DEFINE_FAILURES;
+
+QueueHandle_t logic_event_queue = NULL;
+
+static volatile bool plant_running = true;
+static volatile uint32_t plant_events = 0;
+static volatile uint32_t plant_cubes = 0;
+
+// Set by the status listener in logic_task once the awaited layer count shows
+static volatile uint8_t awaited_layers = 0;
+static volatile int64_t applied_us = -1;
+static volatile int64_t applied_wall_us = -1;
+
+static int belt_counts(int64_t t_us, void *ctx)
+{
+    return (int)(t_us * BELT_MM_S / 1000 * CONVEYOR_COUNTS_PER_M / 1000000);
+}
+
+static void on_status(void)
+{
+    line_status_t st;
+
+    line_status_get(&st);
+    if (applied_us < 0 && st.max_layers == awaited_layers) {
+        applied_wall_us = host_wall_us();
+        applied_us = host_now_us();
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/* Plant: io_task, adc_task, the robot link and the wrapper           */
+/* ------------------------------------------------------------------ */
+
+static uint32_t levels = 0;
+
+static void plant_post(const logic_event_t *evt)
+{
+    // As robot_link and tcp_client_task post: waiting for room
+    logic_post_event_wait(evt, portMAX_DELAY);
+    plant_events++;
+}
+
+static void plant_edge(int ch, bool level)
+{
+    levels = level ? levels | CH(ch) : levels & ~CH(ch);
+
+    logic_event_t evt = {
+        .type = LOGIC_EVT_INPUTS,
+        .inputs = {
+            .sensor1 = levels & CH(IO_CH_SENSOR_1),
+            .sensor2 = levels & CH(IO_CH_SENSOR_2),
+            .sensor3 = levels & CH(IO_CH_SENSOR_3),
+            .wrap_done = levels & CH(IO_CH_WRAP_DONE),
+            .changed = CH(ch),
+            .timestamp_us = host_now_us(),
+        },
+    };
+    plant_post(&evt);
+}
+
+static void plant_robot(uint16_t seq, robot_reply_t reply, uint16_t cube_id)
+{
+    logic_event_t evt = {
+        .type = LOGIC_EVT_ROBOT,
+        .robot = { .seq = seq, .reply = reply, .cube_id = cube_id },
+    };
+    plant_post(&evt);
+}
+
+static void plant_task(void *arg)
+{
+    uint16_t cube_id = 1;
+    uint16_t seq = 0;
+    int step = 0;
+    bool heavy = false;
+    int64_t wrap_end = -1;
+
+    while (plant_running) {
+        tcp_command_t cmd;
+        while (xQueueReceive(tcp_command_queue, &cmd, 0) == pdTRUE) {
+            if (cmd.type == CMD_ROBOT_PLACE) {
+                seq++;
+                plant_robot(seq, ROBOT_REPLY_QUEUED, cmd.cube_id);
+                plant_robot(seq, ROBOT_REPLY_ACK, 0);
+                plant_robot(seq, ROBOT_REPLY_DONE, 0);
+            } else if (cmd.type == CMD_INVERTER_START) {
+                wrap_end = host_now_us() + WRAP_US;
+            }
+        }
+        if (wrap_end >= 0 && host_now_us() >= wrap_end) {
+            wrap_end = -1;
+            plant_edge(IO_CH_WRAP_DONE, true);
+            plant_edge(IO_CH_WRAP_DONE, false);
+        }
+
+        // One cube every eight steps, every eighth one heavy and pushed off after T2
+        switch (step++) {
+            case 0:
+                heavy = plant_cubes % REJECT_EVERY == REJECT_EVERY - 1;
+                plant_edge(IO_CH_SENSOR_1, true);
+                break;
+            case 1:
+                plant_edge(IO_CH_SENSOR_1, false);
+                break;
+            case 2: {
+                logic_event_t evt = {
+                    .type = LOGIC_EVT_WEIGH_DONE,
+                    .weigh = {
+                        .status = WEIGH_RESULT_STABLE,
+                        .mean_g = heavy ? 53000 : 50000,
+                        .raw_g = heavy ? 53000 : 50000,
+                        .cube_id = cube_id,
+                    },
+                };
+                plant_post(&evt);
+                break;
+            }
+            case 3:
+                plant_edge(IO_CH_SENSOR_2, true);
+                break;
+            case 4:
+                plant_edge(IO_CH_SENSOR_2, false);
+                break;
+            case 5:
+                if (!heavy) {
+                    plant_edge(IO_CH_SENSOR_3, true);
+                }
+                break;
+            case 6:
+                if (!heavy) {
+                    plant_edge(IO_CH_SENSOR_3, false);
+                }
+                break;
+            default:
+                step = 0;
+                plant_cubes++;
+                cube_id++;
+                break;
+        }
+        host_sleep_us(PLANT_STEP_US);
+    }
+    vTaskDelete(NULL);
+}
+
+/* ------------------------------------------------------------------ */
+/* Tests                                                              */
+/* ------------------------------------------------------------------ */
+
+typedef struct {
+    int64_t virtual_us;
+    int64_t wall_us;
+    bool    posted;
+} latency_t;
+
+// Post SET_LAYERS as the HMI handler does and wait for logic to show it
+static latency_t command_latency(uint8_t layers)
+{
+    latency_t lat = { -1, -1, false };
+    logic_event_t evt = {
+        .type = LOGIC_EVT_HMI,
+        .hmi = { .id = HMI_CMD_SET_LAYERS, .layers = layers },
+    };
+
+    applied_us = -1;
+    awaited_layers = layers;
+    int64_t start = host_now_us();
+    int64_t start_wall = host_wall_us();
+    lat.posted = logic_post_event(&evt) == pdTRUE;
+    if (!lat.posted) {
+        return lat;
+    }
+    while (applied_us < 0 && host_now_us() - start < 1000000) {
+        vTaskDelay(1);
+    }
+    if (applied_us >= 0) {
+        lat.virtual_us = applied_us - start;
+        lat.wall_us = applied_wall_us - start_wall;
+    }
+    return lat;
+}
+
+static int cmp_i64(const void *a, const void *b)
+{
+    int64_t x = *(const int64_t *)a;
+    int64_t y = *(const int64_t *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+static void test_latency_under_sensor_load(void)
+{
+    static int64_t wall[COMMANDS];
+    int64_t worst_virtual = 0;
+    int dropped = 0;
+    int lost = 0;
+    uint32_t events_before = plant_events;
+    int64_t start = host_now_us();
+
+    for (int i = 0; i < COMMANDS; i++) {
+        host_sleep_us(COMMAND_GAP_US);
+        latency_t lat = command_latency(i % 2 ? 8 : 10);
+        if (!lat.posted) {
+            dropped++;
+            continue;
+        }
+        if (lat.virtual_us < 0) {
+            lost++;
+            continue;
+        }
+        wall[i] = lat.wall_us;
+        if (lat.virtual_us > worst_virtual) {
+            worst_virtual = lat.virtual_us;
+        }
+    }
+    double seconds = (host_now_us() - start) / 1e6;
+
+    // Never refused for a full queue, never left waiting behind sensor traffic
+    TEST_CHECK_EQ(0, dropped);
+    TEST_CHECK_EQ(0, lost);
+    TEST_CHECK(worst_virtual <= TICK_US);
+
+    qsort(wall, COMMANDS, sizeof(wall[0]), cmp_i64);
+    printf("%d commands among %.0f plant events/s (%lu cubes): applied within %lld us of line time, "
+           "wall p50 %lld us, p99 %lld us, max %lld us\n",
+           COMMANDS, (plant_events - events_before) / seconds, (unsigned long)plant_cubes,
+           (long long)worst_virtual, (long long)wall[COMMANDS / 2], (long long)wall[COMMANDS * 99 / 100],
+           (long long)wall[COMMANDS - 1]);
+}
+
+static void test_latency_idle_line(void)
+{
+    plant_running = false;
+    host_sleep_us(2000000);
+
+    // Nothing else arrives: the command alone has to wake logic_task
+    uint32_t events = plant_events;
+    latency_t lat = command_latency(5);
+    TEST_CHECK(lat.posted);
+    TEST_CHECK(lat.virtual_us >= 0);
+    TEST_CHECK(lat.virtual_us <= TICK_US);
+    TEST_CHECK_EQ(events, plant_events);
+}
+
+int main(void)
+{
+    host_port_init();
+    logic_event_queue = xQueueCreate(32, sizeof(logic_event_t));
+    host_pcnt_set_source(belt_counts, NULL);
+    conveyor_init();
+    outputs_init();
+    line_status_set_listener(on_status);
+    start_logic_task();
+    host_sleep_us(100000);
+    xTaskCreatePinnedToCore(plant_task, "plant", 4096, NULL, 5, NULL, 0);
+
+    RUN_TEST(test_latency_under_sensor_load);
+    RUN_TEST(test_latency_idle_line);
+    TEST_EXIT();
+}
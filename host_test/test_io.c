@@ -0,0 +1,131 @@
+/*
+ * test_io.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ *
+ * Drives the input path from the host HAL binding: edges from
+ * hal_io_host_set_inputs() go through the GPIO ISR, the edge ring and
+ * io_task, and come out as LOGIC_EVT_INPUTS events.
+ */
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "hal_io.h"
+#include "io.h"
+#include "logic.h"
+#include "host_port.h"
+#include "host_test.h"
+
+#define TICK_US     (1000000 / configTICK_RATE_HZ)
+#define CH(ch)      (1u << (ch))
+
+TEST_DEFINE_FAILURES;
+
+QueueHandle_t logic_event_queue = NULL;
+
+static bool next_inputs(inputs_t *out, uint32_t wait_ms)
+{
+    logic_event_t evt;
+
+    while (xQueueReceive(logic_event_queue, &evt, pdMS_TO_TICKS(wait_ms)) == pdTRUE) {
+        if (evt.type == LOGIC_EVT_INPUTS) {
+            *out = evt.inputs;
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * The edges before io_task exists are not drained: the first
+ * IO_EDGE_RING_SIZE are kept and the rest are lost. The last kept edge
+ * is a falling one while the pin ends high, so without a resync the
+ * debounced level would stay low.
+ */
+static void test_overrun_resyncs(void)
+{
+    uint32_t levels = 0;
+    inputs_t in;
+
+    for (int i = 0; i < IO_EDGE_RING_SIZE + 36; i++) {
+        levels ^= CH(IO_CH_SENSOR_1);
+        hal_io_host_set_inputs(levels);
+    }
+    start_io_task();
+    host_sleep_us(1000);
+
+    // Lost as well, but its interrupt wakes io_task
+    int64_t edge = host_now_us();
+    hal_io_host_set_inputs(levels ^ CH(IO_CH_SENSOR_1));
+    TEST_CHECK_EQ(CH(IO_CH_SENSOR_1), hal_io_read_inputs());
+    TEST_CHECK_EQ(37, io_get_edge_overruns());
+
+    TEST_CHECK(next_inputs(&in, 100));
+    TEST_CHECK(in.sensor1);
+    TEST_CHECK_EQ(CH(IO_CH_SENSOR_1), in.changed);
+    TEST_CHECK_EQ(edge, in.timestamp_us);
+    TEST_CHECK(!next_inputs(&in, 100));
+}
+
+static void test_bounce_confirmed_once(void)
+{
+    inputs_t in;
+    int64_t last_edge = 0;
+
+    host_sleep_until(1000000);
+    // T2 photo-eye chattering for 600 us before it settles high
+    for (int i = 0; i < 5; i++) {
+        hal_io_host_set_inputs(hal_io_read_inputs() ^ CH(IO_CH_SENSOR_2));
+        last_edge = host_now_us();
+        host_sleep_us(150);
+    }
+
+    TEST_CHECK(next_inputs(&in, 100));
+    TEST_CHECK(in.sensor2);
+    TEST_CHECK(in.sensor1);
+    TEST_CHECK_EQ(CH(IO_CH_SENSOR_2), in.changed);
+    TEST_CHECK_EQ(last_edge, in.timestamp_us);
+    // Confirmed after the hold time, at the first tick io_task wakes on after it
+    int64_t latency = host_now_us() - last_edge;
+    TEST_CHECK(latency >= IO_DEBOUNCE_US);
+    TEST_CHECK(latency <= IO_DEBOUNCE_US + 2 * TICK_US);
+    TEST_CHECK(!next_inputs(&in, 100));
+}
+
+static void test_glitch_ignored(void)
+{
+    inputs_t in;
+
+    hal_io_host_set_inputs(hal_io_read_inputs() | CH(IO_CH_SENSOR_3));
+    host_sleep_us(IO_DEBOUNCE_US / 2);
+    hal_io_host_set_inputs(hal_io_read_inputs() & ~CH(IO_CH_SENSOR_3));
+    TEST_CHECK(!next_inputs(&in, 100));
+}
+
+static void test_simultaneous_changes(void)
+{
+    inputs_t in;
+    int64_t edge = host_now_us();
+
+    hal_io_host_set_inputs((hal_io_read_inputs() | CH(IO_CH_WRAP_DONE)) & ~CH(IO_CH_SENSOR_1));
+    TEST_CHECK(next_inputs(&in, 100));
+    TEST_CHECK_EQ(CH(IO_CH_WRAP_DONE) | CH(IO_CH_SENSOR_1), in.changed);
+    TEST_CHECK(in.wrap_done);
+    TEST_CHECK(!in.sensor1);
+    TEST_CHECK(in.sensor2);
+    TEST_CHECK_EQ(edge, in.timestamp_us);
+}
+
+int main(void)
+{
+    host_port_init();
+    logic_event_queue = xQueueCreate(32, sizeof(logic_event_t));
+    io_init();
+
+    RUN_TEST(test_overrun_resyncs);
+    RUN_TEST(test_bounce_confirmed_once);
+    RUN_TEST(test_glitch_ignored);
+    RUN_TEST(test_simultaneous_changes);
+    TEST_EXIT();
+}
@@ -0,0 +1,270 @@
+/*
+ * test_json_writer.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ *
+ * Output of the JSON writer, and a benchmark of the status document
+ * against the cJSON code it replaced: bytes per second and heap calls
+ * per document. cJSON is taken from ESP-IDF (IDF_PATH) when it is
+ * installed; without it only the writer is measured.
+ *
+ * The heap is counted with the linker's --wrap of malloc and friends,
+ * which sees every call made from the code linked into this program.
+ */
+
+#include "json_writer.h"
+#include "host_port.h"
+#include "host_test.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#if BENCH_CJSON
+#include "cJSON.h"
+#endif
+
+#define STATUS_JSON_MAX     384         // HTTP_SERVER_STATUS_JSON_MAX
+#define BENCH_DOCS          200000
+
+TEST_DEFINE_FAILURES;
+
+static uint32_t heap_calls = 0;
+static uint64_t heap_bytes = 0;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *p, size_t size);
+void __real_free(void *p);
+
+void *__wrap_malloc(size_t size)
+{
+    heap_calls++;
+    heap_bytes += size;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t n, size_t size)
+{
+    heap_calls++;
+    heap_bytes += n * size;
+    return __real_calloc(n, size);
+}
+
+void *__wrap_realloc(void *p, size_t size)
+{
+    heap_calls++;
+    heap_bytes += size;
+    return __real_realloc(p, size);
+}
+
+void __wrap_free(void *p)
+{
+    if (p != NULL) {
+        heap_calls++;
+    }
+    __real_free(p);
+}
+
+// The fields of line_status_t, as http_server_status_json() writes the full object
+typedef struct {
+    int32_t weight_g;
+    bool    sensor1, sensor2, sensor3, wrap_done, robot, inverter;
+    uint8_t wrap_progress, state, layers, max_layers, cubes;
+} status_t;
+
+static const status_t status = {
+    .weight_g = 50120, .sensor1 = true, .sensor3 = true, .robot = true, .inverter = true,
+    .wrap_progress = 75, .state = 1, .layers = 3, .max_layers = 5, .cubes = 4,
+};
+
+static const char status_text[] =
+    "{\"weight\":50.12,\"weightStatus\":\"OK\",\"sensor1\":true,\"sensor2\":false,"
+    "\"sensor3\":true,\"wrap_done\":false,\"robot\":true,\"inverter\":true,"
+    "\"wrapProgress\":75,\"state\":1,\"layers\":3,\"maxLayers\":5,\"cubes\":4}";
+
+static int status_writer(char *buf, size_t cap, const status_t *s)
+{
+    json_writer_t w;
+
+    json_writer_init(&w, buf, cap);
+    json_writer_object_begin(&w, NULL);
+    json_writer_fixed(&w, "weight", s->weight_g / 10, 2);
+    json_writer_str(&w, "weightStatus", "OK");
+    json_writer_bool(&w, "sensor1", s->sensor1);
+    json_writer_bool(&w, "sensor2", s->sensor2);
+    json_writer_bool(&w, "sensor3", s->sensor3);
+    json_writer_bool(&w, "wrap_done", s->wrap_done);
+    json_writer_bool(&w, "robot", s->robot);
+    json_writer_bool(&w, "inverter", s->inverter);
+    json_writer_uint(&w, "wrapProgress", s->wrap_progress);
+    json_writer_uint(&w, "state", s->state);
+    json_writer_uint(&w, "layers", s->layers);
+    json_writer_uint(&w, "maxLayers", s->max_layers);
+    json_writer_uint(&w, "cubes", s->cubes);
+    json_writer_object_end(&w);
+    return json_writer_finish(&w);
+}
+
+#if BENCH_CJSON
+// The status handler before the writer: a tree, a heap string, and both freed per poll
+static int status_cjson(char *buf, size_t cap, const status_t *s)
+{
+    cJSON *root = cJSON_CreateObject();
+
+    cJSON_AddNumberToObject(root, "weight", s->weight_g / 1000.0);
+    cJSON_AddStringToObject(root, "weightStatus", "OK");
+    cJSON_AddBoolToObject(root, "sensor1", s->sensor1);
+    cJSON_AddBoolToObject(root, "sensor2", s->sensor2);
+    cJSON_AddBoolToObject(root, "sensor3", s->sensor3);
+    cJSON_AddBoolToObject(root, "wrap_done", s->wrap_done);
+    cJSON_AddBoolToObject(root, "robot", s->robot);
+    cJSON_AddBoolToObject(root, "inverter", s->inverter);
+    cJSON_AddNumberToObject(root, "wrapProgress", s->wrap_progress);
+    cJSON_AddNumberToObject(root, "state", s->state);
+    cJSON_AddNumberToObject(root, "layers", s->layers);
+    cJSON_AddNumberToObject(root, "maxLayers", s->max_layers);
+    cJSON_AddNumberToObject(root, "cubes", s->cubes);
+
+    char *text = cJSON_PrintUnformatted(root);
+    int len = -1;
+    if (text != NULL) {
+        len = (int)strlen(text);
+        if ((size_t)len < cap) {
+            memcpy(buf, text, (size_t)len + 1);
+        } else {
+            len = -1;
+        }
+    }
+    cJSON_free(text);
+    cJSON_Delete(root);
+    return len;
+}
+#endif
+
+typedef int (*status_fn_t)(char *buf, size_t cap, const status_t *s);
+
+static void bench(const char *name, status_fn_t fn)
+{
+    static char buf[STATUS_JSON_MAX];
+    uint64_t bytes = 0;
+    uint32_t calls = heap_calls;
+    uint64_t allocated = heap_bytes;
+    int64_t start = host_wall_us();
+
+    for (uint32_t i = 0; i < BENCH_DOCS; i++) {
+        int len = fn(buf, sizeof(buf), &status);
+        bytes += len > 0 ? (uint64_t)len : 0;
+    }
+    int64_t wall_us = host_wall_us() - start;
+
+    printf("%-12s %7.1f MB/s, %5.2f heap calls and %6.1f bytes allocated per document\n", name,
+           wall_us > 0 ? bytes / (double)wall_us : 0.0, (heap_calls - calls) / (double)BENCH_DOCS,
+           (heap_bytes - allocated) / (double)BENCH_DOCS);
+}
+
+static void test_status_document(void)
+{
+    char buf[STATUS_JSON_MAX];
+
+    TEST_CHECK_EQ(sizeof(status_text) - 1, status_writer(buf, sizeof(buf), &status));
+    TEST_CHECK(strcmp(buf, status_text) == 0);
+}
+
+static void test_escapes_and_numbers(void)
+{
+    char buf[128];
+    json_writer_t w;
+
+    json_writer_init(&w, buf, sizeof(buf));
+    json_writer_array_begin(&w, NULL);
+    json_writer_str(&w, NULL, "a\"b\\c\n\x01");
+    json_writer_int(&w, NULL, INT64_MIN);
+    json_writer_fixed(&w, NULL, -5, 2);
+    json_writer_object_begin(&w, NULL);
+    json_writer_object_end(&w);
+    json_writer_array_end(&w);
+    TEST_CHECK(json_writer_finish(&w) > 0);
+    TEST_CHECK(strcmp(buf, "[\"a\\\"b\\\\c\\n\\u0001\",-9223372036854775808,-0.05,{}]") == 0);
+}
+
+static void test_overflow(void)
+{
+    char buf[STATUS_JSON_MAX];
+
+    TEST_CHECK_EQ(-1, status_writer(buf, 32, &status));
+    // Exactly fitting, with the NUL
+    TEST_CHECK_EQ(sizeof(status_text) - 1, status_writer(buf, sizeof(status_text), &status));
+    TEST_CHECK_EQ(-1, status_writer(buf, sizeof(status_text) - 1, &status));
+}
+
+typedef struct {
+    char   out[STATUS_JSON_MAX];
+    size_t len;
+    int    chunks;
+} chunks_t;
+
+static bool collect(void *ctx, const char *data, size_t len)
+{
+    chunks_t *c = ctx;
+
+    if (c->len + len >= sizeof(c->out)) {
+        return false;
+    }
+    memcpy(c->out + c->len, data, len);
+    c->len += len;
+    c->chunks++;
+    return true;
+}
+
+static void test_flush_in_chunks(void)
+{
+    char buf[16];
+    chunks_t c = { 0 };
+    json_writer_t w;
+
+    // A buffer smaller than the document, emptied into the callback as for httpd_resp_send_chunk
+    json_writer_init(&w, buf, sizeof(buf));
+    json_writer_set_flush(&w, collect, &c);
+    json_writer_object_begin(&w, NULL);
+    json_writer_str(&w, "weightStatus", "NIESTABILNA");
+    json_writer_uint(&w, "cubes", 12);
+    json_writer_object_end(&w);
+    TEST_CHECK_EQ(0, json_writer_finish(&w));
+    TEST_CHECK(c.chunks > 1);
+    TEST_CHECK_EQ(strlen("{\"weightStatus\":\"NIESTABILNA\",\"cubes\":12}"), c.len);
+    TEST_CHECK(memcmp(c.out, "{\"weightStatus\":\"NIESTABILNA\",\"cubes\":12}", c.len) == 0);
+}
+
+static void test_no_heap(void)
+{
+    char buf[STATUS_JSON_MAX];
+    uint32_t calls = heap_calls;
+
+    for (int i = 0; i < 1000; i++) {
+        status_writer(buf, sizeof(buf), &status);
+    }
+    TEST_CHECK_EQ(calls, heap_calls);
+}
+
+static void test_bench(void)
+{
+    bench("json_writer", status_writer);
+#if BENCH_CJSON
+    char buf[STATUS_JSON_MAX];
+    TEST_CHECK(status_cjson(buf, sizeof(buf), &status) > 0);
+    bench("cJSON", status_cjson);
+#else
+    printf("cJSON           skipped, set IDF_PATH to an ESP-IDF tree to compare\n");
+#endif
+}
+
+int main(void)
+{
+    RUN_TEST(test_status_document);
+    RUN_TEST(test_escapes_and_numbers);
+    RUN_TEST(test_overflow);
+    RUN_TEST(test_flush_in_chunks);
+    RUN_TEST(test_no_heap);
+    RUN_TEST(test_bench);
+    TEST_EXIT();
+}
@@ -0,0 +1,257 @@
+/*
+ * test_logic_events.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ *
+ * logic_task on the event queue: how many events per second it handles
+ * when fed back to back, and a reject whose ejector stroke is timed on
+ * the belt while the next cube is tracked.
+ */
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "hal_io.h"
+#include "logic.h"
+#include "conveyor.h"
+#include "outputs.h"
+#include "line_status.h"
+#include "dlog.h"
+#include "host_port.h"
+#include "host_test.h"
+
+#define CH(ch)          (1u << (ch))
+#define BELT_MM_S       500
+#define CUBE_G          50000
+#define HEAVY_G         53000
+#define BURST_PALLETS   250
+#define PALLET_CUBES    (5 * PALLET_CUBES_PER_LAYER)     // default max_layers
+#define CUBES_AHEAD     4       // cubes fed before the robot has been given the first of them
+
+TEST_DEFINE_FAILURES;
+
+QueueHandle_t logic_event_queue = NULL;
+
+static uint32_t levels = 0;
+static uint16_t next_cube_id = 1;
+static uint32_t posted = 0;
+static uint32_t places = 0;
+static uint32_t wraps = 0;
+
+static int belt_counts(int64_t t_us, void *ctx)
+{
+    return (int)(t_us * BELT_MM_S / 1000 * CONVEYOR_COUNTS_PER_M / 1000000);
+}
+
+static void post(const logic_event_t *evt)
+{
+    xQueueSend(logic_event_queue, evt, portMAX_DELAY);
+    posted++;
+}
+
+static void post_edge(int ch, bool level)
+{
+    levels = level ? levels | CH(ch) : levels & ~CH(ch);
+
+    logic_event_t evt = {
+        .type = LOGIC_EVT_INPUTS,
+        .inputs = {
+            .sensor1 = levels & CH(IO_CH_SENSOR_1),
+            .sensor2 = levels & CH(IO_CH_SENSOR_2),
+            .sensor3 = levels & CH(IO_CH_SENSOR_3),
+            .wrap_done = levels & CH(IO_CH_WRAP_DONE),
+            .changed = CH(ch),
+            .timestamp_us = host_now_us(),
+        },
+    };
+    post(&evt);
+}
+
+static void post_robot(uint16_t seq, robot_reply_t reply, uint16_t cube_id)
+{
+    logic_event_t evt = {
+        .type = LOGIC_EVT_ROBOT,
+        .robot = { .seq = seq, .reply = reply, .cube_id = cube_id },
+    };
+    post(&evt);
+}
+
+static void post_weight(uint16_t cube_id, int32_t grams)
+{
+    logic_event_t evt = {
+        .type = LOGIC_EVT_WEIGH_DONE,
+        .weigh = { .status = WEIGH_RESULT_STABLE, .mean_g = grams, .raw_g = grams, .cube_id = cube_id },
+    };
+    post(&evt);
+}
+
+/*
+ * Play tcp_client_task, the robot and the wrapper: every PLACE_CUBE is
+ * queued, acknowledged and placed at once, every wrap ends at once.
+ */
+static bool serve_command(TickType_t wait)
+{
+    tcp_command_t cmd;
+
+    if (xQueueReceive(tcp_command_queue, &cmd, wait) != pdTRUE) {
+        return false;
+    }
+    if (cmd.type == CMD_ROBOT_PLACE) {
+        uint16_t seq = (uint16_t)(++places);
+        post_robot(seq, ROBOT_REPLY_QUEUED, cmd.cube_id);
+        post_robot(seq, ROBOT_REPLY_ACK, 0);
+        post_robot(seq, ROBOT_REPLY_DONE, 0);
+    } else if (cmd.type == CMD_INVERTER_START) {
+        wraps++;
+        post_edge(IO_CH_WRAP_DONE, true);
+        post_edge(IO_CH_WRAP_DONE, false);
+    }
+    return true;
+}
+
+static void serve_commands(void)
+{
+    while (serve_command(0)) {
+    }
+}
+
+// Let logic_task empty its queue; virtual time only moves once it is idle
+static void settle(void)
+{
+    do {
+        vTaskDelay(1);
+        serve_commands();
+    } while (uxQueueMessagesWaiting(logic_event_queue) > 0 || uxQueueMessagesWaiting(tcp_command_queue) > 0);
+}
+
+static uint16_t take_cube_id(void)
+{
+    uint16_t id = next_cube_id++;
+
+    if (next_cube_id == 0) {
+        next_cube_id = 1;
+    }
+    return id;
+}
+
+// One good cube from T1 to the robot, as io_task, adc_task and the robot link report it
+static void feed_good_cube(void)
+{
+    uint16_t id = take_cube_id();
+
+    post_edge(IO_CH_SENSOR_1, true);
+    post_edge(IO_CH_SENSOR_1, false);
+    post_weight(id, CUBE_G);
+    post_edge(IO_CH_SENSOR_2, true);
+    post_edge(IO_CH_SENSOR_2, false);
+    post_edge(IO_CH_SENSOR_3, true);
+    post_edge(IO_CH_SENSOR_3, false);
+    serve_commands();
+}
+
+static void test_events_per_second(void)
+{
+    const uint32_t cubes = BURST_PALLETS * PALLET_CUBES;
+    uint32_t posted_before = posted;
+    int64_t start = host_wall_us();
+
+    for (uint32_t i = 0; i < cubes; i++) {
+        // The robot is the pace of the line: the cubes in flight stay within the tracker
+        while (places + CUBES_AHEAD < i) {
+            if (!serve_command(pdMS_TO_TICKS(1000))) {
+                TEST_CHECK(!"robot never given the cube");
+                return;
+            }
+        }
+        feed_good_cube();
+    }
+    settle();
+    int64_t wall_us = host_wall_us() - start;
+
+    uint32_t events = posted - posted_before;
+    printf("%lu events (%lu cubes, %lu pallets) in %lld ms: %.0f events/s\n",
+           (unsigned long)events, (unsigned long)cubes, (unsigned long)wraps,
+           (long long)(wall_us / 1000), wall_us > 0 ? events * 1e6 / wall_us : 0.0);
+
+    // Nothing lost on the way: every cube placed, every pallet wrapped
+    line_status_t st;
+    line_status_get(&st);
+    TEST_CHECK_EQ(cubes, places);
+    TEST_CHECK_EQ(BURST_PALLETS, wraps);
+    TEST_CHECK_EQ(0, st.cubes);
+    TEST_CHECK_EQ(0, st.layers);
+    TEST_CHECK_EQ(STATE_IDLE, st.state);
+}
+
+/*
+ * The ejector stroke runs on belt position while logic_task keeps
+ * handling events: the next cube is tracked and weighed during it.
+ */
+static void test_reject_does_not_block_next_cube(void)
+{
+    const int64_t offset_us = 150LL * 1000000 / BELT_MM_S;     // T2 to the paddle
+    const int64_t stroke_us = 200LL * 1000000 / BELT_MM_S;
+    line_status_t st;
+
+    uint16_t heavy = take_cube_id();
+    post_edge(IO_CH_SENSOR_1, true);
+    post_edge(IO_CH_SENSOR_1, false);
+    post_weight(heavy, HEAVY_G);
+    settle();
+
+    int64_t t2 = host_now_us();
+    post_edge(IO_CH_SENSOR_2, true);
+    post_edge(IO_CH_SENSOR_2, false);
+
+    // The next cube arrives right behind it
+    host_sleep_us(20000);
+    uint16_t next = take_cube_id();
+    post_edge(IO_CH_SENSOR_1, true);
+    post_edge(IO_CH_SENSOR_1, false);
+    settle();
+    line_status_get(&st);
+    TEST_CHECK_EQ(1, st.cubes);
+    TEST_CHECK_EQ(0, hal_io_read_outputs() & IO_OUT_BIT(IO_OUT_EJECTOR));
+
+    host_sleep_until(t2 + offset_us + 20000);
+    TEST_CHECK(hal_io_read_outputs() & IO_OUT_BIT(IO_OUT_EJECTOR));
+
+    // Weighed and passed on while the paddle is still out
+    post_weight(next, CUBE_G);
+    post_edge(IO_CH_SENSOR_2, true);
+    post_edge(IO_CH_SENSOR_2, false);
+    settle();
+    TEST_CHECK(hal_io_read_outputs() & IO_OUT_BIT(IO_OUT_EJECTOR));
+    line_status_get(&st);
+    TEST_CHECK_EQ(LINE_WEIGHT_OK, st.weight_status);
+
+    host_sleep_until(t2 + offset_us + stroke_us + 20000);
+    settle();
+    TEST_CHECK_EQ(0, hal_io_read_outputs() & IO_OUT_BIT(IO_OUT_EJECTOR));
+    TEST_CHECK(hal_io_read_outputs() & IO_OUT_BIT(IO_OUT_LED_RED));
+
+    uint32_t places_before = places;
+    post_edge(IO_CH_SENSOR_3, true);
+    post_edge(IO_CH_SENSOR_3, false);
+    settle();
+    TEST_CHECK_EQ(places_before + 1, places);
+    line_status_get(&st);
+    TEST_CHECK_EQ(0, st.cubes);
+}
+
+int main(void)
+{
+    host_port_init();
+    dlog_init();
+    logic_event_queue = xQueueCreate(32, sizeof(logic_event_t));
+    host_pcnt_set_source(belt_counts, NULL);
+    conveyor_init();
+    outputs_init();
+    start_logic_task();
+    // Let the speed measurement see the belt moving
+    host_sleep_us(100000);
+
+    RUN_TEST(test_events_per_second);
+    RUN_TEST(test_reject_does_not_block_next_cube);
+    TEST_EXIT();
+}
@@ -0,0 +1,288 @@
+/*
+ * test_modbus_tcp.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ *
+ * Modbus TCP client against the stand-in server over loopback: one
+ * long-lived connection, pipelined requests matched by transaction ID,
+ * exceptions, timeouts with late answers and reconnects.
+ */
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "modbus_tcp.h"
+#include "modbus_server.h"
+#include "host_port.h"
+#include "host_test.h"
+
+#define TEST_PORT       15502
+#define TEST_UNIT       0x01
+#define POLL_MS         10          // as tcp_client_task
+
+TEST_DEFINE_FAILURES;
+
+typedef struct {
+    bool                done;
+    modbus_req_status_t status;
+    uint8_t             exception;
+    uint16_t            value[MODBUS_TCP_MAX_WRITE_REGS];
+    uint16_t            count;
+    int64_t             done_us;
+    int                 order;
+} result_t;
+
+static modbus_tcp_client_t client;
+static modbus_server_t *server;
+static int completions = 0;
+
+static void on_done(void *ctx, modbus_req_status_t status, uint8_t exception,
+                    const uint16_t *regs, uint16_t count)
+{
+    result_t *r = ctx;
+
+    r->done = true;
+    r->status = status;
+    r->exception = exception;
+    r->count = count;
+    for (uint16_t i = 0; i < count && i < MODBUS_TCP_MAX_WRITE_REGS; i++) {
+        r->value[i] = regs[i];
+    }
+    r->done_us = host_now_us();
+    r->order = completions++;
+}
+
+// One pass of the tcp_client_task loop for this client
+static void pump(void)
+{
+    int fd = modbus_tcp_fd(&client);
+    bool readable = false;
+    bool writable = false;
+
+    if (fd >= 0) {
+        fd_set rfds, wfds;
+        FD_ZERO(&rfds);
+        FD_ZERO(&wfds);
+        FD_SET(fd, &rfds);
+        if (modbus_tcp_wants_write(&client)) {
+            FD_SET(fd, &wfds);
+        }
+        struct timeval tv = { .tv_sec = 0, .tv_usec = POLL_MS * 1000 };
+        int ready = select(fd + 1, &rfds, &wfds, NULL, &tv);
+        readable = ready > 0 && FD_ISSET(fd, &rfds);
+        writable = ready > 0 && FD_ISSET(fd, &wfds);
+    } else {
+        vTaskDelay(pdMS_TO_TICKS(POLL_MS));
+    }
+    modbus_tcp_poll(&client, readable, writable);
+}
+
+static void pump_until(const result_t *r, uint32_t max_ms)
+{
+    int64_t end = host_now_us() + (int64_t)max_ms * 1000;
+
+    while (!r->done && host_now_us() < end) {
+        pump();
+    }
+}
+
+static void pump_for(uint32_t ms)
+{
+    int64_t end = host_now_us() + (int64_t)ms * 1000;
+
+    while (host_now_us() < end) {
+        pump();
+    }
+}
+
+static void test_write_then_read(void)
+{
+    result_t w = { 0 };
+    result_t r = { 0 };
+
+    TEST_CHECK_EQ(ESP_OK, modbus_tcp_write_single(&client, 0x2000, 0x0001, 500, on_done, &w));
+    pump_until(&w, 2000);
+    TEST_CHECK(w.done);
+    TEST_CHECK_EQ(MODBUS_REQ_OK, w.status);
+    TEST_CHECK_EQ(0x0001, modbus_server_get_reg(server, 0x2000));
+
+    TEST_CHECK_EQ(ESP_OK, modbus_tcp_read_holding(&client, 0x2000, 1, 500, on_done, &r));
+    pump_until(&r, 500);
+    TEST_CHECK_EQ(MODBUS_REQ_OK, r.status);
+    TEST_CHECK_EQ(1, r.count);
+    TEST_CHECK_EQ(0x0001, r.value[0]);
+    TEST_CHECK_EQ(1, modbus_server_connections(server));
+}
+
+static void test_pipelined_out_of_order(void)
+{
+    result_t r[MODBUS_TCP_MAX_PENDING] = { 0 };
+    result_t extra = { 0 };
+    uint32_t requests = modbus_server_requests(server);
+
+    for (int i = 0; i < MODBUS_TCP_MAX_PENDING; i++) {
+        modbus_server_set_reg(server, 100 + i, 1000 + i);
+    }
+    modbus_server_set_delay_ms(server, 20);
+    modbus_server_set_reverse(server, true);
+
+    int64_t start = host_now_us();
+    for (int i = 0; i < MODBUS_TCP_MAX_PENDING; i++) {
+        TEST_CHECK_EQ(ESP_OK, modbus_tcp_read_holding(&client, 100 + i, 1, 500, on_done, &r[i]));
+    }
+    TEST_CHECK_EQ(ESP_ERR_NO_MEM, modbus_tcp_read_holding(&client, 0, 1, 500, on_done, &extra));
+
+    pump_until(&r[0], 500);
+    TEST_CHECK_EQ(requests + MODBUS_TCP_MAX_PENDING, modbus_server_requests(server));
+    for (int i = 0; i < MODBUS_TCP_MAX_PENDING; i++) {
+        TEST_CHECK(r[i].done);
+        TEST_CHECK_EQ(MODBUS_REQ_OK, r[i].status);
+        TEST_CHECK_EQ(1000 + i, r[i].value[0]);
+        // Answered newest first, matched by transaction ID all the same
+        TEST_CHECK(i == 0 || r[i].order < r[i - 1].order);
+        // All on the wire at once: one server delay, not eight
+        TEST_CHECK(r[i].done_us - start < 2 * 20000);
+    }
+    TEST_CHECK(!extra.done);
+
+    modbus_server_set_delay_ms(server, 0);
+    modbus_server_set_reverse(server, false);
+}
+
+static void test_write_multiple(void)
+{
+    uint16_t values[MODBUS_TCP_MAX_WRITE_REGS];
+    result_t w = { 0 };
+    result_t r = { 0 };
+
+    for (int i = 0; i < MODBUS_TCP_MAX_WRITE_REGS; i++) {
+        values[i] = (uint16_t)(0xA500 + i);
+    }
+    TEST_CHECK_EQ(ESP_ERR_INVALID_ARG,
+                  modbus_tcp_write_multiple(&client, 0x200, values, MODBUS_TCP_MAX_WRITE_REGS + 1, 500, on_done, &w));
+    TEST_CHECK_EQ(ESP_ERR_INVALID_ARG,
+                  modbus_tcp_read_holding(&client, 0x200, MODBUS_TCP_MAX_READ_REGS + 1, 500, on_done, &r));
+
+    TEST_CHECK_EQ(ESP_OK, modbus_tcp_write_multiple(&client, 0x200, values, MODBUS_TCP_MAX_WRITE_REGS,
+                                                    500, on_done, &w));
+    TEST_CHECK_EQ(ESP_OK, modbus_tcp_read_holding(&client, 0x200, MODBUS_TCP_MAX_WRITE_REGS, 500, on_done, &r));
+    pump_until(&r, 500);
+    TEST_CHECK_EQ(MODBUS_REQ_OK, w.status);
+    TEST_CHECK_EQ(MODBUS_REQ_OK, r.status);
+    TEST_CHECK_EQ(MODBUS_TCP_MAX_WRITE_REGS, r.count);
+    for (int i = 0; i < MODBUS_TCP_MAX_WRITE_REGS; i++) {
+        TEST_CHECK_EQ(values[i], r.value[i]);
+        TEST_CHECK_EQ(values[i], modbus_server_get_reg(server, 0x200 + i));
+    }
+}
+
+static void test_exception(void)
+{
+    result_t r = { 0 };
+
+    TEST_CHECK_EQ(ESP_OK, modbus_tcp_read_holding(&client, MODBUS_SERVER_REGS - 1, 2, 500, on_done, &r));
+    pump_until(&r, 500);
+    TEST_CHECK_EQ(MODBUS_REQ_EXCEPTION, r.status);
+    TEST_CHECK_EQ(0x02, r.exception);
+}
+
+static void test_timeout_then_late_answer(void)
+{
+    result_t slow = { 0 };
+    result_t next = { 0 };
+
+    modbus_server_set_delay_ms(server, 300);
+    int64_t start = host_now_us();
+    TEST_CHECK_EQ(ESP_OK, modbus_tcp_read_holding(&client, 100, 1, 100, on_done, &slow));
+    pump_until(&slow, 500);
+    TEST_CHECK_EQ(MODBUS_REQ_TIMEOUT, slow.status);
+    TEST_CHECK(slow.done_us - start >= 100000);
+    TEST_CHECK(slow.done_us - start <= 100000 + 2 * POLL_MS * 1000);
+
+    // The connection stays up; the late answer must not complete the new request
+    modbus_server_set_delay_ms(server, 0);
+    TEST_CHECK_EQ(ESP_OK, modbus_tcp_read_holding(&client, 101, 1, 500, on_done, &next));
+    pump_until(&next, 500);
+    TEST_CHECK_EQ(MODBUS_REQ_OK, next.status);
+    TEST_CHECK_EQ(1001, next.value[0]);
+
+    int before = completions;
+    pump_for(400);
+    TEST_CHECK_EQ(before, completions);
+    TEST_CHECK(modbus_tcp_connected(&client));
+}
+
+static void test_reconnect(void)
+{
+    result_t lost = { 0 };
+    result_t after = { 0 };
+    uint32_t connections = modbus_server_connections(server);
+    uint32_t requests = modbus_server_requests(server);
+
+    modbus_server_set_delay_ms(server, 50);
+    TEST_CHECK_EQ(ESP_OK, modbus_tcp_read_holding(&client, 100, 1, 1000, on_done, &lost));
+    while (modbus_server_requests(server) == requests) {
+        pump();
+    }
+    modbus_server_disconnect_all(server);
+    pump_until(&lost, 1000);
+    TEST_CHECK_EQ(MODBUS_REQ_DISCONNECTED, lost.status);
+    TEST_CHECK(!modbus_tcp_connected(&client));
+
+    // Queued while down, sent once the backoff has passed
+    modbus_server_set_delay_ms(server, 0);
+    int64_t start = host_now_us();
+    TEST_CHECK_EQ(ESP_OK, modbus_tcp_write_single(&client, 0x2000, 0x0002, 2000, on_done, &after));
+    pump_until(&after, 2000);
+    TEST_CHECK_EQ(MODBUS_REQ_OK, after.status);
+    TEST_CHECK_EQ(0x0002, modbus_server_get_reg(server, 0x2000));
+    TEST_CHECK_EQ(connections + 1, modbus_server_connections(server));
+    TEST_CHECK(after.done_us - start >= MODBUS_TCP_BACKOFF_MIN_MS * 1000 - POLL_MS * 1000);
+}
+
+static void test_persistent_connection(void)
+{
+    enum { COMMANDS = 50 };
+    uint32_t connections = modbus_server_connections(server);
+    int64_t total_us = 0;
+    int64_t max_us = 0;
+
+    for (int i = 0; i < COMMANDS; i++) {
+        result_t w = { 0 };
+        int64_t start = host_now_us();
+        TEST_CHECK_EQ(ESP_OK, modbus_tcp_write_single(&client, 0x2000, (uint16_t)i, 500, on_done, &w));
+        pump_until(&w, 500);
+        TEST_CHECK_EQ(MODBUS_REQ_OK, w.status);
+        total_us += w.done_us - start;
+        if (w.done_us - start > max_us) {
+            max_us = w.done_us - start;
+        }
+        pump_for(50);
+    }
+
+    // No connect per command: latency is bounded by the poll interval
+    TEST_CHECK_EQ(connections, modbus_server_connections(server));
+    TEST_CHECK(max_us <= POLL_MS * 1000);
+    printf("%d commands on one connection, mean %lld us, max %lld us\n",
+           COMMANDS, (long long)(total_us / COMMANDS), (long long)max_us);
+}
+
+int main(void)
+{
+    host_port_init();
+    server = modbus_server_start(TEST_PORT, TEST_UNIT);
+    if (server == NULL) {
+        printf("FAIL cannot listen on port %d\n", TEST_PORT);
+        return EXIT_FAILURE;
+    }
+    modbus_tcp_init(&client, "test", "127.0.0.1", TEST_PORT, TEST_UNIT);
+
+    RUN_TEST(test_write_then_read);
+    RUN_TEST(test_pipelined_out_of_order);
+    RUN_TEST(test_write_multiple);
+    RUN_TEST(test_exception);
+    RUN_TEST(test_timeout_then_late_answer);
+    RUN_TEST(test_reconnect);
+    RUN_TEST(test_persistent_connection);
+    TEST_EXIT();
+}
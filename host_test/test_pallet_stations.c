@@ -0,0 +1,156 @@
+/*
+ * test_pallet_stations.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ *
+ * Cubes per hour with two pallet stations against the single station
+ * the line had before, on the whole line simulation (see line_sim.c)
+ * for 5, 8 and 10 layers. The robot is kept the bottleneck, so the
+ * time between two wrap starts is one pallet cycle. The single station
+ * is played by the panel: STOP when a wrap starts, START when it is
+ * done, which holds the robot for the wrap as the old
+ * STATE_WAIT_WRAP_DONE / STATE_WRAPPING did. The cube offered together
+ * with the hand-over is placed before the STOP arrives, so the single
+ * station comes out one robot cycle faster than it was and the gain
+ * shown is on the low side.
+ */
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "logic.h"
+#include "io.h"
+#include "adc.h"
+#include "tcp.h"
+#include "conveyor.h"
+#include "outputs.h"
+#include "pallet_plan.h"
+#include "plant.h"
+#include "robot_server.h"
+#include "modbus_server.h"
+#include "host_port.h"
+#include "host_test.h"
+
+#define INVERTER_UNIT       0x01        // DELTA_INVERTER_ADDRESS
+#define ROBOT_CYCLE_MS      4000
+#define WRAP_MS             60000
+#define CYCLE_TIMEOUT_US    (1200LL * 1000000)
+
+TEST_DEFINE_FAILURES;
+
+QueueHandle_t logic_event_queue = NULL;
+
+static const plant_config_t plant_cfg = {
+    .cubes = 3000,
+    .rate_per_hour = 1200,              // more good cubes than the robot can place
+    .pitch_min_mm = PLANT_PLATFORM_MM + PLANT_CUBE_MM,
+    .belt_mm_s = 500,
+    .weight_mean_g = 50000,
+    .weight_sd_g = 500,
+    .outlier_permille = 30,
+    .outlier_g = 4000,
+    .noise_g = 40,
+    .wrap_ms = WRAP_MS,
+    .seed = 1,
+};
+
+static const robot_server_config_t robot_cfg = {
+    .ack_ms = 20,
+    .pick_ms = 1500,
+    .place_ms = ROBOT_CYCLE_MS - 1500,
+    .on_pick = plant_robot_pick,
+    .on_place = plant_robot_place,
+};
+
+static const uint8_t layer_counts[] = { 5, 8, 10 };
+
+#define CONFIGS     (sizeof(layer_counts) / sizeof(layer_counts[0]))
+
+/*
+ * Switch the line to layers and the station model, then time the first
+ * pallet built entirely under them: from the wrap start that ends the
+ * pallet in progress to the next one.
+ */
+static int64_t pallet_cycle_us(uint8_t layers, bool single_station)
+{
+    plant_stats_t st;
+    logic_event_t evt = {
+        .type = LOGIC_EVT_HMI,
+        .hmi = { .id = HMI_CMD_SET_LAYERS, .layers = layers },
+    };
+
+    plant_set_hold_during_wrap(single_station);
+    logic_post_event_wait(&evt, portMAX_DELAY);
+
+    plant_get_stats(&st);
+    uint32_t first = st.wraps_started;
+    int64_t end = host_now_us() + CYCLE_TIMEOUT_US;
+    while (st.wraps_started < first + 2 && host_now_us() < end) {
+        host_sleep_us(1000000);
+        plant_get_stats(&st);
+    }
+    TEST_CHECK(st.wraps_started >= first + 2);
+    TEST_CHECK(first + 1 < PLANT_MAX_WRAPS);
+    if (st.wraps_started < first + 2 || first + 1 >= PLANT_MAX_WRAPS) {
+        return 0;
+    }
+    return st.wrap_start_us[first + 1] - st.wrap_start_us[first];
+}
+
+static void test_layers_gain(void)
+{
+    int64_t single[CONFIGS];
+    int64_t dual[CONFIGS];
+
+    for (size_t i = 0; i < CONFIGS; i++) {
+        dual[i] = pallet_cycle_us(layer_counts[i], false);
+    }
+    for (size_t i = 0; i < CONFIGS; i++) {
+        single[i] = pallet_cycle_us(layer_counts[i], true);
+    }
+
+    printf("robot %d ms per cube, wrap %d ms\n", ROBOT_CYCLE_MS, WRAP_MS);
+    printf("layers  cubes  single station       two stations         gain\n");
+    for (size_t i = 0; i < CONFIGS; i++) {
+        uint32_t cubes = pallet_plan_slots(layer_counts[i]);
+        int64_t robot_us = (int64_t)cubes * ROBOT_CYCLE_MS * 1000;
+        double single_h = single[i] > 0 ? cubes * 3.6e9 / single[i] : 0;
+        double dual_h = dual[i] > 0 ? cubes * 3.6e9 / dual[i] : 0;
+
+        printf("%6u  %5lu  %5.1f s %4.0f/h     %5.1f s %4.0f/h     %+5.1f %%\n", layer_counts[i],
+               (unsigned long)cubes, single[i] / 1e6, single_h, dual[i] / 1e6, dual_h,
+               single_h > 0 ? (dual_h / single_h - 1) * 100 : 0.0);
+
+        // Two stations: the robot never waits for the wrapper, the pallet takes its placing time
+        TEST_CHECK(dual[i] >= robot_us);
+        TEST_CHECK(dual[i] <= robot_us + robot_us / 50);
+        // One station: the wrap on top of it, less the cube placed before the STOP
+        TEST_CHECK(single[i] >= robot_us + (WRAP_MS - ROBOT_CYCLE_MS) * 1000LL);
+        TEST_CHECK(single[i] <= robot_us + robot_us / 50 + WRAP_MS * 1000LL + 2000000);
+    }
+}
+
+int main(void)
+{
+    host_port_init();
+    logic_event_queue = xQueueCreate(32, sizeof(logic_event_t));
+
+    modbus_server_t *inverter = modbus_server_start(SIM_INVERTER_PORT, INVERTER_UNIT);
+    robot_server_t *robot = robot_server_start(SIM_ROBOT_PORT, &robot_cfg);
+    if (inverter == NULL || robot == NULL) {
+        printf("FAIL cannot listen on ports %d and %d\n", SIM_INVERTER_PORT, SIM_ROBOT_PORT);
+        return EXIT_FAILURE;
+    }
+
+    plant_start(&plant_cfg, inverter);
+    io_init();
+    conveyor_init();
+    outputs_init();
+    start_io_task();
+    adc_task_start();
+    start_logic_task();
+    start_tcp_client_task();
+
+    RUN_TEST(test_layers_gain);
+    TEST_EXIT();
+}
@@ -0,0 +1,423 @@
+/*
+ * test_weigh.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ *
+ * The weighing chain of adc_task on synthetic load cell traces: the
+ * median + IIR filter on raw counts (step response, spikes, a cube
+ * landing on the scale), the settling detector on the filtered grams
+ * (settle time, timeout, drift, an empty platform), and the in-motion
+ * checkweigher on cubes crossing the platform (window and timeout per
+ * belt speed, plateau mean, fit of the speed offset).
+ */
+
+#include "weight_filter.h"
+#include "weigh_detector.h"
+#include "checkweigh.h"
+#include "adc.h"
+#include "host_test.h"
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#define FILTER_RATE_HZ      (ADC_SAMPLE_FREQ_HZ / ADC_DECIMATION)
+#define RAW_PER_KG          (4095.0 / ADC_FULL_SCALE_KG)
+#define WEIGH_RATE_HZ       (FILTER_RATE_HZ / ADC_WEIGH_DECIMATION)
+#define CUBE_G              50000
+#define DRAG_G              30          // speed offset of the simulated scale: DRAG_G + DRAG_MG_MM_S * v
+#define DRAG_MG_MM_S        200
+
+TEST_DEFINE_FAILURES;
+
+static uint32_t rng = 1;
+
+// xorshift32, the same traces on every host
+static uint32_t trace_rand(void)
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+static double trace_gauss(void)
+{
+    double u1 = (trace_rand() + 1.0) / 4294967296.0;
+    double u2 = (trace_rand() + 1.0) / 4294967296.0;
+
+    return sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+
+static double q16(int32_t v)
+{
+    return v / 65536.0;
+}
+
+/* ------------------------------------------------------------------ */
+/* weight_filter                                                      */
+/* ------------------------------------------------------------------ */
+
+static void test_filter_step(void)
+{
+    weight_filter_t f;
+    const uint16_t lo = 100, hi = 2100;
+
+    weight_filter_init(&f, ADC_MEDIAN_N, ADC_IIR_SHIFT);
+    uint32_t settle = weight_filter_settle_samples(&f, 12);
+
+    // The first sample primes the low-pass, no ramp up from zero
+    TEST_CHECK_EQ((int32_t)lo << WEIGHT_FILTER_Q, weight_filter_push(&f, lo));
+    for (int i = 0; i < 50; i++) {
+        weight_filter_push(&f, lo);
+    }
+
+    int32_t prev = (int32_t)lo << WEIGHT_FILTER_Q;
+    uint32_t within = 0;
+    for (uint32_t i = 1; i <= 4 * settle; i++) {
+        int32_t y = weight_filter_push(&f, hi);
+        // The median holds the old level for half its window, then no overshoot
+        if (i <= ADC_MEDIAN_N / 2u) {
+            TEST_CHECK_EQ((int32_t)lo << WEIGHT_FILTER_Q, y);
+        }
+        TEST_CHECK(y >= prev);
+        TEST_CHECK(y <= (int32_t)hi << WEIGHT_FILTER_Q);
+        if (within == 0 && hi - q16(y) <= (hi - lo) / 4096.0) {
+            within = i;
+        }
+        prev = y;
+    }
+    printf("step %u -> %u counts: within 12 bits after %lu samples, settle estimate %lu\n", lo, hi,
+           (unsigned long)within, (unsigned long)settle);
+    TEST_CHECK(within > 0);
+    TEST_CHECK(within <= settle);
+    TEST_CHECK(within + 8 >= settle);
+}
+
+static void test_filter_spikes(void)
+{
+    weight_filter_t f;
+    const uint16_t level = 1500;
+
+    weight_filter_init(&f, ADC_MEDIAN_N, ADC_IIR_SHIFT);
+    for (int i = 0; i < 1000; i++) {
+        uint16_t raw = level;
+        // Single and double spikes both ways, up to half the median window
+        switch (i % 11) {
+            case 3:
+                raw = 4095;
+                break;
+            case 7:
+            case 8:
+                raw = 0;
+                break;
+        }
+        TEST_CHECK_EQ((int32_t)level << WEIGHT_FILTER_Q, weight_filter_push(&f, raw));
+    }
+
+    // After a reset the next sample primes again
+    weight_filter_reset(&f);
+    TEST_CHECK_EQ((int32_t)900 << WEIGHT_FILTER_Q, weight_filter_push(&f, 900));
+}
+
+/*
+ * A 50 kg cube lands within 50 ms and rings at 12 Hz while it settles,
+ * over 4 counts of noise and a spike every 40 samples. After the filter
+ * the plateau is quieter than the raw trace and keeps its level.
+ */
+static void test_filter_cube_trace(void)
+{
+    weight_filter_t f;
+    const double level = 50.0 * RAW_PER_KG;
+    const int land = FILTER_RATE_HZ / 20;
+    const int n = FILTER_RATE_HZ;
+    double raw_sq = 0, out_sq = 0, out_sum = 0;
+    int plateau = 0, raw_n = 0;
+
+    rng = 7;
+    weight_filter_init(&f, ADC_MEDIAN_N, ADC_IIR_SHIFT);
+    for (int i = 0; i < n; i++) {
+        double t = (double)i / FILTER_RATE_HZ;
+        double x = i < land ? level * i / land : level + 0.05 * level * exp(-8 * t) * sin(2 * M_PI * 12 * t);
+        double noisy = x + trace_gauss() * 4;
+        bool spike = i % 40 == 13;
+        uint16_t raw = spike ? 4095 : (uint16_t)lround(noisy);
+        double y = q16(weight_filter_push(&f, raw));
+
+        // Last half second: the ringing is gone; the noise is measured without the spikes
+        if (i >= n / 2) {
+            raw_sq += spike ? 0 : (noisy - level) * (noisy - level);
+            raw_n += !spike;
+            out_sq += (y - level) * (y - level);
+            out_sum += y;
+            plateau++;
+        }
+    }
+    double raw_rms = sqrt(raw_sq / raw_n);
+    double out_rms = sqrt(out_sq / plateau);
+    double mean_err_g = (out_sum / plateau - level) / RAW_PER_KG * 1000;
+
+    printf("cube trace: plateau rms %.1f counts raw, %.2f filtered, mean off by %.0f g\n", raw_rms, out_rms,
+           mean_err_g);
+    TEST_CHECK(out_rms * 3 < raw_rms);
+    TEST_CHECK(fabs(mean_err_g) < 50);
+}
+
+/* ------------------------------------------------------------------ */
+/* weigh_detector                                                     */
+/* ------------------------------------------------------------------ */
+
+// As adc_task sets it up
+static const weigh_config_t weigh_cfg = {
+    .window_len = ADC_WEIGH_WINDOW,
+    .sample_rate_hz = WEIGH_RATE_HZ,
+    .max_stddev_g = ADC_WEIGH_MAX_STDDEV_G,
+    .max_slope_g_s = ADC_WEIGH_MAX_SLOPE_G_S,
+    .timeout_ms = ADC_WEIGH_TIMEOUT_MS,
+    .min_load_g = ADC_WEIGH_MIN_LOAD_G,
+};
+
+typedef double (*weigh_trace_t)(double t);
+
+// Feed trace(t) plus noise_g of noise until a result, or for 2 x the timeout
+static bool weigh_run(weigh_detector_t *d, weigh_trace_t trace, double noise_g, weigh_result_t *out)
+{
+    weigh_detector_arm(d, 42);
+    for (int i = 0; i < 2 * ADC_WEIGH_TIMEOUT_MS * WEIGH_RATE_HZ / 1000; i++) {
+        double g = trace((double)i / WEIGH_RATE_HZ) + trace_gauss() * noise_g;
+        if (weigh_detector_push(d, (int32_t)lround(g), out)) {
+            TEST_CHECK(!weigh_detector_armed(d));
+            TEST_CHECK_EQ(42, out->cube_id);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Arrives 200 ms after arming and settles from a 2 kg overshoot
+static double cube_settling(double t)
+{
+    if (t < 0.2) {
+        return 0;
+    }
+    return CUBE_G + 2000 * exp(-(t - 0.2) * 25) * cos(2 * M_PI * 8 * (t - 0.2));
+}
+
+static double cube_ringing(double t)
+{
+    return CUBE_G + 500 * sin(2 * M_PI * 5 * t);
+}
+
+// 400 g/s: quiet enough for the spread limit, too fast for the slope limit
+static double cube_drifting(double t)
+{
+    return CUBE_G + 400 * t;
+}
+
+static double platform_empty(double t)
+{
+    return 0;
+}
+
+static void test_detector_settles(void)
+{
+    weigh_detector_t d;
+    weigh_result_t r;
+
+    rng = 11;
+    weigh_detector_init(&d, &weigh_cfg);
+    TEST_CHECK(weigh_run(&d, cube_settling, 15, &r));
+    printf("settling cube: %ld g sd %ld g after %lu ms\n", (long)r.mean_g, (long)r.stddev_g,
+           (unsigned long)r.settle_ms);
+    TEST_CHECK_EQ(WEIGH_RESULT_STABLE, r.status);
+    TEST_CHECK(labs((long)r.mean_g - CUBE_G) <= 20);
+    TEST_CHECK_EQ(ADC_WEIGH_WINDOW, r.samples);
+    TEST_CHECK(r.settle_ms >= 200 + ADC_WEIGH_WINDOW * 1000 / WEIGH_RATE_HZ);
+    TEST_CHECK(r.settle_ms <= 500);
+    TEST_CHECK_EQ(0, r.speed_mm_s);
+
+    // Disarmed, samples are ignored
+    TEST_CHECK(!weigh_detector_push(&d, CUBE_G, &r));
+}
+
+static void test_detector_times_out(void)
+{
+    static const struct {
+        const char   *name;
+        weigh_trace_t trace;
+    } cases[] = {
+        { "ringing", cube_ringing },
+        { "drifting", cube_drifting },
+        // Armed at T1 before the cube is on the scale: still zero is no weight
+        { "empty platform", platform_empty },
+    };
+    weigh_detector_t d;
+    weigh_result_t r;
+
+    weigh_detector_init(&d, &weigh_cfg);
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        rng = 13;
+        TEST_CHECK(weigh_run(&d, cases[i].trace, 5, &r));
+        printf("%s: %ld g sd %ld g, %s after %lu ms\n", cases[i].name, (long)r.mean_g, (long)r.stddev_g,
+               r.status == WEIGH_RESULT_STABLE ? "stable" : "timeout", (unsigned long)r.settle_ms);
+        TEST_CHECK_EQ(WEIGH_RESULT_TIMEOUT, r.status);
+        TEST_CHECK_EQ(ADC_WEIGH_TIMEOUT_MS, r.settle_ms);
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/* checkweigh                                                         */
+/* ------------------------------------------------------------------ */
+
+static const checkweigh_config_t dyn_cfg = {
+    .sample_rate_hz = WEIGH_RATE_HZ,
+    .load_on_g = ADC_DYN_LOAD_ON_G,
+    .load_off_g = ADC_DYN_LOAD_OFF_G,
+    .edge_skip = ADC_DYN_EDGE_SKIP,
+    .window_min = ADC_DYN_WINDOW_MIN,
+    .max_stddev_g = ADC_DYN_MAX_STDDEV_G,
+    .travel_mm = ADC_DYN_PLATFORM_MM + ADC_DYN_CUBE_MM,
+    .plateau_mm = ADC_DYN_PLATFORM_MM - ADC_DYN_CUBE_MM,
+    .timeout_ms = ADC_DYN_TIMEOUT_MS,
+};
+
+static int32_t drag_g(int32_t speed_mm_s)
+{
+    return DRAG_G + DRAG_MG_MM_S * speed_mm_s / 1000;
+}
+
+/*
+ * A cube of mass_g crosses the platform at speed_mm_s, armed with its
+ * front at the platform edge. The load follows the share of the cube
+ * on the platform, rings for a while once it is all on, and reads
+ * drag_g() heavy while the belt moves.
+ */
+static bool passage(checkweigh_t *d, int32_t mass_g, int32_t speed_mm_s, weigh_result_t *out)
+{
+    double full_s = (double)ADC_DYN_CUBE_MM / speed_mm_s;
+
+    checkweigh_arm(d, 7, speed_mm_s);
+    for (uint32_t i = 0; i <= d->timeout; i++) {
+        double t = (double)i / WEIGH_RATE_HZ;
+        double front = speed_mm_s * t;
+        double on = fmin(front, ADC_DYN_PLATFORM_MM) - fmax(front - ADC_DYN_CUBE_MM, 0);
+        double g = on > 0 ? (double)mass_g * on / ADC_DYN_CUBE_MM + drag_g(speed_mm_s) : 0;
+
+        if (t > full_s && on > 0) {
+            g += 800 * exp(-(t - full_s) * 20) * sin(2 * M_PI * 10 * (t - full_s));
+        }
+        g += trace_gauss() * 20;
+        if (checkweigh_push(d, (int32_t)lround(g), speed_mm_s, out)) {
+            TEST_CHECK_EQ(7, out->cube_id);
+            return true;
+        }
+    }
+    return false;
+}
+
+static void test_checkweigh_window(void)
+{
+    static const int32_t speeds[] = { 100, 250, 500, 1000, 2000 };
+    const uint32_t window_max = CHECKWEIGH_BUF_MAX - 1 - ADC_DYN_EDGE_SKIP;
+    checkweigh_t d;
+
+    checkweigh_init(&d, &dyn_cfg);
+    for (size_t i = 0; i < sizeof(speeds) / sizeof(speeds[0]); i++) {
+        int32_t v = speeds[i];
+        uint32_t window = dyn_cfg.plateau_mm * WEIGH_RATE_HZ / v / 2;
+
+        // Half the plateau, bounded by window_min and the ring
+        window = window < ADC_DYN_WINDOW_MIN ? ADC_DYN_WINDOW_MIN : window > window_max ? window_max : window;
+        checkweigh_arm(&d, 1, v);
+        TEST_CHECK_EQ(window, d.window);
+        // The travel with half again, plus the margin
+        TEST_CHECK_EQ(dyn_cfg.travel_mm * WEIGH_RATE_HZ * 3 / 2 / v + ADC_DYN_TIMEOUT_MS * WEIGH_RATE_HZ / 1000,
+                      d.timeout);
+    }
+}
+
+static void test_checkweigh_plateau(void)
+{
+    static const int32_t speeds[] = { 250, 500, 1000 };
+    checkweigh_t d;
+    weigh_result_t r;
+
+    rng = 17;
+    checkweigh_init(&d, &dyn_cfg);
+    for (size_t i = 0; i < sizeof(speeds) / sizeof(speeds[0]); i++) {
+        int32_t v = speeds[i];
+
+        TEST_CHECK(passage(&d, CUBE_G, v, &r));
+        printf("%4ld mm/s: %ld g sd %ld g over %lu samples\n", (long)v, (long)r.raw_g, (long)r.stddev_g,
+               (unsigned long)r.samples);
+        TEST_CHECK_EQ(WEIGH_RESULT_STABLE, r.status);
+        TEST_CHECK_EQ(d.window, r.samples);
+        TEST_CHECK_EQ(v, r.speed_mm_s);
+        // Without compensation the drag is in the reading
+        TEST_CHECK(labs((long)r.raw_g - CUBE_G - drag_g(v)) <= 25);
+        TEST_CHECK_EQ(r.raw_g, r.mean_g);
+    }
+
+    // Nothing crosses: time out without a weight
+    checkweigh_arm(&d, 7, 500);
+    bool done = false;
+    for (uint32_t i = 0; i < d.timeout && !done; i++) {
+        done = checkweigh_push(&d, 0, 500, &r);
+    }
+    TEST_CHECK(done);
+    TEST_CHECK_EQ(WEIGH_RESULT_TIMEOUT, r.status);
+    TEST_CHECK_EQ(0, r.raw_g);
+}
+
+static void test_checkweigh_calibration(void)
+{
+    static const int32_t speeds[] = { 300, 300, 500, 500, 700, 700 };
+    checkweigh_t d;
+    checkweigh_cal_t cal;
+    checkweigh_comp_t comp;
+    weigh_result_t r;
+
+    rng = 19;
+    checkweigh_init(&d, &dyn_cfg);
+    checkweigh_cal_reset(&cal);
+    for (size_t i = 0; i < sizeof(speeds) / sizeof(speeds[0]); i++) {
+        TEST_CHECK(checkweigh_cal_fit(&cal, &comp) == (i >= CHECKWEIGH_CAL_MIN_CUBES));
+        TEST_CHECK(passage(&d, CUBE_G, speeds[i], &r));
+        checkweigh_cal_add(&cal, r.speed_mm_s, r.raw_g - CUBE_G);
+    }
+    TEST_CHECK(checkweigh_cal_fit(&cal, &comp));
+    printf("fitted offset %ld g + %ld mg per mm/s (scale %d g + %d mg per mm/s)\n", (long)comp.offset_g,
+           (long)comp.slope_mg_mm_s, DRAG_G, DRAG_MG_MM_S);
+    TEST_CHECK(labs((long)comp.slope_mg_mm_s - DRAG_MG_MM_S) <= 40);
+    TEST_CHECK(labs((long)comp.offset_g - DRAG_G) <= 25);
+
+    // Compensated, a speed between the reference ones reads the true mass
+    checkweigh_set_comp(&d, &comp);
+    TEST_CHECK(passage(&d, CUBE_G, 600, &r));
+    TEST_CHECK_EQ(WEIGH_RESULT_STABLE, r.status);
+    TEST_CHECK(labs((long)r.mean_g - CUBE_G) <= 25);
+    TEST_CHECK_EQ(r.raw_g - checkweigh_offset_g(&comp, 600), r.mean_g);
+
+    // All references at about one speed: a constant offset only
+    checkweigh_cal_reset(&cal);
+    checkweigh_cal_add(&cal, 500, 120);
+    checkweigh_cal_add(&cal, 510, 130);
+    checkweigh_cal_add(&cal, 520, 140);
+    TEST_CHECK(checkweigh_cal_fit(&cal, &comp));
+    TEST_CHECK_EQ(0, comp.slope_mg_mm_s);
+    TEST_CHECK_EQ(130, comp.offset_g);
+}
+
+int main(void)
+{
+    RUN_TEST(test_filter_step);
+    RUN_TEST(test_filter_spikes);
+    RUN_TEST(test_filter_cube_trace);
+    RUN_TEST(test_detector_settles);
+    RUN_TEST(test_detector_times_out);
+    RUN_TEST(test_checkweigh_window);
+    RUN_TEST(test_checkweigh_plateau);
+    RUN_TEST(test_checkweigh_calibration);
+    TEST_EXIT();
+}
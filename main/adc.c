@@ -2,61 +2,267 @@
  * adc.c - ADC weight measurement implementation for ESP32
  *
  * Features:
- * - Floating point weight calculations
- * - Thread-safe operation with mutex protection
- * - Advanced filtering (median + low-pass)
+ * - Continuous (DMA) sampling at ADC_SAMPLE_FREQ_HZ
+ * - Fixed point filtering (decimation + median + IIR low-pass)
+ * - Lock-free publication of the latest weight
+ * - Settling detector posting one weigh result per cube
+ * - In-motion checkweighing with speed-dependent offset compensation
  * - Core-affinitized measurement task
- * 
+ *
  *  Created on: Jun 12, 2025
  *      Author: lenovo
  */
 #include "adc.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/timers.h"
+#include "esp_attr.h"
 #include "esp_log.h"
-#include "esp_adc/adc_oneshot.h"
+#include "esp_timer.h"
+#include "esp_adc/adc_continuous.h"
 #include "driver/gpio.h"
+#include "nvs.h"
 #include "tasks_common.h"
+#include "weight_filter.h"
+#include "weigh_detector.h"
+#include "checkweigh.h"
+#include "conveyor.h"
+#include "logic.h"
+#include "line_status.h"
+#include "dlog.h"
+#include "diag.h"
 
 static const char *TAG = "ADC_TASK";
 
 // ADC channel and unit configuration
 #define ADC_CHANNEL         ADC_CHANNEL_6       // GPIO34 (ADC1 channel 6)
 #define ADC_UNIT            ADC_UNIT_1
+#define ADC_RAW_MAX         4095
 
 static TaskHandle_t adc_task_handle = NULL;
-static adc_oneshot_unit_handle_t adc_handle;
-static float latest_weight = 0.0f;
+static adc_continuous_handle_t adc_handle;
+static weight_filter_t weight_filter;
+static weigh_detector_t weigh_detector;
+static checkweigh_t checkweigh;
+static bool weigh_dynamic = false;     // current measurement uses the checkweigher
+
+#define ADC_NVS_NAMESPACE       "adc"
+#define ADC_NVS_KEY_COMP        "dyn_comp"
+
+// Compensation handed over by adc_weigh_set_comp(), applied by adc_task
+static checkweigh_comp_t comp_pending;
+static volatile uint32_t comp_update = 0;
+static portMUX_TYPE comp_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// Weighing requests from the logic task, consumed by adc_task
+#define ADC_WEIGH_REQ_NONE      0
+#define ADC_WEIGH_REQ_START     1
+#define ADC_WEIGH_REQ_CANCEL    2
+static volatile uint32_t weigh_request = ADC_WEIGH_REQ_NONE;
+static volatile uint16_t weigh_request_id = 0;
+
+// Latest filtered weight in grams; a 32-bit store is atomic on Xtensa
+static volatile int32_t latest_weight_g = 0;
+
+/**
+ * @brief DMA frame done callback, wakes the ADC task
+ */
+static bool IRAM_ATTR adc_conv_done_cb(adc_continuous_handle_t handle,
+                                       const adc_continuous_evt_data_t *edata,
+                                       void *user_data)
+{
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(adc_task_handle, &woken);
+    return woken == pdTRUE;
+}
+
+static void adc_continuous_setup(void)
+{
+    adc_continuous_handle_cfg_t handle_cfg = {
+        .max_store_buf_size = ADC_POOL_SIZE,
+        .conv_frame_size = ADC_FRAME_SIZE,
+    };
+    ESP_ERROR_CHECK(adc_continuous_new_handle(&handle_cfg, &adc_handle));
+
+    adc_digi_pattern_config_t pattern = {
+        .atten = ADC_ATTEN_DB_11,
+        .channel = ADC_CHANNEL,
+        .unit = ADC_UNIT,
+        .bit_width = SOC_ADC_DIGI_MAX_BITWIDTH,
+    };
+
+    adc_continuous_config_t dig_cfg = {
+        .pattern_num = 1,
+        .adc_pattern = &pattern,
+        .sample_freq_hz = ADC_SAMPLE_FREQ_HZ,
+        .conv_mode = ADC_CONV_SINGLE_UNIT_1,
+        .format = ADC_DIGI_OUTPUT_FORMAT_TYPE1,
+    };
+    ESP_ERROR_CHECK(adc_continuous_config(adc_handle, &dig_cfg));
+
+    adc_continuous_evt_cbs_t cbs = {
+        .on_conv_done = adc_conv_done_cb,
+    };
+    ESP_ERROR_CHECK(adc_continuous_register_event_callbacks(adc_handle, &cbs, NULL));
+    ESP_ERROR_CHECK(adc_continuous_start(adc_handle));
+}
+
+static void adc_comp_load(void)
+{
+    checkweigh_comp_t comp = { 0 };
+    size_t len = sizeof(comp);
+    nvs_handle_t nvs;
+
+    if (nvs_open(ADC_NVS_NAMESPACE, NVS_READONLY, &nvs) == ESP_OK) {
+        if (nvs_get_blob(nvs, ADC_NVS_KEY_COMP, &comp, &len) != ESP_OK || len != sizeof(comp)) {
+            comp = (checkweigh_comp_t){ 0 };
+        }
+        nvs_close(nvs);
+    }
+    checkweigh_set_comp(&checkweigh, &comp);
+    ESP_LOGI(TAG, "Dynamic offset %ld g + %ld mg per mm/s",
+             (long)comp.offset_g, (long)comp.slope_mg_mm_s);
+}
+
+/**
+ * @brief Apply pending requests and feed the settling detector or the checkweigher
+ */
+static void adc_weigh_process(int32_t weight_g)
+{
+    static uint32_t decim = 0;
+    uint32_t req = __atomic_exchange_n(&weigh_request, ADC_WEIGH_REQ_NONE, __ATOMIC_ACQ_REL);
+
+    if (__atomic_exchange_n(&comp_update, 0, __ATOMIC_ACQ_REL)) {
+        portENTER_CRITICAL(&comp_mux);
+        checkweigh_set_comp(&checkweigh, &comp_pending);
+        portEXIT_CRITICAL(&comp_mux);
+    }
+
+    if (req == ADC_WEIGH_REQ_START) {
+        // Belt moving: weigh on the fly, otherwise wait for a settled reading
+        int32_t speed = conveyor_speed_mm_s();
+        weigh_dynamic = speed >= ADC_DYN_MIN_SPEED_MM_S || speed <= -ADC_DYN_MIN_SPEED_MM_S;
+        if (weigh_dynamic) {
+            checkweigh_arm(&checkweigh, weigh_request_id, speed);
+        } else {
+            weigh_detector_arm(&weigh_detector, weigh_request_id);
+        }
+        decim = 0;
+    } else if (req == ADC_WEIGH_REQ_CANCEL) {
+        weigh_detector_disarm(&weigh_detector);
+        checkweigh_disarm(&checkweigh);
+    }
+
+    bool armed = weigh_dynamic ? checkweigh_armed(&checkweigh) : weigh_detector_armed(&weigh_detector);
+    if (!armed || ++decim < ADC_WEIGH_DECIMATION) {
+        return;
+    }
+    decim = 0;
+
+    logic_event_t evt = { .type = LOGIC_EVT_WEIGH_DONE };
+    bool done = weigh_dynamic ?
+                checkweigh_push(&checkweigh, weight_g, conveyor_speed_mm_s(), &evt.weigh) :
+                weigh_detector_push(&weigh_detector, weight_g, &evt.weigh);
+    if (done) {
+        DLOGD(TAG, "Weighed %" PRId32 " g (raw %" PRId32 " g) at %" PRId32 " mm/s%s",
+              evt.weigh.mean_g, evt.weigh.raw_g, evt.weigh.speed_mm_s,
+              DLOG_STR(evt.weigh.status == WEIGH_RESULT_TIMEOUT ? " (not settled)" : ""));
+        if (logic_post_event(&evt) != pdTRUE) {
+            DLOGE(TAG, "Logic event queue full, weigh result dropped");
+        }
+    }
+}
 
 /**
  * @brief ADC reading and conversion loop
- * 
- * This task reads raw ADC values, converts them to voltage, and stores a weight approximation.
+ *
+ * This task drains DMA frames, decimates and filters the samples and
+ * publishes the resulting weight.
  */
 static void adc_task(void *arg)
 {
-    adc_oneshot_unit_init_cfg_t init_cfg = {
-        .unit_id = ADC_UNIT,
+    uint8_t frame[ADC_FRAME_SIZE];
+    uint32_t acc = 0;
+    uint32_t acc_n = 0;
+    uint32_t status_n = 0;
+
+    weight_filter_init(&weight_filter, ADC_MEDIAN_N, ADC_IIR_SHIFT);
+
+    weigh_config_t weigh_cfg = {
+        .window_len = ADC_WEIGH_WINDOW,
+        .sample_rate_hz = ADC_SAMPLE_FREQ_HZ / ADC_DECIMATION / ADC_WEIGH_DECIMATION,
+        .max_stddev_g = ADC_WEIGH_MAX_STDDEV_G,
+        .max_slope_g_s = ADC_WEIGH_MAX_SLOPE_G_S,
+        .timeout_ms = ADC_WEIGH_TIMEOUT_MS,
+        .min_load_g = ADC_WEIGH_MIN_LOAD_G,
     };
-    adc_oneshot_new_unit(&init_cfg, &adc_handle);
+    weigh_detector_init(&weigh_detector, &weigh_cfg);
 
-    adc_oneshot_chan_cfg_t chan_cfg = {
-        .bitwidth = ADC_BITWIDTH_DEFAULT,
-        .atten = ADC_ATTEN_DB_11,
+    checkweigh_config_t dyn_cfg = {
+        .sample_rate_hz = weigh_cfg.sample_rate_hz,
+        .load_on_g = ADC_DYN_LOAD_ON_G,
+        .load_off_g = ADC_DYN_LOAD_OFF_G,
+        .edge_skip = ADC_DYN_EDGE_SKIP,
+        .window_min = ADC_DYN_WINDOW_MIN,
+        .max_stddev_g = ADC_DYN_MAX_STDDEV_G,
+        .travel_mm = ADC_DYN_PLATFORM_MM + ADC_DYN_CUBE_MM,
+        .plateau_mm = ADC_DYN_PLATFORM_MM - ADC_DYN_CUBE_MM,
+        .timeout_ms = ADC_DYN_TIMEOUT_MS,
     };
-    adc_oneshot_config_channel(adc_handle, ADC_CHANNEL, &chan_cfg);
+    checkweigh_init(&checkweigh, &dyn_cfg);
+    adc_comp_load();
+    adc_continuous_setup();
+
+    ESP_LOGI(TAG, "Continuous ADC at %d Hz, settle window %lu ms",
+             ADC_SAMPLE_FREQ_HZ, (unsigned long)adc_get_settle_ms());
 
     while (1) {
-        int raw = 0;
-        esp_err_t err = adc_oneshot_read(adc_handle, ADC_CHANNEL, &raw);
-        if (err == ESP_OK) {
-            // Example conversion: assume max 4095 = 100.0 kg
-            latest_weight = (float)raw * 100.0f / 4095.0f;
-        } else {
-            ESP_LOGE(TAG, "ADC read error: %s", esp_err_to_name(err));
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100));
+
+        uint32_t len = 0;
+        uint32_t frames = 0;
+        esp_err_t err;
+        int64_t start_us = esp_timer_get_time();
+        while ((err = adc_continuous_read(adc_handle, frame, sizeof(frame), &len, 0)) == ESP_OK) {
+            frames++;
+            for (uint32_t i = 0; i + SOC_ADC_DIGI_RESULT_BYTES <= len; i += SOC_ADC_DIGI_RESULT_BYTES) {
+                const adc_digi_output_data_t *p = (const adc_digi_output_data_t *)&frame[i];
+                if (p->type1.channel != ADC_CHANNEL) {
+                    continue;
+                }
+
+                acc += p->type1.data;
+                if (++acc_n < ADC_DECIMATION) {
+                    continue;
+                }
+
+                int32_t filtered_q16 = weight_filter_push(&weight_filter, (uint16_t)(acc / acc_n));
+                acc = 0;
+                acc_n = 0;
+
+                // grams = raw * full_scale / raw_max, raw in Q16
+                int64_t grams = ((int64_t)filtered_q16 * (int64_t)(ADC_FULL_SCALE_KG * 1000.0f))
+                                / ((int64_t)ADC_RAW_MAX << WEIGHT_FILTER_Q);
+                latest_weight_g = (int32_t)grams;
+                adc_weigh_process((int32_t)grams);
+
+                if (++status_n >= ADC_STATUS_DECIMATION) {
+                    status_n = 0;
+                    line_status_set_weight((int32_t)grams);
+                }
+            }
+        }
+
+        if (frames > 0) {
+            diag_loop_record(DIAG_LOOP_ADC, (uint32_t)(esp_timer_get_time() - start_us));
         }
 
-        vTaskDelay(pdMS_TO_TICKS(200)); // 5Hz update rate
+        if (err != ESP_ERR_TIMEOUT) {
+            DLOG_RATELIMIT(1000, ESP_LOG_ERROR, TAG, "ADC read error: %s", DLOG_STR(esp_err_to_name(err)));
+            weight_filter_reset(&weight_filter);
+            acc = 0;
+            acc_n = 0;
+        }
     }
 }
 
@@ -80,10 +286,69 @@ void adc_task_start(void)
 
 /**
  * @brief Return the latest converted weight value
- * 
+ *
  * @return float Latest weight approximation in kg
  */
 float read_weight(void)
 {
-    return latest_weight;
+    return (float)latest_weight_g / 1000.0f;
+}
+
+/**
+ * @brief Settle window of the filter chain for a 12-bit accurate reading
+ *
+ * @return Settle time in milliseconds
+ */
+uint32_t adc_get_settle_ms(void)
+{
+    uint32_t filter_rate_hz = ADC_SAMPLE_FREQ_HZ / ADC_DECIMATION;
+    uint32_t samples = weight_filter_settle_samples(&weight_filter, 12);
+    return (samples * 1000u + filter_rate_hz - 1u) / filter_rate_hz;
+}
+
+void adc_weigh_start(uint16_t cube_id)
+{
+    weigh_request_id = cube_id;
+    __atomic_store_n(&weigh_request, ADC_WEIGH_REQ_START, __ATOMIC_RELEASE);
+}
+
+void adc_weigh_cancel(void)
+{
+    __atomic_store_n(&weigh_request, ADC_WEIGH_REQ_CANCEL, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Store the latest compensation in NVS; runs in the timer service task
+ */
+static void adc_comp_save(void *arg1, uint32_t arg2)
+{
+    checkweigh_comp_t comp;
+
+    portENTER_CRITICAL(&comp_mux);
+    comp = comp_pending;
+    portEXIT_CRITICAL(&comp_mux);
+
+    nvs_handle_t nvs;
+    esp_err_t err = nvs_open(ADC_NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (err == ESP_OK) {
+        err = nvs_set_blob(nvs, ADC_NVS_KEY_COMP, &comp, sizeof(comp));
+        if (err == ESP_OK) {
+            err = nvs_commit(nvs);
+        }
+        nvs_close(nvs);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Dynamic offset not saved: %s", esp_err_to_name(err));
+    }
+}
+
+esp_err_t adc_weigh_set_comp(const checkweigh_comp_t *comp)
+{
+    portENTER_CRITICAL(&comp_mux);
+    comp_pending = *comp;
+    portEXIT_CRITICAL(&comp_mux);
+    __atomic_store_n(&comp_update, 1, __ATOMIC_RELEASE);
+
+    // Flash erase/write can take tens of ms: keep it off the caller (the logic task)
+    return xTimerPendFunctionCall(adc_comp_save, NULL, 0, 0) == pdPASS ? ESP_OK : ESP_ERR_NO_MEM;
 }
@@ -9,13 +9,50 @@
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "esp_adc/adc_oneshot.h"
+#include "esp_adc/adc_continuous.h"
+#include "esp_err.h"
+#include "checkweigh.h"
 
 // ADC task configuration macros
 #define ADC_TASK_STACK_SIZE     4096
 #define ADC_TASK_PRIORITY       10
 #define ADC_TASK_CORE_ID        0
 
+// Continuous (DMA) sampling configuration
+#define ADC_SAMPLE_FREQ_HZ      20000   // Hardware conversion rate
+#define ADC_DECIMATION          10      // Raw samples averaged per filter input (2 kHz into the filter)
+#define ADC_FRAME_SIZE          256     // Bytes per DMA conversion frame
+#define ADC_POOL_SIZE           1024    // Bytes of DMA result pool
+
+// Filter chain configuration
+#define ADC_MEDIAN_N            5       // Median-of-N window (odd)
+#define ADC_IIR_SHIFT           4       // IIR alpha = 1/16, ~70 ms to settle to 12 bits at 2 kHz
+
+// Settling detector configuration (fed at 2 kHz / ADC_WEIGH_DECIMATION)
+#define ADC_WEIGH_DECIMATION    4       // Filtered samples per detector sample (500 Hz)
+#define ADC_WEIGH_WINDOW        50      // Detector window, 100 ms
+#define ADC_WEIGH_MAX_STDDEV_G  50      // Max spread of a stable reading
+#define ADC_WEIGH_MAX_SLOPE_G_S 200     // Max drift of a stable reading
+#define ADC_WEIGH_TIMEOUT_MS    1500    // Report an unstable reading after this time
+#define ADC_WEIGH_MIN_LOAD_G    25000   // Below this the platform is empty, half the nominal cube
+
+// In-motion checkweighing, used when the belt runs at arming (same 500 Hz rate)
+#define ADC_DYN_MIN_SPEED_MM_S  50      // Slower belts are weighed with the settling detector
+#define ADC_DYN_LOAD_ON_G       25000   // Entry threshold, half the nominal cube
+#define ADC_DYN_LOAD_OFF_G      20000   // Exit threshold
+#define ADC_DYN_EDGE_SKIP       50      // Samples cut after entry and before exit, 100 ms
+#define ADC_DYN_WINDOW_MIN      50      // Shortest plateau window, 100 ms; longer on slower belts
+#define ADC_DYN_MAX_STDDEV_G    100     // Max spread of a usable plateau
+#define ADC_DYN_PLATFORM_MM     800     // Scale platform in the running direction, starting at T1
+#define ADC_DYN_CUBE_MM         600     // Block length in the running direction
+#define ADC_DYN_TIMEOUT_MS      1000    // Margin on the travel time over the platform
+
+// Live weight published to the HMI every N filtered samples (20 Hz)
+#define ADC_STATUS_DECIMATION   100
+
+// Scale conversion: full ADC range corresponds to this weight
+#define ADC_FULL_SCALE_KG       100.0f
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -27,11 +64,38 @@ void adc_task_start(void);
 
 /**
  * @brief Get the latest ADC weight reading.
- * 
+ *
  * @return float Latest weight value.
  */
 float read_weight(void);
 
+/**
+ * @brief Time the filter chain needs to settle after a load step.
+ *
+ * @return Settle window in milliseconds.
+ */
+uint32_t adc_get_settle_ms(void);
+
+/**
+ * @brief Start a weighing, in motion if the belt runs and settled otherwise.
+ *        The result is posted to the logic task as a LOGIC_EVT_WEIGH_DONE event.
+ * @param cube_id tag returned in the result.
+ */
+void adc_weigh_start(uint16_t cube_id);
+
+/**
+ * @brief Abort a weighing in progress; no event will be posted.
+ */
+void adc_weigh_cancel(void);
+
+/**
+ * @brief Replace the speed-dependent offset of in-motion weighing.
+ *        Takes effect from the next sample; the NVS write is deferred to
+ *        the timer service task, which logs a failure.
+ * @return ESP_OK if the write was queued; the new offset is used either way.
+ */
+esp_err_t adc_weigh_set_comp(const checkweigh_comp_t *comp);
+
 #ifdef __cplusplus
 }
 #endif
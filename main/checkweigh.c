@@ -0,0 +1,235 @@
+/*
+ * checkweigh.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ */
+
+#include "checkweigh.h"
+#include <string.h>
+
+void checkweigh_init(checkweigh_t *d, const checkweigh_config_t *cfg)
+{
+    memset(d, 0, sizeof(*d));
+    d->cfg = *cfg;
+    if (d->cfg.sample_rate_hz == 0) {
+        d->cfg.sample_rate_hz = 1;
+    }
+    // The ring holds the exit cut, the window and the sample leaving the window
+    if (d->cfg.edge_skip > CHECKWEIGH_BUF_MAX - 3) {
+        d->cfg.edge_skip = CHECKWEIGH_BUF_MAX - 3;
+    }
+    if (d->cfg.window_min < 2) {
+        d->cfg.window_min = 2;
+    }
+    if (d->cfg.window_min > CHECKWEIGH_BUF_MAX - 1 - d->cfg.edge_skip) {
+        d->cfg.window_min = CHECKWEIGH_BUF_MAX - 1 - d->cfg.edge_skip;
+    }
+    if (d->cfg.load_off_g > d->cfg.load_on_g) {
+        d->cfg.load_off_g = d->cfg.load_on_g;
+    }
+}
+
+void checkweigh_set_comp(checkweigh_t *d, const checkweigh_comp_t *comp)
+{
+    d->comp = *comp;
+}
+
+void checkweigh_arm(checkweigh_t *d, uint16_t cube_id, int32_t speed_mm_s)
+{
+    uint32_t rate = d->cfg.sample_rate_hz;
+    uint32_t v = (uint32_t)(speed_mm_s < 0 ? -speed_mm_s : speed_mm_s);
+    uint64_t window_max = CHECKWEIGH_BUF_MAX - 1 - d->cfg.edge_skip;
+
+    if (v == 0) {
+        v = 1;
+    }
+
+    // Half the plateau, so the quietest window can still move away from the transients
+    uint64_t window = (uint64_t)d->cfg.plateau_mm * rate / v / 2;
+    if (window < d->cfg.window_min) {
+        window = d->cfg.window_min;
+    }
+    if (window > window_max) {
+        window = window_max;
+    }
+    d->window = (uint16_t)window;
+    d->ring_len = (uint16_t)(d->cfg.edge_skip + window + 1);
+
+    // Travel time with half again for a belt slowing down, plus the margin
+    uint64_t timeout = (uint64_t)d->cfg.travel_mm * rate * 3 / 2 / v +
+                       (uint64_t)d->cfg.timeout_ms * rate / 1000;
+    d->timeout = timeout > UINT32_MAX ? UINT32_MAX : (uint32_t)timeout;
+
+    d->cube_id = cube_id;
+    d->kept = 0;
+    d->win_sum = 0;
+    d->win_sq = 0;
+    d->have_best = false;
+    d->load_sum = 0;
+    d->load_sq = 0;
+    d->loaded_n = 0;
+    d->speed_sum = 0;
+    d->elapsed = 0;
+    d->loaded = false;
+    d->armed = true;
+}
+
+void checkweigh_disarm(checkweigh_t *d)
+{
+    d->armed = false;
+}
+
+bool checkweigh_armed(const checkweigh_t *d)
+{
+    return d->armed;
+}
+
+int32_t checkweigh_offset_g(const checkweigh_comp_t *comp, int32_t speed_mm_s)
+{
+    return comp->offset_g + (int32_t)((int64_t)comp->slope_mg_mm_s * speed_mm_s / 1000);
+}
+
+/**
+ * @brief Store a sample past the entry cut. The sample edge_skip places
+ * back is now clear of the exit transient and enters the window.
+ */
+static void checkweigh_keep(checkweigh_t *d, int32_t sample_g)
+{
+    uint32_t j = d->kept++;
+    uint32_t skip = d->cfg.edge_skip;
+
+    d->ring[j % d->ring_len] = sample_g;
+    if (j < skip) {
+        return;
+    }
+
+    uint32_t confirmed = j - skip + 1;
+    int32_t in = d->ring[(j - skip) % d->ring_len];
+    d->win_sum += in;
+    d->win_sq += (int64_t)in * in;
+    if (confirmed > d->window) {
+        int32_t out = d->ring[(j - skip - d->window) % d->ring_len];
+        d->win_sum -= out;
+        d->win_sq -= (int64_t)out * out;
+    }
+
+    if (confirmed >= d->window) {
+        int64_t spread = (int64_t)d->window * d->win_sq - d->win_sum * d->win_sum;
+        if (!d->have_best || spread < d->best_spread) {
+            d->best_spread = spread;
+            d->best_sum = d->win_sum;
+            d->best_sq = d->win_sq;
+            d->have_best = true;
+        }
+    }
+}
+
+static void checkweigh_finish(checkweigh_t *d, bool exited, weigh_result_t *out)
+{
+    int64_t sum = d->best_sum;
+    int64_t sum_sq = d->best_sq;
+    uint32_t n = d->window;
+
+    if (!d->have_best) {
+        // Too short for a plateau: report everything as not settled
+        sum = d->load_sum;
+        sum_sq = d->load_sq;
+        n = d->loaded_n;
+    }
+
+    int32_t raw = n ? (int32_t)(sum / n) : 0;
+    int64_t var_n2 = (int64_t)n * sum_sq - sum * sum;
+    uint32_t stddev = n ? weigh_isqrt64(var_n2 > 0 ? (uint64_t)var_n2 : 0) / n : 0;
+    int32_t speed = d->loaded_n ? (int32_t)(d->speed_sum / d->loaded_n) : 0;
+
+    out->status = exited && d->have_best && (int32_t)stddev <= d->cfg.max_stddev_g ?
+                  WEIGH_RESULT_STABLE : WEIGH_RESULT_TIMEOUT;
+    out->raw_g = raw;
+    out->speed_mm_s = speed;
+    out->mean_g = raw - checkweigh_offset_g(&d->comp, speed);
+    out->stddev_g = (int32_t)stddev;
+    out->samples = n;
+    out->settle_ms = (uint32_t)((uint64_t)d->elapsed * 1000u / d->cfg.sample_rate_hz);
+    out->cube_id = d->cube_id;
+    d->armed = false;
+}
+
+bool checkweigh_push(checkweigh_t *d, int32_t sample_g, int32_t speed_mm_s, weigh_result_t *out)
+{
+    if (!d->armed) {
+        return false;
+    }
+
+    d->elapsed++;
+    bool timed_out = d->elapsed >= d->timeout;
+
+    if (!d->loaded) {
+        if (sample_g < d->cfg.load_on_g) {
+            if (timed_out) {
+                checkweigh_finish(d, false, out);
+                return true;
+            }
+            return false;
+        }
+        d->loaded = true;
+    } else if (sample_g < d->cfg.load_off_g) {
+        checkweigh_finish(d, true, out);
+        return true;
+    }
+
+    d->load_sum += sample_g;
+    d->load_sq += (int64_t)sample_g * sample_g;
+    d->speed_sum += speed_mm_s;
+    if (++d->loaded_n > d->cfg.edge_skip) {
+        checkweigh_keep(d, sample_g);
+    }
+
+    if (timed_out) {
+        checkweigh_finish(d, false, out);
+        return true;
+    }
+    return false;
+}
+
+void checkweigh_cal_reset(checkweigh_cal_t *cal)
+{
+    memset(cal, 0, sizeof(*cal));
+}
+
+void checkweigh_cal_add(checkweigh_cal_t *cal, int32_t speed_mm_s, int32_t error_g)
+{
+    if (cal->n == 0 || speed_mm_s < cal->min_v) {
+        cal->min_v = speed_mm_s;
+    }
+    if (cal->n == 0 || speed_mm_s > cal->max_v) {
+        cal->max_v = speed_mm_s;
+    }
+    cal->n++;
+    cal->sum_v += speed_mm_s;
+    cal->sum_vv += (int64_t)speed_mm_s * speed_mm_s;
+    cal->sum_e += error_g;
+    cal->sum_ve += (int64_t)speed_mm_s * error_g;
+}
+
+bool checkweigh_cal_fit(const checkweigh_cal_t *cal, checkweigh_comp_t *out)
+{
+    if (cal->n < CHECKWEIGH_CAL_MIN_CUBES) {
+        return false;
+    }
+
+    int64_t n = cal->n;
+    int64_t den = n * cal->sum_vv - cal->sum_v * cal->sum_v;
+
+    if (cal->max_v - cal->min_v < CHECKWEIGH_CAL_MIN_SPREAD_MM_S || den <= 0) {
+        // All passages at about one speed: the slope is not observable
+        out->offset_g = (int32_t)(cal->sum_e / n);
+        out->slope_mg_mm_s = 0;
+        return true;
+    }
+
+    int64_t slope_mg = (n * cal->sum_ve - cal->sum_v * cal->sum_e) * 1000 / den;
+    out->slope_mg_mm_s = (int32_t)slope_mg;
+    out->offset_g = (int32_t)((cal->sum_e * 1000 - slope_mg * cal->sum_v) / (n * 1000));
+    return true;
+}
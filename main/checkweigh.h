@@ -0,0 +1,123 @@
+/*
+ * checkweigh.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ *
+ * In-motion (dynamic) checkweigher. Once armed it waits for the load to
+ * cross the entry threshold and follows the passage until it drops below
+ * the exit threshold. The entry and exit transients are cut and the
+ * quietest window of what is left is reported: the plateau while the
+ * cube is fully on the platform. Samples are kept in a ring of
+ * edge_skip + window samples, so the length of the passage is not
+ * limited by memory. Timeout and window length follow the belt speed at
+ * arming, slow belts get a longer plateau and more time. The mean is
+ * corrected by an offset that depends linearly on belt speed; the offset
+ * line is fitted from reference cubes of known mass.
+ */
+
+#ifndef MAIN_CHECKWEIGH_H_
+#define MAIN_CHECKWEIGH_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "weigh_detector.h"
+
+#define CHECKWEIGH_BUF_MAX              512     // ring of edge_skip + window samples
+#define CHECKWEIGH_CAL_MIN_CUBES        3       // reference passages needed for a fit
+#define CHECKWEIGH_CAL_MIN_SPREAD_MM_S  50      // below this speed range only a constant offset is fitted
+
+typedef struct {
+    uint32_t sample_rate_hz;    // rate of checkweigh_push() calls
+    int32_t  load_on_g;         // entry threshold
+    int32_t  load_off_g;        // exit threshold, below load_on_g for hysteresis
+    uint16_t edge_skip;         // samples dropped after entry and before exit
+    uint16_t window_min;        // shortest plateau window, used at high speed
+    int32_t  max_stddev_g;      // spread limit for a stable plateau
+    uint32_t travel_mm;         // belt travel from arming until the cube has left the platform
+    uint32_t plateau_mm;        // belt travel while the whole cube is on the platform
+    uint32_t timeout_ms;        // margin on top of the travel time before giving up
+} checkweigh_config_t;
+
+// Dynamic offset: offset_g + slope_mg_mm_s * speed / 1000, subtracted from the plateau mean
+typedef struct {
+    int32_t offset_g;
+    int32_t slope_mg_mm_s;
+} checkweigh_comp_t;
+
+// Least-squares sums of (speed, error) pairs from reference cubes
+typedef struct {
+    int32_t n;
+    int32_t min_v;
+    int32_t max_v;
+    int64_t sum_v;
+    int64_t sum_vv;
+    int64_t sum_e;
+    int64_t sum_ve;
+} checkweigh_cal_t;
+
+typedef struct {
+    checkweigh_config_t cfg;
+    checkweigh_comp_t comp;
+    int32_t  ring[CHECKWEIGH_BUF_MAX];  // samples after the entry cut, newest last
+    uint16_t ring_len;          // edge_skip + window + 1 for this passage
+    uint16_t window;            // plateau window for this passage
+    uint32_t timeout;           // samples for this passage
+    uint32_t kept;              // samples past the entry cut
+    int64_t  win_sum;           // window ending edge_skip samples before the newest
+    int64_t  win_sq;
+    int64_t  best_spread;       // window * sum_sq - sum^2 of the quietest window so far
+    int64_t  best_sum;
+    int64_t  best_sq;
+    bool     have_best;
+    int64_t  load_sum;          // since entry, reported when the passage is too short for a window
+    int64_t  load_sq;
+    uint32_t loaded_n;
+    int64_t  speed_sum;
+    uint32_t elapsed;           // samples since arming
+    uint16_t cube_id;
+    bool     armed;
+    bool     loaded;            // entry threshold crossed
+} checkweigh_t;
+
+void checkweigh_init(checkweigh_t *d, const checkweigh_config_t *cfg);
+
+void checkweigh_set_comp(checkweigh_t *d, const checkweigh_comp_t *comp);
+
+/**
+ * @brief Start a new passage, discarding any history.
+ * @param cube_id tag copied into the result.
+ * @param speed_mm_s belt speed at arming, sets the timeout and the plateau window.
+ */
+void checkweigh_arm(checkweigh_t *d, uint16_t cube_id, int32_t speed_mm_s);
+
+void checkweigh_disarm(checkweigh_t *d);
+
+bool checkweigh_armed(const checkweigh_t *d);
+
+/**
+ * @brief Feed one filtered sample with the belt speed at that moment.
+ *
+ * @return true when a result was written to @p out; the checkweigher disarms itself.
+ */
+bool checkweigh_push(checkweigh_t *d, int32_t sample_g, int32_t speed_mm_s, weigh_result_t *out);
+
+/**
+ * @brief Offset in grams at a belt speed.
+ */
+int32_t checkweigh_offset_g(const checkweigh_comp_t *comp, int32_t speed_mm_s);
+
+void checkweigh_cal_reset(checkweigh_cal_t *cal);
+
+/**
+ * @brief Add one reference passage: error = uncompensated mean - reference mass.
+ */
+void checkweigh_cal_add(checkweigh_cal_t *cal, int32_t speed_mm_s, int32_t error_g);
+
+/**
+ * @brief Fit the offset line through the collected passages.
+ * @return false with fewer than CHECKWEIGH_CAL_MIN_CUBES passages.
+ */
+bool checkweigh_cal_fit(const checkweigh_cal_t *cal, checkweigh_comp_t *out);
+
+#endif /* MAIN_CHECKWEIGH_H_ */
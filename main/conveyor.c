@@ -0,0 +1,226 @@
+/*
+ * conveyor.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ */
+
+#include "conveyor.h"
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "driver/pulse_cnt.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+
+#define TAG "conveyor"
+
+/*
+ * Encoder channels A/B. The internal EMAC owns GPIO0 (REF_CLK), 19/21/22
+ * (TXD0, TX_EN, TXD1), 25/26/27 (RXD0, RXD1, CRS_DV) and the configured
+ * MDC/MDIO pins (23/18), so the encoder uses 32/33, which keep their
+ * internal pull-ups for open-collector encoders.
+ */
+#define CONVEYOR_ENC_A_GPIO         32
+#define CONVEYOR_ENC_B_GPIO         33
+
+#ifdef CONFIG_EXAMPLE_ETH_MDIO_GPIO
+_Static_assert(CONVEYOR_ENC_A_GPIO != CONFIG_EXAMPLE_ETH_MDIO_GPIO && CONVEYOR_ENC_B_GPIO != CONFIG_EXAMPLE_ETH_MDIO_GPIO &&
+               CONVEYOR_ENC_A_GPIO != CONFIG_EXAMPLE_ETH_MDC_GPIO && CONVEYOR_ENC_B_GPIO != CONFIG_EXAMPLE_ETH_MDC_GPIO,
+               "encoder pins collide with the Ethernet MDC/MDIO pins");
+#endif
+
+// Hardware counter range; with accum_count the driver extends it on each limit
+#define CONVEYOR_PCNT_LIMIT         30000
+#define CONVEYOR_GLITCH_NS          1000
+
+typedef struct {
+    bool                 used;
+    int32_t              position;
+    conveyor_action_fn_t fn;
+    void                *arg;
+} conveyor_action_t;
+
+static pcnt_unit_handle_t pcnt_unit = NULL;
+static esp_timer_handle_t poll_timer = NULL;
+static esp_timer_handle_t speed_timer = NULL;
+static conveyor_action_t actions[CONVEYOR_MAX_ACTIONS];
+static uint32_t pending = 0;
+static portMUX_TYPE actions_mux = portMUX_INITIALIZER_UNLOCKED;
+static volatile int32_t speed_mm_s = 0;
+
+int32_t conveyor_position(void)
+{
+    int count = 0;
+
+    if (pcnt_unit != NULL) {
+        pcnt_unit_get_count(pcnt_unit, &count);
+    }
+    return (int32_t)count;
+}
+
+int32_t conveyor_position_at(int64_t timestamp_us)
+{
+    int64_t back_us = esp_timer_get_time() - timestamp_us;
+
+    return conveyor_position() - CONVEYOR_MM((int64_t)speed_mm_s * back_us / 1000000);
+}
+
+int64_t conveyor_time_at(int32_t position)
+{
+    int32_t v = speed_mm_s;
+    int64_t now = esp_timer_get_time();
+
+    if (v == 0) {
+        return now;
+    }
+    int32_t ahead = position - conveyor_position();
+    return now + (int64_t)ahead * 1000 * 1000000 / ((int64_t)CONVEYOR_COUNTS_PER_M * v);
+}
+
+int32_t conveyor_speed_mm_s(void)
+{
+    return speed_mm_s;
+}
+
+static void conveyor_speed_cb(void *arg)
+{
+    static int32_t last_pos = 0;
+    int32_t pos = conveyor_position();
+
+    speed_mm_s = (int32_t)((int64_t)(pos - last_pos) * 1000 * 1000 /
+                           ((int64_t)CONVEYOR_COUNTS_PER_M * CONVEYOR_SPEED_PERIOD_MS));
+    last_pos = pos;
+}
+
+static void conveyor_poll_cb(void *arg)
+{
+    int32_t pos = conveyor_position();
+
+    for (int i = 0; i < CONVEYOR_MAX_ACTIONS; i++) {
+        conveyor_action_fn_t fn = NULL;
+        void *fn_arg = NULL;
+
+        portENTER_CRITICAL(&actions_mux);
+        conveyor_action_t *a = &actions[i];
+        // Wrap-safe: reached once the difference is no longer negative
+        if (a->used && (int32_t)(pos - a->position) >= 0) {
+            fn = a->fn;
+            fn_arg = a->arg;
+            a->used = false;
+            pending--;
+        }
+        portEXIT_CRITICAL(&actions_mux);
+
+        if (fn != NULL) {
+            fn(fn_arg);
+        }
+    }
+
+    // Start and stop under the same lock as pending, so a concurrent schedule cannot be missed
+    portENTER_CRITICAL(&actions_mux);
+    if (pending == 0) {
+        esp_timer_stop(poll_timer);
+    }
+    portEXIT_CRITICAL(&actions_mux);
+}
+
+esp_err_t conveyor_schedule(int32_t position, conveyor_action_fn_t fn, void *arg)
+{
+    esp_err_t err = ESP_ERR_NO_MEM;
+
+    portENTER_CRITICAL(&actions_mux);
+    for (int i = 0; i < CONVEYOR_MAX_ACTIONS; i++) {
+        if (!actions[i].used) {
+            actions[i] = (conveyor_action_t){ .used = true, .position = position, .fn = fn, .arg = arg };
+            if (pending++ == 0) {
+                esp_timer_start_periodic(poll_timer, CONVEYOR_POLL_US);
+            }
+            err = ESP_OK;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&actions_mux);
+
+    return err;
+}
+
+esp_err_t conveyor_cancel(conveyor_action_fn_t fn, void *arg)
+{
+    esp_err_t err = ESP_ERR_NOT_FOUND;
+
+    portENTER_CRITICAL(&actions_mux);
+    for (int i = 0; i < CONVEYOR_MAX_ACTIONS; i++) {
+        if (actions[i].used && actions[i].fn == fn && actions[i].arg == arg) {
+            actions[i].used = false;
+            pending--;      // the poll timer stops itself when nothing is left
+            err = ESP_OK;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&actions_mux);
+
+    return err;
+}
+
+void conveyor_init(void)
+{
+    pcnt_unit_config_t unit_config = {
+        .high_limit = CONVEYOR_PCNT_LIMIT,
+        .low_limit = -CONVEYOR_PCNT_LIMIT,
+        .flags.accum_count = 1,
+    };
+    ESP_ERROR_CHECK(pcnt_new_unit(&unit_config, &pcnt_unit));
+
+    pcnt_glitch_filter_config_t filter_config = {
+        .max_glitch_ns = CONVEYOR_GLITCH_NS,
+    };
+    ESP_ERROR_CHECK(pcnt_unit_set_glitch_filter(pcnt_unit, &filter_config));
+
+    // x4 quadrature decoding: both edges of both channels
+    pcnt_chan_config_t chan_a_config = {
+        .edge_gpio_num = CONVEYOR_ENC_A_GPIO,
+        .level_gpio_num = CONVEYOR_ENC_B_GPIO,
+    };
+    pcnt_chan_config_t chan_b_config = {
+        .edge_gpio_num = CONVEYOR_ENC_B_GPIO,
+        .level_gpio_num = CONVEYOR_ENC_A_GPIO,
+    };
+    pcnt_channel_handle_t chan_a = NULL;
+    pcnt_channel_handle_t chan_b = NULL;
+    ESP_ERROR_CHECK(pcnt_new_channel(pcnt_unit, &chan_a_config, &chan_a));
+    ESP_ERROR_CHECK(pcnt_new_channel(pcnt_unit, &chan_b_config, &chan_b));
+    ESP_ERROR_CHECK(pcnt_channel_set_edge_action(chan_a, PCNT_CHANNEL_EDGE_ACTION_DECREASE,
+                                                 PCNT_CHANNEL_EDGE_ACTION_INCREASE));
+    ESP_ERROR_CHECK(pcnt_channel_set_level_action(chan_a, PCNT_CHANNEL_LEVEL_ACTION_KEEP,
+                                                  PCNT_CHANNEL_LEVEL_ACTION_INVERSE));
+    ESP_ERROR_CHECK(pcnt_channel_set_edge_action(chan_b, PCNT_CHANNEL_EDGE_ACTION_INCREASE,
+                                                 PCNT_CHANNEL_EDGE_ACTION_DECREASE));
+    ESP_ERROR_CHECK(pcnt_channel_set_level_action(chan_b, PCNT_CHANNEL_LEVEL_ACTION_KEEP,
+                                                  PCNT_CHANNEL_LEVEL_ACTION_INVERSE));
+
+    // The driver accumulates overflows only at watch points on the limits
+    ESP_ERROR_CHECK(pcnt_unit_add_watch_point(pcnt_unit, CONVEYOR_PCNT_LIMIT));
+    ESP_ERROR_CHECK(pcnt_unit_add_watch_point(pcnt_unit, -CONVEYOR_PCNT_LIMIT));
+
+    ESP_ERROR_CHECK(pcnt_unit_enable(pcnt_unit));
+    ESP_ERROR_CHECK(pcnt_unit_clear_count(pcnt_unit));
+    ESP_ERROR_CHECK(pcnt_unit_start(pcnt_unit));
+
+    esp_timer_create_args_t poll_args = {
+        .callback = conveyor_poll_cb,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "conveyor",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&poll_args, &poll_timer));
+
+    esp_timer_create_args_t speed_args = {
+        .callback = conveyor_speed_cb,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "conveyor_speed",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&speed_args, &speed_timer));
+    ESP_ERROR_CHECK(esp_timer_start_periodic(speed_timer, CONVEYOR_SPEED_PERIOD_MS * 1000));
+
+    ESP_LOGI(TAG, "Encoder on GPIO %d/%d, %d counts/m", CONVEYOR_ENC_A_GPIO, CONVEYOR_ENC_B_GPIO,
+             CONVEYOR_COUNTS_PER_M);
+}
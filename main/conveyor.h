@@ -0,0 +1,69 @@
+/*
+ * conveyor.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ *
+ * Weighing conveyor position from a quadrature encoder counted by the
+ * PCNT peripheral, and actions scheduled at a belt position instead of
+ * after a fixed delay. Pending actions are checked every
+ * CONVEYOR_POLL_US by an esp_timer that only runs while something is
+ * scheduled; callbacks run in the esp_timer task and must be short.
+ */
+
+#ifndef MAIN_CONVEYOR_H_
+#define MAIN_CONVEYOR_H_
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#define CONVEYOR_COUNTS_PER_M       8000    // 600 ppr x4 on a 300 mm roller; set for the fitted encoder
+#define CONVEYOR_MAX_ACTIONS        8
+#define CONVEYOR_POLL_US            1000    // position check period while actions are pending
+#define CONVEYOR_SPEED_PERIOD_MS    50
+
+#define CONVEYOR_MM(mm)             ((int32_t)(((int64_t)(mm) * CONVEYOR_COUNTS_PER_M) / 1000))
+
+typedef void (*conveyor_action_fn_t)(void *arg);
+
+/**
+ * @brief Set up the PCNT unit and the timers.
+ */
+void conveyor_init(void);
+
+/**
+ * @brief Belt position in encoder counts; wraps, compare differences only.
+ */
+int32_t conveyor_position(void);
+
+/**
+ * @brief Belt position at an earlier esp_timer timestamp (e.g. a sensor edge),
+ * extrapolated back with the current speed.
+ */
+int32_t conveyor_position_at(int64_t timestamp_us);
+
+/**
+ * @brief esp_timer timestamp at which the belt was or will be at position,
+ * extrapolated with the current speed; now if the belt stands.
+ */
+int64_t conveyor_time_at(int32_t position);
+
+/**
+ * @brief Belt speed in mm/s, positive in the running direction.
+ */
+int32_t conveyor_speed_mm_s(void);
+
+/**
+ * @brief Run fn(arg) once the belt has reached position (counts).
+ * A position already passed runs at the next poll.
+ * @return ESP_OK, ESP_ERR_NO_MEM if CONVEYOR_MAX_ACTIONS are pending.
+ */
+esp_err_t conveyor_schedule(int32_t position, conveyor_action_fn_t fn, void *arg);
+
+/**
+ * @brief Drop a pending action scheduled with this fn and arg.
+ * @return ESP_OK, ESP_ERR_NOT_FOUND if it already ran or was never scheduled.
+ */
+esp_err_t conveyor_cancel(conveyor_action_fn_t fn, void *arg);
+
+#endif /* MAIN_CONVEYOR_H_ */
@@ -0,0 +1,120 @@
+/*
+ * cube_tracker.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ */
+
+#include "cube_tracker.h"
+#include <string.h>
+
+#define SLOT(t, i)  (&(t)->items[((t)->head + (i)) & (CUBE_TRACKER_MAX - 1)])
+
+void cube_tracker_init(cube_tracker_t *t)
+{
+    memset(t, 0, sizeof(*t));
+    t->next_id = 1;
+}
+
+cube_t *cube_tracker_add(cube_tracker_t *t, int64_t ts_us)
+{
+    if (t->count == CUBE_TRACKER_MAX) {
+        t->lost++;
+        return NULL;
+    }
+
+    cube_t *c = SLOT(t, t->count);
+    t->count++;
+
+    c->id = t->next_id++;
+    if (t->next_id == 0) {
+        t->next_id = 1;
+    }
+    c->zone = CUBE_ZONE_WEIGH;
+    c->verdict = CUBE_VERDICT_PENDING;
+    c->weight_g = 0;
+    c->entered_us = ts_us;
+    c->robot_seq = 0;
+    return c;
+}
+
+cube_t *cube_tracker_oldest_in(cube_tracker_t *t, cube_zone_t zone)
+{
+    for (uint8_t i = 0; i < t->count; i++) {
+        cube_t *c = SLOT(t, i);
+        if (c->zone == zone) {
+            return c;
+        }
+    }
+    return NULL;
+}
+
+cube_t *cube_tracker_oldest_unweighed(cube_tracker_t *t)
+{
+    for (uint8_t i = 0; i < t->count; i++) {
+        cube_t *c = SLOT(t, i);
+        if (c->zone == CUBE_ZONE_WEIGH && c->verdict == CUBE_VERDICT_PENDING) {
+            return c;
+        }
+    }
+    return NULL;
+}
+
+cube_t *cube_tracker_find(cube_tracker_t *t, uint16_t id)
+{
+    for (uint8_t i = 0; i < t->count; i++) {
+        cube_t *c = SLOT(t, i);
+        if (c->id == id) {
+            return c;
+        }
+    }
+    return NULL;
+}
+
+cube_t *cube_tracker_find_robot_seq(cube_tracker_t *t, uint16_t seq)
+{
+    if (seq == 0) {
+        return NULL;
+    }
+    for (uint8_t i = 0; i < t->count; i++) {
+        cube_t *c = SLOT(t, i);
+        if (c->robot_seq == seq) {
+            return c;
+        }
+    }
+    return NULL;
+}
+
+void cube_tracker_remove(cube_tracker_t *t, cube_t *cube)
+{
+    uint8_t i = 0;
+    while (i < t->count && SLOT(t, i) != cube) {
+        i++;
+    }
+    if (i == t->count) {
+        return;
+    }
+
+    // Close the gap by shifting older records up by one, then drop the head
+    for (; i > 0; i--) {
+        *SLOT(t, i) = *SLOT(t, i - 1);
+    }
+    t->head = (t->head + 1) & (CUBE_TRACKER_MAX - 1);
+    t->count--;
+}
+
+uint8_t cube_tracker_count(const cube_tracker_t *t)
+{
+    return t->count;
+}
+
+uint8_t cube_tracker_count_in(const cube_tracker_t *t, cube_zone_t zone)
+{
+    uint8_t n = 0;
+    for (uint8_t i = 0; i < t->count; i++) {
+        if (t->items[(t->head + i) & (CUBE_TRACKER_MAX - 1)].zone == zone) {
+            n++;
+        }
+    }
+    return n;
+}
@@ -0,0 +1,86 @@
+/*
+ * cube_tracker.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ *
+ * FIFO of cubes in flight along the line. Cubes cannot overtake each
+ * other on the conveyors, so every sensor edge applies to the oldest cube
+ * in the zone it leaves.
+ */
+
+#ifndef MAIN_CUBE_TRACKER_H_
+#define MAIN_CUBE_TRACKER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define CUBE_TRACKER_MAX    16      // Power of two
+
+typedef enum {
+    CUBE_ZONE_WEIGH = 0,    // on the weighing conveyor (T1 .. T2)
+    CUBE_ZONE_TRANSFER,     // past the ejector, on its way to the robot (T2 .. T3)
+    CUBE_ZONE_PICKUP,       // at T3, waiting for the robot
+    CUBE_ZONE_ROBOT         // accepted by the robot, being placed
+} cube_zone_t;
+
+typedef enum {
+    CUBE_VERDICT_PENDING = 0,
+    CUBE_VERDICT_ACCEPT,
+    CUBE_VERDICT_REJECT
+} cube_verdict_t;
+
+typedef struct {
+    uint16_t       id;
+    cube_zone_t    zone;
+    cube_verdict_t verdict;
+    int32_t        weight_g;
+    int64_t        entered_us;  // T1 edge timestamp
+    uint16_t       robot_seq;   // robot link sequence number of its PLACE_CUBE, 0 if none
+} cube_t;
+
+typedef struct {
+    cube_t   items[CUBE_TRACKER_MAX];
+    uint8_t  head;      // index of the oldest cube
+    uint8_t  count;
+    uint16_t next_id;
+    uint32_t lost;      // cubes dropped because the tracker was full
+} cube_tracker_t;
+
+void cube_tracker_init(cube_tracker_t *t);
+
+/**
+ * @brief Register a new cube entering the weighing zone.
+ * @return the new record, or NULL if the tracker is full.
+ */
+cube_t *cube_tracker_add(cube_tracker_t *t, int64_t ts_us);
+
+/**
+ * @brief Oldest cube in @p zone, or NULL.
+ */
+cube_t *cube_tracker_oldest_in(cube_tracker_t *t, cube_zone_t zone);
+
+/**
+ * @brief Oldest cube still waiting for its weigh verdict, or NULL.
+ */
+cube_t *cube_tracker_oldest_unweighed(cube_tracker_t *t);
+
+/**
+ * @brief Cube with this id, or NULL.
+ */
+cube_t *cube_tracker_find(cube_tracker_t *t, uint16_t id);
+
+/**
+ * @brief Cube whose PLACE_CUBE was sent with this robot sequence number, or NULL.
+ */
+cube_t *cube_tracker_find_robot_seq(cube_tracker_t *t, uint16_t seq);
+
+/**
+ * @brief Remove a cube (ejected or placed). Records behind it keep their order.
+ */
+void cube_tracker_remove(cube_tracker_t *t, cube_t *cube);
+
+uint8_t cube_tracker_count(const cube_tracker_t *t);
+uint8_t cube_tracker_count_in(const cube_tracker_t *t, cube_zone_t zone);
+
+#endif /* MAIN_CUBE_TRACKER_H_ */
@@ -0,0 +1,94 @@
+/*
+ * debounce.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ */
+
+#include "debounce.h"
+#include <string.h>
+
+void debounce_init(debounce_t *d, uint8_t count, uint32_t hold_us, uint32_t levels, int64_t now_us)
+{
+    memset(d, 0, sizeof(*d));
+    d->count = (count > DEBOUNCE_MAX_CHANNELS) ? DEBOUNCE_MAX_CHANNELS : count;
+    d->hold_us = hold_us;
+
+    for (uint8_t i = 0; i < d->count; i++) {
+        bool level = (levels >> i) & 1u;
+        d->ch[i].stable = level;
+        d->ch[i].pending = level;
+        d->ch[i].pending_since_us = now_us;
+        d->ch[i].changed_at_us = now_us;
+    }
+}
+
+void debounce_edge(debounce_t *d, uint8_t channel, bool level, int64_t ts_us)
+{
+    if (channel >= d->count) {
+        return;
+    }
+
+    debounce_channel_t *c = &d->ch[channel];
+
+    // Repeated edges with the same level (missed opposite edge) keep the original start time
+    if (c->pending != level) {
+        c->pending = level;
+        c->pending_since_us = ts_us;
+    }
+}
+
+void debounce_resync(debounce_t *d, uint32_t levels, int64_t now_us)
+{
+    for (uint8_t i = 0; i < d->count; i++) {
+        debounce_edge(d, i, (levels >> i) & 1u, now_us);
+    }
+}
+
+uint32_t debounce_update(debounce_t *d, int64_t now_us)
+{
+    uint32_t changed = 0;
+
+    for (uint8_t i = 0; i < d->count; i++) {
+        debounce_channel_t *c = &d->ch[i];
+
+        if (c->pending != c->stable && now_us - c->pending_since_us >= (int64_t)d->hold_us) {
+            c->stable = c->pending;
+            c->changed_at_us = c->pending_since_us;
+            changed |= 1u << i;
+        }
+    }
+
+    return changed;
+}
+
+uint32_t debounce_levels(const debounce_t *d)
+{
+    uint32_t levels = 0;
+
+    for (uint8_t i = 0; i < d->count; i++) {
+        if (d->ch[i].stable) {
+            levels |= 1u << i;
+        }
+    }
+
+    return levels;
+}
+
+int64_t debounce_next_deadline(const debounce_t *d)
+{
+    int64_t deadline = -1;
+
+    for (uint8_t i = 0; i < d->count; i++) {
+        const debounce_channel_t *c = &d->ch[i];
+
+        if (c->pending != c->stable) {
+            int64_t t = c->pending_since_us + d->hold_us;
+            if (deadline < 0 || t < deadline) {
+                deadline = t;
+            }
+        }
+    }
+
+    return deadline;
+}
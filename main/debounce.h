@@ -0,0 +1,74 @@
+/*
+ * debounce.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ *
+ * Per-channel software debouncer fed with timestamped edges.
+ */
+
+#ifndef MAIN_DEBOUNCE_H_
+#define MAIN_DEBOUNCE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define DEBOUNCE_MAX_CHANNELS   8
+
+typedef struct {
+    bool     stable;            // debounced level
+    bool     pending;           // last raw level seen
+    int64_t  pending_since_us;  // timestamp of the last raw edge
+    int64_t  changed_at_us;     // timestamp of the edge that produced 'stable'
+} debounce_channel_t;
+
+typedef struct {
+    debounce_channel_t ch[DEBOUNCE_MAX_CHANNELS];
+    uint8_t  count;
+    uint32_t hold_us;           // level must persist this long to be accepted
+} debounce_t;
+
+/**
+ * @brief Initialise the debouncer.
+ *
+ * @param d        Debouncer instance
+ * @param count    Number of channels (<= DEBOUNCE_MAX_CHANNELS)
+ * @param hold_us  Minimum time a level must be held to be accepted
+ * @param levels   Initial levels, bit n = channel n
+ * @param now_us   Current timestamp
+ */
+void debounce_init(debounce_t *d, uint8_t count, uint32_t hold_us, uint32_t levels, int64_t now_us);
+
+/**
+ * @brief Feed one raw edge captured on a channel.
+ */
+void debounce_edge(debounce_t *d, uint8_t channel, bool level, int64_t ts_us);
+
+/**
+ * @brief Feed the actual level of every channel as an edge at now_us.
+ *
+ * Used after edges were lost: channels whose last seen level is wrong
+ * restart their hold time from now_us instead of staying stuck.
+ */
+void debounce_resync(debounce_t *d, uint32_t levels, int64_t now_us);
+
+/**
+ * @brief Confirm pending levels that have been held long enough.
+ *
+ * @return Bit mask of channels whose debounced level changed.
+ */
+uint32_t debounce_update(debounce_t *d, int64_t now_us);
+
+/**
+ * @brief Debounced levels, bit n = channel n.
+ */
+uint32_t debounce_levels(const debounce_t *d);
+
+/**
+ * @brief Earliest timestamp at which a pending change can be confirmed.
+ *
+ * @return Deadline in microseconds, or -1 if nothing is pending.
+ */
+int64_t debounce_next_deadline(const debounce_t *d);
+
+#endif /* MAIN_DEBOUNCE_H_ */
@@ -0,0 +1,203 @@
+/*
+ * diag.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ */
+
+#include "diag.h"
+#include "freertos/task.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "io.h"
+#include "dlog.h"
+#include "event_log.h"
+#include "throughput.h"
+
+typedef struct {
+    uint32_t buckets[DIAG_HIST_BUCKETS];
+    uint32_t count;
+    uint32_t max_us;
+} diag_hist_t;
+
+typedef struct {
+    const char   *name;
+    QueueHandle_t handle;
+    UBaseType_t   peak;
+} diag_queue_entry_t;
+
+static diag_hist_t loop_hist[DIAG_LOOP_COUNT];
+static diag_queue_entry_t queues[DIAG_QUEUE_COUNT];
+
+static const char *const loop_names[DIAG_LOOP_COUNT] = {
+    [DIAG_LOOP_LOGIC] = "logic",
+    [DIAG_LOOP_ADC]   = "adc",
+};
+
+#if configUSE_TRACE_FACILITY && configGENERATE_RUN_TIME_STATS
+// Only touched by diag_write_json(), kept static to stay off the httpd stack
+static TaskStatus_t task_status[DIAG_MAX_TASKS];
+static struct {
+    UBaseType_t number;
+    configRUN_TIME_COUNTER_TYPE runtime;
+} prev_runtime[DIAG_MAX_TASKS];
+static size_t prev_count = 0;
+static configRUN_TIME_COUNTER_TYPE prev_total = 0;
+#endif
+
+void diag_loop_record(diag_loop_t loop, uint32_t us)
+{
+    diag_hist_t *h = &loop_hist[loop];
+    uint32_t bucket = 0;
+
+    // floor(log2(us)), saturating in the last bucket
+    for (uint32_t v = us >> 1; v != 0 && bucket < DIAG_HIST_BUCKETS - 1; v >>= 1) {
+        bucket++;
+    }
+    h->buckets[bucket]++;
+    h->count++;
+    if (us > h->max_us) {
+        h->max_us = us;
+    }
+}
+
+void diag_register_queue(diag_queue_t id, const char *name, QueueHandle_t queue)
+{
+    queues[id].name = name;
+    queues[id].peak = 0;
+    queues[id].handle = queue;
+}
+
+void diag_queue_sample(diag_queue_t id)
+{
+    diag_queue_entry_t *q = &queues[id];
+
+    if (q->handle != NULL) {
+        UBaseType_t waiting = uxQueueMessagesWaiting(q->handle);
+        if (waiting > q->peak) {
+            q->peak = waiting;
+        }
+    }
+}
+
+#if configUSE_TRACE_FACILITY && configGENERATE_RUN_TIME_STATS
+static configRUN_TIME_COUNTER_TYPE diag_prev_runtime(UBaseType_t number)
+{
+    for (size_t i = 0; i < prev_count; i++) {
+        if (prev_runtime[i].number == number) {
+            return prev_runtime[i].runtime;
+        }
+    }
+    return 0;
+}
+
+static void diag_write_tasks(json_writer_t *w)
+{
+    configRUN_TIME_COUNTER_TYPE total = 0;
+    UBaseType_t n = uxTaskGetSystemState(task_status, DIAG_MAX_TASKS, &total);
+    // Task counters run per core, so the load is relative to one core
+    configRUN_TIME_COUNTER_TYPE elapsed = total - prev_total;
+
+    json_writer_array_begin(w, "tasks");
+    for (UBaseType_t i = 0; i < n; i++) {
+        const TaskStatus_t *t = &task_status[i];
+        configRUN_TIME_COUNTER_TYPE ran = t->ulRunTimeCounter - diag_prev_runtime(t->xTaskNumber);
+
+        json_writer_object_begin(w, NULL);
+        json_writer_str(w, "name", t->pcTaskName);
+        json_writer_uint(w, "prio", t->uxCurrentPriority);
+#if configTASKLIST_INCLUDE_COREID
+        json_writer_int(w, "core", t->xCoreID == tskNO_AFFINITY ? -1 : (int64_t)t->xCoreID);
+#endif
+        // Bytes on ESP-IDF, StackType_t is uint8_t
+        json_writer_uint(w, "stackFree", t->usStackHighWaterMark);
+        json_writer_fixed(w, "cpu", elapsed ? (int32_t)((uint64_t)ran * 1000 / elapsed) : 0, 1);
+        json_writer_object_end(w);
+    }
+    json_writer_array_end(w);
+
+    if (n == 0) {
+        DLOGW("diag", "More than %" PRIu32 " tasks, task list skipped", DIAG_MAX_TASKS);
+    }
+
+    prev_count = n;
+    prev_total = total;
+    for (UBaseType_t i = 0; i < n; i++) {
+        prev_runtime[i].number = task_status[i].xTaskNumber;
+        prev_runtime[i].runtime = task_status[i].ulRunTimeCounter;
+    }
+}
+#endif
+
+static void diag_write_queues(json_writer_t *w)
+{
+    json_writer_array_begin(w, "queues");
+    for (int i = 0; i < DIAG_QUEUE_COUNT; i++) {
+        diag_queue_entry_t *q = &queues[i];
+        if (q->handle == NULL) {
+            continue;
+        }
+        diag_queue_sample((diag_queue_t)i);
+
+        json_writer_object_begin(w, NULL);
+        json_writer_str(w, "name", q->name);
+        json_writer_uint(w, "waiting", uxQueueMessagesWaiting(q->handle));
+        json_writer_uint(w, "free", uxQueueSpacesAvailable(q->handle));
+        json_writer_uint(w, "peak", q->peak);
+        json_writer_object_end(w);
+    }
+    json_writer_array_end(w);
+}
+
+static void diag_write_loops(json_writer_t *w)
+{
+    json_writer_object_begin(w, "loops");
+    for (int i = 0; i < DIAG_LOOP_COUNT; i++) {
+        const diag_hist_t *h = &loop_hist[i];
+        int last = DIAG_HIST_BUCKETS - 1;
+
+        // Drop trailing empty buckets to keep the output short
+        while (last >= 0 && h->buckets[last] == 0) {
+            last--;
+        }
+
+        json_writer_object_begin(w, loop_names[i]);
+        json_writer_uint(w, "count", h->count);
+        json_writer_uint(w, "maxUs", h->max_us);
+        json_writer_array_begin(w, "log2Us");
+        for (int b = 0; b <= last; b++) {
+            json_writer_uint(w, NULL, h->buckets[b]);
+        }
+        json_writer_array_end(w);
+        json_writer_object_end(w);
+    }
+    json_writer_object_end(w);
+}
+
+void diag_write_json(json_writer_t *w)
+{
+    json_writer_object_begin(w, NULL);
+
+    json_writer_uint(w, "uptimeMs", (uint64_t)(esp_timer_get_time() / 1000));
+#if configUSE_TRACE_FACILITY && configGENERATE_RUN_TIME_STATS
+    diag_write_tasks(w);
+#endif
+    diag_write_queues(w);
+
+    json_writer_object_begin(w, "heap");
+    json_writer_uint(w, "free", heap_caps_get_free_size(MALLOC_CAP_INTERNAL));
+    json_writer_uint(w, "minFree", heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL));
+    json_writer_uint(w, "largest", heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL));
+    json_writer_object_end(w);
+
+    diag_write_loops(w);
+    throughput_write_json(w, "line");
+
+    json_writer_object_begin(w, "drops");
+    json_writer_uint(w, "ioEdges", io_get_edge_overruns());
+    json_writer_uint(w, "dlog", dlog_dropped());
+    json_writer_uint(w, "eventLog", event_log_dropped());
+    json_writer_object_end(w);
+
+    json_writer_object_end(w);
+}
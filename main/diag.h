@@ -0,0 +1,62 @@
+/*
+ * diag.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ *
+ * Runtime diagnostics for sizing the budgets in tasks_common.h: per-task
+ * CPU load and stack headroom from the FreeRTOS run-time stats, queue
+ * depths with their peaks, internal heap, loop-time histograms of the
+ * control tasks and the line throughput. Served as JSON at /api/diag.
+ *
+ * Needs CONFIG_FREERTOS_USE_TRACE_FACILITY and
+ * CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS; without them the task list is
+ * left out and the rest still works.
+ */
+
+#ifndef MAIN_DIAG_H_
+#define MAIN_DIAG_H_
+
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "json_writer.h"
+
+#define DIAG_MAX_TASKS          24
+#define DIAG_HIST_BUCKETS       16      // bucket n counts loops of [2^n, 2^(n+1)) us, bucket 0 also < 1 us
+
+typedef enum {
+    DIAG_LOOP_LOGIC = 0,        // logic_task, one event
+    DIAG_LOOP_ADC,              // adc_task, one batch of DMA frames
+    DIAG_LOOP_COUNT
+} diag_loop_t;
+
+typedef enum {
+    DIAG_QUEUE_LOGIC_EVENT = 0,
+    DIAG_QUEUE_TCP_COMMAND,
+    DIAG_QUEUE_DLOG,
+    DIAG_QUEUE_COUNT
+} diag_queue_t;
+
+/**
+ * @brief Add one loop duration to the histogram; one writer task per loop.
+ */
+void diag_loop_record(diag_loop_t loop, uint32_t us);
+
+/**
+ * @brief Make a queue visible in the report.
+ */
+void diag_register_queue(diag_queue_t id, const char *name, QueueHandle_t queue);
+
+/**
+ * @brief Update the peak depth; called by the consumer before it drains the queue.
+ */
+void diag_queue_sample(diag_queue_t id);
+
+/**
+ * @brief Write the report as one JSON object. CPU load is measured since the previous call,
+ * so call it from one task only (the HTTP server).
+ */
+void diag_write_json(json_writer_t *w);
+
+#endif /* MAIN_DIAG_H_ */
@@ -0,0 +1,106 @@
+/*
+ * dlog.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ */
+
+#include "dlog.h"
+#include <stdio.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "tasks_common.h"
+#include "diag.h"
+
+#define DLOG_LINE_MAX   160
+
+static QueueHandle_t dlog_queue = NULL;
+static volatile uint32_t dropped = 0;
+
+static void dlog_output(const dlog_record_t *rec)
+{
+    char line[DLOG_LINE_MAX];
+    char extra[32] = "";
+    const uintptr_t *a = rec->args;
+
+    // Arguments are always passed; the format consumes as many as it names
+    snprintf(line, sizeof(line), rec->fmt, a[0], a[1], a[2], a[3]);
+    if (rec->suppressed > 0) {
+        snprintf(extra, sizeof(extra), " (+%u suppressed)", rec->suppressed);
+    }
+
+    switch (rec->level) {
+        case ESP_LOG_ERROR:
+            esp_log_write(ESP_LOG_ERROR, rec->tag, LOG_FORMAT(E, "%s%s"), rec->time_ms, rec->tag, line, extra);
+            break;
+        case ESP_LOG_WARN:
+            esp_log_write(ESP_LOG_WARN, rec->tag, LOG_FORMAT(W, "%s%s"), rec->time_ms, rec->tag, line, extra);
+            break;
+        case ESP_LOG_INFO:
+            esp_log_write(ESP_LOG_INFO, rec->tag, LOG_FORMAT(I, "%s%s"), rec->time_ms, rec->tag, line, extra);
+            break;
+        case ESP_LOG_DEBUG:
+            esp_log_write(ESP_LOG_DEBUG, rec->tag, LOG_FORMAT(D, "%s%s"), rec->time_ms, rec->tag, line, extra);
+            break;
+        default:
+            esp_log_write(ESP_LOG_VERBOSE, rec->tag, LOG_FORMAT(V, "%s%s"), rec->time_ms, rec->tag, line, extra);
+            break;
+    }
+}
+
+static void dlog_task(void *pvParameters)
+{
+    dlog_record_t rec;
+    uint32_t reported = 0;
+
+    for (;;) {
+        diag_queue_sample(DIAG_QUEUE_DLOG);
+        if (xQueueReceive(dlog_queue, &rec, portMAX_DELAY) == pdTRUE) {
+            dlog_output(&rec);
+        }
+
+        uint32_t lost = dropped;
+        if (lost != reported) {
+            ESP_LOGW("dlog", "%lu log records dropped", (unsigned long)(lost - reported));
+            reported = lost;
+        }
+    }
+}
+
+void dlog_init(void)
+{
+    dlog_queue = xQueueCreate(DLOG_QUEUE_LEN, sizeof(dlog_record_t));
+    diag_register_queue(DIAG_QUEUE_DLOG, "dlog", dlog_queue);
+    xTaskCreatePinnedToCore(dlog_task, "dlog", DLOG_TASK_STACK_SIZE, NULL,
+                            DLOG_TASK_PRIORITY, NULL, DLOG_TASK_CORE_ID);
+}
+
+void dlog_post(esp_log_level_t level, const char *tag, const char *fmt, uint16_t suppressed,
+               uint32_t nargs, const uintptr_t *args)
+{
+    // Skip the copy entirely when the runtime level filters this tag out
+    if (dlog_queue == NULL || esp_log_level_get(tag) < level) {
+        return;
+    }
+
+    dlog_record_t rec = {
+        .tag = tag,
+        .fmt = fmt,
+        .time_ms = esp_log_timestamp(),
+        .suppressed = suppressed,
+        .level = (uint8_t)level,
+    };
+    for (uint32_t i = 0; i < nargs && i < DLOG_MAX_ARGS; i++) {
+        rec.args[i] = args[i];
+    }
+
+    if (xQueueSend(dlog_queue, &rec, 0) != pdTRUE) {
+        dropped++;
+    }
+}
+
+uint32_t dlog_dropped(void)
+{
+    return dropped;
+}
@@ -0,0 +1,108 @@
+/*
+ * dlog.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ *
+ * Deferred logging for the control tasks. A DLOG call only copies the
+ * format pointer and up to DLOG_MAX_ARGS integer arguments into a queue;
+ * a low-priority task on the other core does the formatting and the
+ * UART output through esp_log_write(), so the runtime log level still
+ * applies.
+ *
+ * Restrictions: the format string and any %s argument must be static
+ * (string literals, names tables; wrap them in DLOG_STR()), and arguments
+ * are stored as uintptr_t, so no floats or 64-bit values. Integers are
+ * formatted with PRId32 / PRIu32, which match int32_t and uint32_t on
+ * every target.
+ *
+ * Compile-time gating: calls above DLOG_LOCAL_LEVEL are removed by the
+ * compiler. It defaults to CONFIG_LOG_MAXIMUM_LEVEL; define it before
+ * including this header to raise or lower it for one module, e.g.
+ *     #define DLOG_LOCAL_LEVEL ESP_LOG_DEBUG
+ */
+
+#ifndef MAIN_DLOG_H_
+#define MAIN_DLOG_H_
+
+#include <inttypes.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#ifndef DLOG_LOCAL_LEVEL
+#define DLOG_LOCAL_LEVEL    CONFIG_LOG_MAXIMUM_LEVEL
+#endif
+
+#define DLOG_MAX_ARGS       4
+#define DLOG_QUEUE_LEN      32
+
+typedef struct {
+    const char *tag;
+    const char *fmt;
+    uint32_t    time_ms;
+    uintptr_t   args[DLOG_MAX_ARGS];     // pointer width, so %s arguments survive on 64-bit hosts
+    uint16_t    suppressed;     // repeats dropped by DLOG_RATELIMIT before this one
+    uint8_t     level;          // esp_log_level_t
+} dlog_record_t;
+
+/**
+ * @brief Create the record queue and the output task.
+ */
+void dlog_init(void);
+
+/**
+ * @brief Queue one record; never blocks, counts a drop when the queue is full.
+ */
+void dlog_post(esp_log_level_t level, const char *tag, const char *fmt, uint16_t suppressed,
+               uint32_t nargs, const uintptr_t *args);
+
+/**
+ * @brief Records lost because the queue was full.
+ */
+uint32_t dlog_dropped(void);
+
+// Pass a static string as a %s argument
+#define DLOG_STR(s)         ((uintptr_t)(s))
+
+#define DLOG_ARGS(...)      ((const uintptr_t[DLOG_MAX_ARGS]){ __VA_ARGS__ })
+#define DLOG_NARGS(...)     (sizeof((uintptr_t[]){ 0, ##__VA_ARGS__ }) / sizeof(uintptr_t) - 1)
+
+#define DLOG_LEVEL(level, tag, fmt, ...)                                                    \
+    do {                                                                                    \
+        if (DLOG_LOCAL_LEVEL >= (level)) {                                                  \
+            _Static_assert(DLOG_NARGS(__VA_ARGS__) <= DLOG_MAX_ARGS, "too many DLOG args"); \
+            dlog_post((level), (tag), (fmt), 0, DLOG_NARGS(__VA_ARGS__),                    \
+                      DLOG_ARGS(__VA_ARGS__));                                              \
+        }                                                                                   \
+    } while (0)
+
+#define DLOGE(tag, fmt, ...)    DLOG_LEVEL(ESP_LOG_ERROR, tag, fmt, ##__VA_ARGS__)
+#define DLOGW(tag, fmt, ...)    DLOG_LEVEL(ESP_LOG_WARN, tag, fmt, ##__VA_ARGS__)
+#define DLOGI(tag, fmt, ...)    DLOG_LEVEL(ESP_LOG_INFO, tag, fmt, ##__VA_ARGS__)
+#define DLOGD(tag, fmt, ...)    DLOG_LEVEL(ESP_LOG_DEBUG, tag, fmt, ##__VA_ARGS__)
+#define DLOGV(tag, fmt, ...)    DLOG_LEVEL(ESP_LOG_VERBOSE, tag, fmt, ##__VA_ARGS__)
+
+/**
+ * Log at most once per period_ms from this call site; repeats in between
+ * are counted and reported with the next message that gets through.
+ * Meant for error paths that can fire on every sample (queue full,
+ * overruns).
+ */
+#define DLOG_RATELIMIT(period_ms, level, tag, fmt, ...)                                     \
+    do {                                                                                    \
+        if (DLOG_LOCAL_LEVEL >= (level)) {                                                  \
+            static int64_t dlog_last_us_ = INT64_MIN / 2;                                   \
+            static uint16_t dlog_skipped_ = 0;                                              \
+            int64_t dlog_now_us_ = esp_timer_get_time();                                    \
+            if (dlog_now_us_ - dlog_last_us_ >= (int64_t)(period_ms) * 1000) {              \
+                dlog_last_us_ = dlog_now_us_;                                               \
+                dlog_post((level), (tag), (fmt), dlog_skipped_, DLOG_NARGS(__VA_ARGS__),    \
+                          DLOG_ARGS(__VA_ARGS__));                                          \
+                dlog_skipped_ = 0;                                                          \
+            } else if (dlog_skipped_ < UINT16_MAX) {                                        \
+                dlog_skipped_++;                                                            \
+            }                                                                               \
+        }                                                                                   \
+    } while (0)
+
+#endif /* MAIN_DLOG_H_ */
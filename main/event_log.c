@@ -0,0 +1,381 @@
+/*
+ * event_log.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ */
+
+#include "event_log.h"
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_partition.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "tasks_common.h"
+
+#define TAG "event_log"
+
+#define EVENT_LOG_SECTOR_SIZE       4096
+#define EVENT_LOG_SECTOR_RECORDS    (EVENT_LOG_SECTOR_SIZE / sizeof(event_log_record_t))
+#define EVENT_LOG_MAX_SECTORS       64
+#define EVENT_LOG_READ_CHUNK        16
+#define EVENT_LOG_SEQ_EMPTY         0xFFFFFFFFu
+#define EVENT_LOG_RING_MASK         (EVENT_LOG_RAM_RECORDS - 1)
+
+static const char *const event_log_names[EVENT_LOG_TYPE_COUNT] = {
+    [EVENT_LOG_BOOT]            = "BOOT",
+    [EVENT_LOG_CUBE_IN]         = "CUBE_IN",
+    [EVENT_LOG_ACCEPT]          = "ACCEPT",
+    [EVENT_LOG_REJECT]          = "REJECT",
+    [EVENT_LOG_UNSTABLE]        = "UNSTABLE",
+    [EVENT_LOG_EJECT]           = "EJECT",
+    [EVENT_LOG_PLACED]          = "PLACED",
+    [EVENT_LOG_ROBOT_FAULT]     = "ROBOT_FAULT",
+    [EVENT_LOG_WRAP_START]      = "WRAP_START",
+    [EVENT_LOG_WRAP_DONE]       = "WRAP_DONE",
+    [EVENT_LOG_INVERTER_FAULT]  = "INVERTER_FAULT",
+    [EVENT_LOG_HMI_CMD]         = "HMI_CMD",
+};
+
+// RAM ring, filled by any task, drained by the flush task
+static portMUX_TYPE ring_lock = portMUX_INITIALIZER_UNLOCKED;
+static event_log_record_t ring[EVENT_LOG_RAM_RECORDS];
+static uint32_t ring_head = 0;          // next record to fill
+static uint32_t ring_tail = 0;          // next record to flush
+static uint32_t next_seq = 1;
+static uint32_t dropped = 0;
+static uint32_t flushes = 0;            // flushes that moved ring_tail, lets readers detect them
+
+// Flash side, guarded by flash_lock
+static const esp_partition_t *log_part = NULL;
+static SemaphoreHandle_t flash_lock = NULL;
+static uint16_t sector_count = 0;
+static uint32_t sector_first_seq[EVENT_LOG_MAX_SECTORS];
+static uint16_t head_sector = 0;        // next write position
+static uint16_t head_slot = 0;
+
+static TaskHandle_t task_event_log = NULL;
+
+static size_t event_log_offset(uint16_t sector, uint16_t slot)
+{
+    return (size_t)sector * EVENT_LOG_SECTOR_SIZE + (size_t)slot * sizeof(event_log_record_t);
+}
+
+static bool event_log_slot_erased(const event_log_record_t *rec)
+{
+    const uint8_t *p = (const uint8_t *)rec;
+
+    for (size_t i = 0; i < sizeof(*rec); i++) {
+        if (p[i] != 0xFF) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief First sequence number stored in a sector, EVENT_LOG_SEQ_EMPTY if it has none.
+ *
+ * Slot 0 alone does not tell: a torn or failed first write leaves it
+ * without seq while the records after it are valid.
+ */
+static uint32_t event_log_sector_first_seq(uint16_t sector)
+{
+    event_log_record_t rec;
+
+    for (uint16_t slot = 0; slot < EVENT_LOG_SECTOR_RECORDS; slot++) {
+        esp_partition_read(log_part, event_log_offset(sector, slot), &rec, sizeof(rec));
+        if (rec.seq != EVENT_LOG_SEQ_EMPTY) {
+            return rec.seq;
+        }
+        if (event_log_slot_erased(&rec)) {
+            break;      // rest of the sector is unwritten
+        }
+    }
+    return EVENT_LOG_SEQ_EMPTY;
+}
+
+/**
+ * @brief Find the newest sector and the first erased slot in it.
+ * @return last sequence number on flash, 0 if the log is empty.
+ */
+static uint32_t event_log_recover(void)
+{
+    event_log_record_t rec;
+    int newest = -1;
+
+    for (uint16_t s = 0; s < sector_count; s++) {
+        sector_first_seq[s] = event_log_sector_first_seq(s);
+        if (sector_first_seq[s] != EVENT_LOG_SEQ_EMPTY &&
+            (newest < 0 || sector_first_seq[s] > sector_first_seq[newest])) {
+            newest = s;
+        }
+    }
+
+    if (newest < 0) {
+        head_sector = 0;
+        head_slot = 0;
+        return 0;
+    }
+
+    uint32_t last_seq = sector_first_seq[newest];
+    uint16_t slot;
+    for (slot = 0; slot < EVENT_LOG_SECTOR_RECORDS; slot++) {
+        esp_partition_read(log_part, event_log_offset(newest, slot), &rec, sizeof(rec));
+        if (event_log_slot_erased(&rec)) {
+            break;
+        }
+        // A slot without seq is a write torn by power loss, skip it
+        if (rec.seq != EVENT_LOG_SEQ_EMPTY && rec.seq > last_seq) {
+            last_seq = rec.seq;
+        }
+    }
+
+    head_sector = newest;
+    head_slot = slot;
+    if (head_slot == EVENT_LOG_SECTOR_RECORDS) {
+        head_sector = (head_sector + 1) % sector_count;
+        head_slot = 0;
+    }
+    return last_seq;
+}
+
+static void event_log_write(const event_log_record_t *rec)
+{
+    if (head_slot == 0) {
+        // Reusing the oldest sector; its records are lost here
+        esp_partition_erase_range(log_part, event_log_offset(head_sector, 0), EVENT_LOG_SECTOR_SIZE);
+        sector_first_seq[head_sector] = EVENT_LOG_SEQ_EMPTY;
+    }
+
+    size_t off = event_log_offset(head_sector, head_slot);
+    const size_t seq_len = sizeof(rec->seq);
+
+    // Body first, then seq: a record with a seq is always complete
+    esp_partition_write(log_part, off + seq_len, (const uint8_t *)rec + seq_len, sizeof(*rec) - seq_len);
+    esp_partition_write(log_part, off, &rec->seq, seq_len);
+
+    if (head_slot == 0) {
+        sector_first_seq[head_sector] = rec->seq;
+    }
+    if (++head_slot == EVENT_LOG_SECTOR_RECORDS) {
+        head_sector = (head_sector + 1) % sector_count;
+        head_slot = 0;
+    }
+}
+
+static void event_log_flush(void)
+{
+    uint32_t head;
+
+    portENTER_CRITICAL(&ring_lock);
+    head = ring_head;
+    portEXIT_CRITICAL(&ring_lock);
+
+    if (head == ring_tail) {
+        return;
+    }
+
+    xSemaphoreTake(flash_lock, portMAX_DELAY);
+    for (uint32_t i = ring_tail; i != head; i++) {
+        event_log_write(&ring[i & EVENT_LOG_RING_MASK]);
+    }
+    // Advance while still holding flash_lock so readers see each record exactly once
+    portENTER_CRITICAL(&ring_lock);
+    ring_tail = head;
+    flushes++;
+    portEXIT_CRITICAL(&ring_lock);
+    xSemaphoreGive(flash_lock);
+}
+
+static void event_log_task(void *pvParameters)
+{
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(EVENT_LOG_FLUSH_MS));
+        event_log_flush();
+    }
+}
+
+void event_log_init(void)
+{
+    uint32_t last_seq = 0;
+
+    log_part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                        (esp_partition_subtype_t)EVENT_LOG_PARTITION_SUBTYPE,
+                                        EVENT_LOG_PARTITION_LABEL);
+    if (log_part == NULL) {
+        ESP_LOGW(TAG, "No '%s' partition, events are kept in RAM only", EVENT_LOG_PARTITION_LABEL);
+    } else {
+        flash_lock = xSemaphoreCreateMutex();
+        sector_count = log_part->size / EVENT_LOG_SECTOR_SIZE;
+        if (sector_count > EVENT_LOG_MAX_SECTORS) {
+            sector_count = EVENT_LOG_MAX_SECTORS;
+        }
+        last_seq = event_log_recover();
+        ESP_LOGI(TAG, "%u sectors, last seq %lu, writing at %u/%u",
+                 sector_count, (unsigned long)last_seq, head_sector, head_slot);
+
+        xTaskCreatePinnedToCore(event_log_task, "event_log", EVENT_LOG_TASK_STACK_SIZE, NULL,
+                                EVENT_LOG_TASK_PRIORITY, &task_event_log, EVENT_LOG_TASK_CORE_ID);
+    }
+
+    next_seq = last_seq + 1;
+    event_log_add(EVENT_LOG_BOOT, 0, (int32_t)esp_reset_reason(), EVENT_LOG_STATE_NONE);
+}
+
+void event_log_add(event_log_type_t type, uint16_t cube_id, int32_t weight_g, uint8_t state)
+{
+    uint32_t pending;
+    uint32_t time_ms = (uint32_t)(esp_timer_get_time() / 1000);
+
+    portENTER_CRITICAL(&ring_lock);
+    if (ring_head - ring_tail >= EVENT_LOG_RAM_RECORDS) {
+        if (log_part != NULL) {
+            dropped++;
+            portEXIT_CRITICAL(&ring_lock);
+            return;
+        }
+        ring_tail++;        // RAM only: overwrite the oldest record
+    }
+    event_log_record_t *rec = &ring[ring_head & EVENT_LOG_RING_MASK];
+    rec->seq = next_seq++;
+    rec->time_ms = time_ms;
+    rec->weight_g = weight_g;
+    rec->cube_id = cube_id;
+    rec->type = (uint8_t)type;
+    rec->state = state;
+    ring_head++;
+    pending = ring_head - ring_tail;
+    portEXIT_CRITICAL(&ring_lock);
+
+    // Flush early once the ring is half full
+    if (pending == EVENT_LOG_RAM_RECORDS / 2 && task_event_log != NULL) {
+        xTaskNotifyGive(task_event_log);
+    }
+}
+
+/**
+ * @brief Pass a chunk of records to the callback, keeping the sequence increasing.
+ * @return false once the reader is done.
+ */
+static bool event_log_emit(const event_log_record_t *recs, size_t n, uint32_t *next,
+                           size_t *count, size_t max, event_log_read_cb_t cb, void *ctx)
+{
+    for (size_t i = 0; i < n; i++) {
+        if (recs[i].seq == EVENT_LOG_SEQ_EMPTY || recs[i].seq < *next) {
+            continue;
+        }
+        *next = recs[i].seq + 1;
+        (*count)++;
+        if (!cb(ctx, &recs[i]) || *count >= max) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Pass the flash records with seq >= *next, oldest sector first.
+ * @return false once the reader is done.
+ */
+static bool event_log_read_flash(event_log_record_t *buf, uint32_t *next, size_t *count, size_t max,
+                                 event_log_read_cb_t cb, void *ctx)
+{
+    xSemaphoreTake(flash_lock, portMAX_DELAY);
+    uint16_t start = head_sector;
+    xSemaphoreGive(flash_lock);
+
+    // The lock is only held per chunk so flushing is not held up by slow clients
+    for (uint16_t k = 1; k <= sector_count; k++) {
+        uint16_t s = (start + k) % sector_count;
+        uint16_t following = (s + 1) % sector_count;
+
+        xSemaphoreTake(flash_lock, portMAX_DELAY);
+        bool skip = sector_first_seq[s] == EVENT_LOG_SEQ_EMPTY ||
+                    (k < sector_count && sector_first_seq[following] != EVENT_LOG_SEQ_EMPTY &&
+                     sector_first_seq[following] <= *next);
+        xSemaphoreGive(flash_lock);
+        if (skip) {
+            continue;
+        }
+
+        for (uint16_t slot = 0; slot < EVENT_LOG_SECTOR_RECORDS; slot += EVENT_LOG_READ_CHUNK) {
+            xSemaphoreTake(flash_lock, portMAX_DELAY);
+            esp_partition_read(log_part, event_log_offset(s, slot), buf, EVENT_LOG_READ_CHUNK * sizeof(*buf));
+            xSemaphoreGive(flash_lock);
+
+            if (!event_log_emit(buf, EVENT_LOG_READ_CHUNK, next, count, max, cb, ctx)) {
+                return false;
+            }
+            if (buf[EVENT_LOG_READ_CHUNK - 1].seq == EVENT_LOG_SEQ_EMPTY &&
+                event_log_slot_erased(&buf[EVENT_LOG_READ_CHUNK - 1])) {
+                break;      // rest of the sector is unwritten
+            }
+        }
+    }
+    return true;
+}
+
+size_t event_log_read(uint32_t from_seq, size_t max, event_log_read_cb_t cb, void *ctx)
+{
+    event_log_record_t buf[EVENT_LOG_READ_CHUNK];
+    uint32_t next = from_seq;
+    size_t count = 0;
+
+    if (max == 0) {
+        return 0;
+    }
+
+    /*
+     * Neither pass holds a lock for its whole length, so a flush can move
+     * records from the ring to flash behind the flash pass. Each ring chunk
+     * checks for that and the flash is scanned again from next.
+     */
+    for (;;) {
+        portENTER_CRITICAL(&ring_lock);
+        uint32_t flushes_seen = flushes;
+        portEXIT_CRITICAL(&ring_lock);
+
+        if (log_part != NULL && !event_log_read_flash(buf, &next, &count, max, cb, ctx)) {
+            return count;
+        }
+
+        // Records not flushed yet
+        for (;;) {
+            size_t n = 0;
+
+            portENTER_CRITICAL(&ring_lock);
+            bool flushed = flushes != flushes_seen;
+            for (uint32_t i = ring_tail; !flushed && i != ring_head && n < EVENT_LOG_READ_CHUNK; i++) {
+                const event_log_record_t *rec = &ring[i & EVENT_LOG_RING_MASK];
+                if (rec->seq >= next) {
+                    buf[n++] = *rec;
+                }
+            }
+            portEXIT_CRITICAL(&ring_lock);
+
+            if (flushed) {
+                break;
+            }
+            if (n == 0 || !event_log_emit(buf, n, &next, &count, max, cb, ctx)) {
+                return count;
+            }
+        }
+    }
+}
+
+const char *event_log_type_name(uint8_t type)
+{
+    if (type < EVENT_LOG_TYPE_COUNT && event_log_names[type] != NULL) {
+        return event_log_names[type];
+    }
+    return "UNKNOWN";
+}
+
+uint32_t event_log_dropped(void)
+{
+    return dropped;
+}
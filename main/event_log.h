@@ -0,0 +1,85 @@
+/*
+ * event_log.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ *
+ * Production event log. Records go into a RAM ring and are flushed in
+ * batches by a low-priority task to the "evlog" data partition, used as
+ * a circular set of append-only sectors: one sector erase per 256
+ * records, spread evenly over the partition. Sequence numbers continue
+ * across power cycles; each boot starts with an EVENT_LOG_BOOT record
+ * (weight_g holds the esp_reset_reason_t).
+ */
+
+#ifndef MAIN_EVENT_LOG_H_
+#define MAIN_EVENT_LOG_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define EVENT_LOG_PARTITION_LABEL   "evlog"
+#define EVENT_LOG_PARTITION_SUBTYPE 0x40
+#define EVENT_LOG_RAM_RECORDS       128     // power of two
+#define EVENT_LOG_FLUSH_MS          5000    // flush at least this often when records are pending
+
+#define EVENT_LOG_STATE_NONE        0xFF    // record not tied to the logic state
+
+typedef enum {
+    EVENT_LOG_BOOT = 0,
+    EVENT_LOG_CUBE_IN,          // cube detected on T1
+    EVENT_LOG_ACCEPT,           // weight in tolerance
+    EVENT_LOG_REJECT,           // weight out of tolerance
+    EVENT_LOG_UNSTABLE,         // weight did not settle or cube left the scale
+    EVENT_LOG_EJECT,            // ejector fired
+    EVENT_LOG_PLACED,           // robot finished placing the cube
+    EVENT_LOG_ROBOT_FAULT,      // robot error, timeout or disconnect; weight_g holds robot_reply_t
+    EVENT_LOG_WRAP_START,       // weight_g holds the cubes on the pallet
+    EVENT_LOG_WRAP_DONE,
+    EVENT_LOG_INVERTER_FAULT,   // weight_g holds modbus status << 8 | exception
+    EVENT_LOG_HMI_CMD,          // operator command, cube_id holds hmi_cmd_id_t, weight_g its argument
+    EVENT_LOG_TYPE_COUNT
+} event_log_type_t;
+
+// Flash record; seq is written last and marks the record as complete
+typedef struct __attribute__((packed)) {
+    uint32_t seq;
+    uint32_t time_ms;           // since boot
+    int32_t  weight_g;
+    uint16_t cube_id;
+    uint8_t  type;              // event_log_type_t
+    uint8_t  state;             // system_state_t or EVENT_LOG_STATE_NONE
+} event_log_record_t;
+
+/**
+ * @brief Receives records in sequence order.
+ * @return false to stop reading.
+ */
+typedef bool (*event_log_read_cb_t)(void *ctx, const event_log_record_t *rec);
+
+/**
+ * @brief Mount the log partition, recover the write position and start the flush task.
+ * Without the partition the log keeps only the RAM ring.
+ */
+void event_log_init(void);
+
+/**
+ * @brief Append a record. Never blocks on flash; drops the record if the ring is full.
+ */
+void event_log_add(event_log_type_t type, uint16_t cube_id, int32_t weight_g, uint8_t state);
+
+/**
+ * @brief Read up to max records with seq >= from_seq, flash first, then records not yet flushed.
+ * @return number of records passed to cb.
+ */
+size_t event_log_read(uint32_t from_seq, size_t max, event_log_read_cb_t cb, void *ctx);
+
+const char *event_log_type_name(uint8_t type);
+
+/**
+ * @brief Records dropped because the RAM ring was full.
+ */
+uint32_t event_log_dropped(void);
+
+#endif /* MAIN_EVENT_LOG_H_ */
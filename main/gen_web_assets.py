@@ -0,0 +1,136 @@
+#!/usr/bin/env python3
+#
+# gen_web_assets.py
+#
+#  Created on: Oct 17, 2026
+#      Author: majorBien
+#
+# Build step for the web HMI: gzips every file of webpage/ into the build
+# directory (embedded instead of the raw files) and writes the asset
+# manifest web_assets.c/.h: URL path, MIME type, embedded data and a
+# strong ETag derived from the compressed content, sorted by path for
+# binary search. New pages only need to be dropped into webpage/.
+
+import argparse
+import gzip
+import hashlib
+import os
+import re
+
+
+def compress(data):
+    # mtime=0 keeps the output, and therefore the ETag, reproducible
+    return gzip.compress(data, compresslevel=9, mtime=0)
+
+
+MIME_TYPES = {
+    '.html': 'text/html',
+    '.js': 'application/javascript',
+    '.css': 'text/css',
+    '.ico': 'image/x-icon',
+    '.png': 'image/png',
+    '.svg': 'image/svg+xml',
+    '.json': 'application/json',
+}
+
+
+def symbol_name(filename):
+    # Same mangling as ESP-IDF target_add_binary_data()
+    return re.sub(r'[^A-Za-z0-9]', '_', filename)
+
+
+def write_if_changed(path, data):
+    if os.path.exists(path):
+        with open(path, 'rb') as f:
+            if f.read() == data:
+                return
+    with open(path, 'wb') as f:
+        f.write(data)
+
+
+HEADER = """/*
+ * web_assets.h
+ *
+ * Generated by gen_web_assets.py, do not edit.
+ */
+
+#ifndef WEB_ASSETS_H_
+#define WEB_ASSETS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+    const char    *path;        // URL path, sorted ascending
+    const char    *type;        // MIME type of the uncompressed content
+    const char    *etag;        // quoted strong ETag
+    const uint8_t *start;       // gzipped content
+    const uint8_t *end;
+} web_asset_t;
+
+extern const web_asset_t web_assets[];
+extern const size_t web_assets_count;
+
+#endif /* WEB_ASSETS_H_ */
+"""
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Compress web HMI assets')
+    parser.add_argument('--out-dir', required=True, help='directory for the .gz files')
+    parser.add_argument('--manifest', required=True, help='path of the generated manifest, without extension')
+    parser.add_argument('--index', default='index.html', help='asset also served as /')
+    parser.add_argument('files', nargs='+', help='asset files')
+    args = parser.parse_args()
+
+    os.makedirs(args.out_dir, exist_ok=True)
+
+    symbols = []
+    entries = []
+    for path in args.files:
+        name = os.path.basename(path)
+        with open(path, 'rb') as f:
+            raw = f.read()
+        gz = compress(raw)
+        write_if_changed(os.path.join(args.out_dir, name + '.gz'), gz)
+
+        ext = os.path.splitext(name)[1].lower()
+        entry = {
+            'type': MIME_TYPES.get(ext, 'application/octet-stream'),
+            'etag': hashlib.sha256(gz).hexdigest()[:16],
+            'sym': symbol_name(name + '.gz'),
+            'sizes': '%d -> %d bytes' % (len(raw), len(gz)),
+        }
+        symbols.append(entry['sym'])
+        entries.append(dict(entry, path='/' + name))
+        if name == args.index:
+            entries.append(dict(entry, path='/'))
+
+    entries.sort(key=lambda e: e['path'].encode())
+
+    lines = [
+        '/*',
+        ' * web_assets.c',
+        ' *',
+        ' * Generated by gen_web_assets.py, do not edit.',
+        ' */',
+        '',
+        '#include "web_assets.h"',
+        '',
+    ]
+    for sym in symbols:
+        lines.append('extern const uint8_t %s_start[] asm("_binary_%s_start");' % (sym, sym))
+        lines.append('extern const uint8_t %s_end[]   asm("_binary_%s_end");' % (sym, sym))
+    lines += ['', 'const web_asset_t web_assets[] = {']
+    for e in entries:
+        lines.append('    { "%s", "%s", "\\"%s\\"", %s_start, %s_end },    // %s'
+                     % (e['path'], e['type'], e['etag'], e['sym'], e['sym'], e['sizes']))
+    lines += ['};', '',
+              'const size_t web_assets_count = sizeof(web_assets) / sizeof(web_assets[0]);', '']
+
+    write_if_changed(args.manifest + '.c', '\n'.join(lines).encode())
+    write_if_changed(args.manifest + '.h', HEADER.encode())
+
+
+if __name__ == '__main__':
+    main()
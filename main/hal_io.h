@@ -0,0 +1,70 @@
+/*
+ * hal_io.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ *
+ * Digital I/O of the line as channel bit masks. All inputs are read with
+ * one register read and outputs are changed through the set/clear
+ * registers, so callers never touch pin numbers or the GPIO driver.
+ * The binding is chosen at build time: hal_io_esp32.c on the hardware,
+ * hal_io_host.c (in-memory pins) on the linux target.
+ */
+
+#ifndef MAIN_HAL_IO_H_
+#define MAIN_HAL_IO_H_
+
+#include <stdint.h>
+#include "sdkconfig.h"
+
+// Input channel indices (bit positions in input, edge and debounce masks)
+#define IO_CH_SENSOR_1        0   // Czujnik transporter 1
+#define IO_CH_SENSOR_2        1   // Czujnik transporter 2
+#define IO_CH_SENSOR_3        2   // Czujnik transporter 3
+#define IO_CH_WRAP_DONE       3   // Owijarka koniec
+#define IO_CH_COUNT           4
+
+// Output channel indices (bit positions in output masks)
+#define IO_OUT_EJECTOR        0   // Siłownik zrzutu
+#define IO_OUT_WRAPPER        1   // Start owijarki
+#define IO_OUT_LED_GREEN      2   // Wieża zielona
+#define IO_OUT_LED_RED        3   // Wieża czerwona
+#define IO_OUT_LED_YELLOW     4   // Wieża żółta
+#define IO_OUT_COUNT          5
+
+#define IO_OUT_BIT(ch)        (1u << (ch))
+
+/**
+ * @brief Called from interrupt context on any edge of an input; arg is the IO_CH_* index.
+ */
+typedef void (*hal_io_edge_isr_t)(void *arg);
+
+/**
+ * @brief Configure the pins, all outputs off, and attach isr to every input.
+ */
+void hal_io_init(hal_io_edge_isr_t isr);
+
+/**
+ * @brief Levels of all inputs as an IO_CH_* bit mask. Safe to call from the ISR.
+ */
+uint32_t hal_io_read_inputs(void);
+
+/**
+ * @brief Switch outputs on and off by IO_OUT_* bit mask; clear is applied before set.
+ * Each mask is a single register write, so outputs in one mask change together.
+ */
+void hal_io_write_outputs(uint32_t set_mask, uint32_t clear_mask);
+
+/**
+ * @brief Current output state as an IO_OUT_* bit mask.
+ */
+uint32_t hal_io_read_outputs(void);
+
+#if CONFIG_IDF_TARGET_LINUX
+/**
+ * @brief Host stub only: drive the simulated inputs and run the ISR for each changed channel.
+ */
+void hal_io_host_set_inputs(uint32_t levels);
+#endif
+
+#endif /* MAIN_HAL_IO_H_ */
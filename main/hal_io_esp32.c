@@ -0,0 +1,129 @@
+/*
+ * hal_io_esp32.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ *
+ * ESP32 binding of hal_io: pins are configured through the GPIO driver,
+ * the hot path uses the GPIO_IN and GPIO_OUT_W1TS/W1TC registers directly.
+ */
+
+#include "hal_io.h"
+#include "driver/gpio.h"
+#include "soc/gpio_struct.h"
+#include "esp_attr.h"
+#include "esp_err.h"
+
+// GPIO pin assignment
+#define IO_INPUT_SENSOR_1     2
+#define IO_INPUT_SENSOR_2     3
+#define IO_INPUT_SENSOR_3     4
+#define IO_INPUT_WRAP_DONE    5
+
+#define IO_OUTPUT_EJECTOR     12
+#define IO_OUTPUT_WRAPPER     13
+#define IO_OUTPUT_LED_GREEN   14
+#define IO_OUTPUT_LED_RED     15
+#define IO_OUTPUT_LED_YELLOW  16
+
+// Batched access covers the GPIO_IN / GPIO_OUT register of pins 0..31 only
+_Static_assert(IO_INPUT_WRAP_DONE < 32 && IO_OUTPUT_LED_YELLOW < 32, "I/O pins must be below GPIO32");
+
+// Read from the IRAM edge ISR, so kept in DRAM
+static DRAM_ATTR const uint8_t input_pins[IO_CH_COUNT] = {
+    [IO_CH_SENSOR_1]  = IO_INPUT_SENSOR_1,
+    [IO_CH_SENSOR_2]  = IO_INPUT_SENSOR_2,
+    [IO_CH_SENSOR_3]  = IO_INPUT_SENSOR_3,
+    [IO_CH_WRAP_DONE] = IO_INPUT_WRAP_DONE,
+};
+
+static const uint8_t output_pins[IO_OUT_COUNT] = {
+    [IO_OUT_EJECTOR]    = IO_OUTPUT_EJECTOR,
+    [IO_OUT_WRAPPER]    = IO_OUTPUT_WRAPPER,
+    [IO_OUT_LED_GREEN]  = IO_OUTPUT_LED_GREEN,
+    [IO_OUT_LED_RED]    = IO_OUTPUT_LED_RED,
+    [IO_OUT_LED_YELLOW] = IO_OUTPUT_LED_YELLOW,
+};
+
+static uint32_t hal_io_output_reg_mask(uint32_t mask)
+{
+    uint32_t reg = 0;
+
+    for (int ch = 0; ch < IO_OUT_COUNT; ch++) {
+        if (mask & IO_OUT_BIT(ch)) {
+            reg |= 1u << output_pins[ch];
+        }
+    }
+    return reg;
+}
+
+void hal_io_init(hal_io_edge_isr_t isr)
+{
+    uint64_t in_mask = 0;
+    uint64_t out_mask = 0;
+
+    for (int ch = 0; ch < IO_CH_COUNT; ch++) {
+        in_mask |= 1ULL << input_pins[ch];
+    }
+    for (int ch = 0; ch < IO_OUT_COUNT; ch++) {
+        out_mask |= 1ULL << output_pins[ch];
+    }
+
+    gpio_config_t input_conf = {
+        .intr_type = GPIO_INTR_ANYEDGE,
+        .mode = GPIO_MODE_INPUT,
+        .pin_bit_mask = in_mask,
+        .pull_down_en = 0,
+        .pull_up_en = 1
+    };
+    gpio_config(&input_conf);
+
+    // Outputs start off, before the pins are switched to output mode
+    GPIO.out_w1tc = (uint32_t)out_mask;
+    gpio_config_t output_conf = {
+        .intr_type = GPIO_INTR_DISABLE,
+        .mode = GPIO_MODE_OUTPUT,
+        .pin_bit_mask = out_mask,
+        .pull_down_en = 0,
+        .pull_up_en = 0
+    };
+    gpio_config(&output_conf);
+
+    ESP_ERROR_CHECK(gpio_install_isr_service(ESP_INTR_FLAG_IRAM));
+    for (int ch = 0; ch < IO_CH_COUNT; ch++) {
+        ESP_ERROR_CHECK(gpio_isr_handler_add(input_pins[ch], isr, (void *)(uintptr_t)ch));
+    }
+}
+
+uint32_t IRAM_ATTR hal_io_read_inputs(void)
+{
+    uint32_t in = GPIO.in;
+    uint32_t levels = 0;
+
+    for (int ch = 0; ch < IO_CH_COUNT; ch++) {
+        levels |= ((in >> input_pins[ch]) & 1u) << ch;
+    }
+    return levels;
+}
+
+void hal_io_write_outputs(uint32_t set_mask, uint32_t clear_mask)
+{
+    // W1TS/W1TC only touch the given pins, no read-modify-write of GPIO_OUT
+    if (clear_mask) {
+        GPIO.out_w1tc = hal_io_output_reg_mask(clear_mask);
+    }
+    if (set_mask) {
+        GPIO.out_w1ts = hal_io_output_reg_mask(set_mask);
+    }
+}
+
+uint32_t hal_io_read_outputs(void)
+{
+    uint32_t out = GPIO.out;
+    uint32_t mask = 0;
+
+    for (int ch = 0; ch < IO_OUT_COUNT; ch++) {
+        mask |= ((out >> output_pins[ch]) & 1u) << ch;
+    }
+    return mask;
+}
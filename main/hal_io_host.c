@@ -0,0 +1,50 @@
+/*
+ * hal_io_host.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ *
+ * Host (linux target) binding of hal_io: inputs and outputs are plain
+ * variables. A simulation drives the inputs with hal_io_host_set_inputs()
+ * and observes the actuators with hal_io_read_outputs().
+ */
+
+#include "hal_io.h"
+#include <stddef.h>
+
+static volatile uint32_t input_levels = 0;
+static volatile uint32_t output_levels = 0;
+static hal_io_edge_isr_t edge_isr = NULL;
+
+void hal_io_init(hal_io_edge_isr_t isr)
+{
+    edge_isr = isr;
+    output_levels = 0;
+}
+
+uint32_t hal_io_read_inputs(void)
+{
+    return input_levels;
+}
+
+void hal_io_write_outputs(uint32_t set_mask, uint32_t clear_mask)
+{
+    output_levels = (output_levels & ~clear_mask) | set_mask;
+}
+
+uint32_t hal_io_read_outputs(void)
+{
+    return output_levels;
+}
+
+void hal_io_host_set_inputs(uint32_t levels)
+{
+    uint32_t changed = (input_levels ^ levels) & ((1u << IO_CH_COUNT) - 1);
+
+    input_levels = levels;
+    for (int ch = 0; ch < IO_CH_COUNT; ch++) {
+        if ((changed & (1u << ch)) && edge_isr != NULL) {
+            edge_isr((void *)(uintptr_t)ch);
+        }
+    }
+}
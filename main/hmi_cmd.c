@@ -0,0 +1,73 @@
+/*
+ * hmi_cmd.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ */
+
+#include "hmi_cmd.h"
+#include <string.h>
+
+static const hmi_cmd_desc_t hmi_cmds[] = {
+    { "START",            HMI_CMD_START,            HMI_ARG_NONE,  0, 0 },
+    { "STOP",             HMI_CMD_STOP,             HMI_ARG_NONE,  0, 0 },
+    { "SET_LAYERS",       HMI_CMD_SET_LAYERS,       HMI_ARG_UINT,  HMI_LAYERS_MIN, HMI_LAYERS_MAX },
+    { "set_max_layers",   HMI_CMD_SET_LAYERS,       HMI_ARG_UINT,  HMI_LAYERS_MIN, HMI_LAYERS_MAX },  // older panels
+    { "SERVICE_MODE",     HMI_CMD_SERVICE_MODE,     HMI_ARG_BOOL,  0, 1 },
+    { "RESET_ERRORS",     HMI_CMD_RESET_ERRORS,     HMI_ARG_NONE,  0, 0 },
+    { "CALIBRATE_WEIGHT", HMI_CMD_CALIBRATE_WEIGHT, HMI_ARG_GRAMS, 0, HMI_REF_G_MAX },
+};
+
+const hmi_cmd_desc_t *hmi_cmd_find(const char *name)
+{
+    for (size_t i = 0; i < sizeof(hmi_cmds) / sizeof(hmi_cmds[0]); i++) {
+        if (strcmp(hmi_cmds[i].name, name) == 0) {
+            return &hmi_cmds[i];
+        }
+    }
+    return NULL;
+}
+
+bool hmi_cmd_build(const hmi_cmd_desc_t *desc, int32_t value, hmi_cmd_t *out)
+{
+    memset(out, 0, sizeof(*out));
+    out->id = (uint8_t)desc->id;
+
+    switch (desc->arg) {
+        case HMI_ARG_UINT:
+            if (value < desc->min || value > desc->max) {
+                return false;
+            }
+            out->layers = (uint8_t)value;
+            break;
+
+        case HMI_ARG_BOOL:
+            out->enable = value != 0;
+            break;
+
+        case HMI_ARG_GRAMS:
+            if (value < desc->min || value > desc->max) {
+                return false;
+            }
+            out->ref_g = value;
+            break;
+
+        default:
+            break;
+    }
+    return true;
+}
+
+int32_t hmi_cmd_arg(const hmi_cmd_t *cmd)
+{
+    switch (cmd->id) {
+        case HMI_CMD_SET_LAYERS:
+            return cmd->layers;
+        case HMI_CMD_SERVICE_MODE:
+            return cmd->enable;
+        case HMI_CMD_CALIBRATE_WEIGHT:
+            return cmd->ref_g;
+        default:
+            return 0;
+    }
+}
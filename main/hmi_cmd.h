@@ -0,0 +1,76 @@
+/*
+ * hmi_cmd.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ *
+ * Operator commands from the web panel, parsed once by the HTTP server
+ * into a small tagged union and passed by value to the logic task.
+ */
+
+#ifndef MAIN_HMI_CMD_H_
+#define MAIN_HMI_CMD_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define HMI_LAYERS_MIN  1
+#define HMI_LAYERS_MAX  20
+#define HMI_REF_G_MAX   100000      // reference mass limit, scale full range
+
+typedef enum {
+    HMI_CMD_START = 0,
+    HMI_CMD_STOP,
+    HMI_CMD_SET_LAYERS,
+    HMI_CMD_SERVICE_MODE,
+    HMI_CMD_RESET_ERRORS,
+    HMI_CMD_CALIBRATE_WEIGHT,
+    HMI_CMD_COUNT
+} hmi_cmd_id_t;
+
+typedef enum {
+    HMI_ARG_NONE = 0,
+    HMI_ARG_UINT,
+    HMI_ARG_BOOL,
+    HMI_ARG_GRAMS
+} hmi_arg_kind_t;
+
+// 8 bytes, copied by value into every logic event
+typedef struct {
+    uint8_t id;                 // hmi_cmd_id_t
+    union {
+        uint8_t layers;         // HMI_CMD_SET_LAYERS
+        bool    enable;         // HMI_CMD_SERVICE_MODE
+        int32_t ref_g;          // HMI_CMD_CALIBRATE_WEIGHT, 0 ends the calibration
+    };
+} hmi_cmd_t;
+
+_Static_assert(sizeof(hmi_cmd_t) == 8, "hmi_cmd_t grew, check the logic event size");
+
+typedef struct {
+    const char     *name;       // "type" field sent by the panel
+    hmi_cmd_id_t    id;
+    hmi_arg_kind_t  arg;        // expected "data" field
+    int32_t         min;        // range for HMI_ARG_UINT and HMI_ARG_GRAMS
+    int32_t         max;
+} hmi_cmd_desc_t;
+
+/**
+ * @brief Look up a command by its panel name.
+ * @return descriptor, or NULL for an unknown command.
+ */
+const hmi_cmd_desc_t *hmi_cmd_find(const char *name);
+
+/**
+ * @brief Fill a command from its descriptor and argument.
+ * @param value numeric argument (HMI_ARG_UINT, HMI_ARG_GRAMS) or 0/1 (HMI_ARG_BOOL), ignored otherwise.
+ * @return false if the argument is out of range.
+ */
+bool hmi_cmd_build(const hmi_cmd_desc_t *desc, int32_t value, hmi_cmd_t *out);
+
+/**
+ * @brief Argument of a command as one number, for logging: layers, 0/1 or grams; 0 without argument.
+ */
+int32_t hmi_cmd_arg(const hmi_cmd_t *cmd);
+
+#endif /* MAIN_HMI_CMD_H_ */
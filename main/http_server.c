@@ -12,11 +12,18 @@
 #include "http_server.h"
 #include "tasks_common.h"
 #include "wifi_app.h"
+#include "line_status.h"
+#include "json_writer.h"
+#include "hmi_cmd.h"
+#include "logic.h"
+#include "web_assets.h"
+#include "event_log.h"
+#include "diag.h"
+#include "trace.h"
 #include "cJSON.h"
 #include "stdio.h"
 #include "string.h"
 
-QueueHandle_t hmi_data_queue;
 
 // Tag used for ESP serial console messages
 static const char TAG[] = "http_server";
@@ -30,21 +37,34 @@ static TaskHandle_t task_http_server_monitor = NULL;
 // Queue handle used to manipulate the main queue of events
 static QueueHandle_t http_server_monitor_queue_handle;
 
-// Embedded files: JQuery, index.html, app.css, app.js and favicon.ico files
-extern const uint8_t jquery_3_3_1_min_js_start[]    asm("_binary_jquery_3_3_1_min_js_start");
-extern const uint8_t jquery_3_3_1_min_js_end[]      asm("_binary_jquery_3_3_1_min_js_end");
-extern const uint8_t index_html_start[]              asm("_binary_index_html_start");
-extern const uint8_t index_html_end[]                asm("_binary_index_html_end");
-extern const uint8_t app_css_start[]                 asm("_binary_app_css_start");
-extern const uint8_t app_css_end[]                   asm("_binary_app_css_end");
-extern const uint8_t app_js_start[]                  asm("_binary_app_js_start");
-extern const uint8_t app_js_end[]                    asm("_binary_app_js_end");
-extern const uint8_t favicon_ico_start[]             asm("_binary_favicon_ico_start");
-extern const uint8_t favicon_ico_end[]               asm("_binary_favicon_ico_end");
+// WebSocket status push task handle
+static TaskHandle_t task_http_server_ws_push = NULL;
+
+// Status last pushed to WebSocket clients, owned by the httpd task
+static line_status_t ws_last_status;
+
+// HTTP server settings
+#define HTTP_SERVER_MAX_OPEN_SOCKETS		5		// covers WIFI_AP_MAX_CONNECTIONS, least recently used is purged beyond
+#define HTTP_SERVER_INTERNAL_SOCKETS		2		// httpd listen and control sockets
+#define HTTP_SERVER_OTHER_SOCKETS			2		// robot link and inverter Modbus TCP in the TCP client task
+#define HTTP_SERVER_WS_PUSH_INTERVAL_MS		50		// changes within this window are sent as one delta
+#define HTTP_SERVER_WS_RX_MAX				128
+#define HTTP_SERVER_ASSET_PATH_MAX			64
+#define HTTP_SERVER_ETAG_HDR_MAX			64		// If-None-Match with a few of our ETags
+#define HTTP_SERVER_STATUS_JSON_MAX			384		// full status object is about 250 bytes
+#define HTTP_SERVER_EVENTS_CHUNK			512		// /api/events is streamed in chunks of this size
+#define HTTP_SERVER_EVENTS_DEFAULT			500		// records per request unless ?count= is given
+#define HTTP_SERVER_EVENTS_MAX				5000
+
+_Static_assert(HTTP_SERVER_MAX_OPEN_SOCKETS + HTTP_SERVER_INTERNAL_SOCKETS + HTTP_SERVER_OTHER_SOCKETS
+			   <= CONFIG_LWIP_MAX_SOCKETS, "HTTP clients and the TCP links exceed CONFIG_LWIP_MAX_SOCKETS");
 
 // Forward declarations for URI handlers
 static esp_err_t http_server_hmi_handler(httpd_req_t *req);
 static esp_err_t http_server_status_handler(httpd_req_t *req);
+static esp_err_t http_server_events_handler(httpd_req_t *req);
+static esp_err_t http_server_diag_handler(httpd_req_t *req);
+static esp_err_t http_server_trace_handler(httpd_req_t *req);
 
 /**
  * HTTP server monitor task used to track events of the HTTP server
@@ -80,78 +100,242 @@ static void http_server_monitor(void *parameter)
 }
 
 /**
- * Jquery get handler is requested when accessing the web page.
- * @param req HTTP request for which the uri needs to be handled.
- * @return ESP_OK
+ * Maps the weigh verdict to the text shown on the panel.
  */
-static esp_err_t http_server_jquery_handler(httpd_req_t *req)
+static const char *http_server_weight_status_str(uint8_t weight_status)
 {
-    ESP_LOGI(TAG, "Jquery requested");
+    switch (weight_status)
+    {
+        case LINE_WEIGHT_OK:
+            return "OK";
+        case LINE_WEIGHT_REJECT:
+            return "ODRZUT";
+        case LINE_WEIGHT_UNSTABLE:
+            return "NIESTABILNA";
+        default:
+            return "--";
+    }
+}
 
-    httpd_resp_set_type(req, "application/javascript");
-    httpd_resp_send(req, (const char *)jquery_3_3_1_min_js_start, jquery_3_3_1_min_js_end - jquery_3_3_1_min_js_start);
+/**
+ * Writes a JSON object holding the fields of cur that differ from prev.
+ * @param buf output buffer, HTTP_SERVER_STATUS_JSON_MAX bytes is always enough.
+ * @param prev previous status, NULL to emit every field.
+ * @param cur current status.
+ * @return length of the JSON text, 0 if nothing changed.
+ */
+static size_t http_server_status_json(char *buf, size_t cap, const line_status_t *prev, const line_status_t *cur)
+{
+    json_writer_t w;
+    uint8_t fields = 0;
+
+    json_writer_init(&w, buf, cap);
+    json_writer_object_begin(&w, NULL);
+
+#define DELTA_CHANGED(field) ((prev == NULL || prev->field != cur->field) && ++fields)
+    if (DELTA_CHANGED(weight_g))
+        json_writer_fixed(&w, "weight", cur->weight_g / 10, 2);
+    if (DELTA_CHANGED(weight_status))
+        json_writer_str(&w, "weightStatus", http_server_weight_status_str(cur->weight_status));
+    if (DELTA_CHANGED(sensor1))
+        json_writer_bool(&w, "sensor1", cur->sensor1);
+    if (DELTA_CHANGED(sensor2))
+        json_writer_bool(&w, "sensor2", cur->sensor2);
+    if (DELTA_CHANGED(sensor3))
+        json_writer_bool(&w, "sensor3", cur->sensor3);
+    if (DELTA_CHANGED(wrap_done))
+        json_writer_bool(&w, "wrap_done", cur->wrap_done);
+    if (DELTA_CHANGED(robot))
+        json_writer_bool(&w, "robot", cur->robot);
+    if (DELTA_CHANGED(inverter))
+        json_writer_bool(&w, "inverter", cur->inverter);
+    if (DELTA_CHANGED(wrap_progress))
+        json_writer_uint(&w, "wrapProgress", cur->wrap_progress);
+    if (DELTA_CHANGED(state))
+        json_writer_uint(&w, "state", cur->state);
+    if (DELTA_CHANGED(layers))
+        json_writer_uint(&w, "layers", cur->layers);
+    if (DELTA_CHANGED(max_layers))
+        json_writer_uint(&w, "maxLayers", cur->max_layers);
+    if (DELTA_CHANGED(cubes))
+        json_writer_uint(&w, "cubes", cur->cubes);
+#undef DELTA_CHANGED
+
+    json_writer_object_end(&w);
+    int len = json_writer_finish(&w);
+
+    return (fields > 0 && len > 0) ? (size_t)len : 0;
+}
 
-    return ESP_OK;
+/**
+ * Sends the status change since the last push to every connected WebSocket client.
+ * Runs in the httpd task, which is the only user of the static state below.
+ * @param arg unused.
+ */
+static void http_server_ws_push_work(void *arg)
+{
+    static char json[HTTP_SERVER_STATUS_JSON_MAX];
+    line_status_t cur;
+    int client_fds[HTTP_SERVER_MAX_OPEN_SOCKETS];
+    size_t clients = HTTP_SERVER_MAX_OPEN_SOCKETS;
+
+    line_status_get(&cur);
+    size_t len = http_server_status_json(json, sizeof(json), &ws_last_status, &cur);
+    ws_last_status = cur;
+
+    if (len == 0 || http_server_handle == NULL ||
+        httpd_get_client_list(http_server_handle, &clients, client_fds) != ESP_OK)
+    {
+        return;
+    }
+
+    httpd_ws_frame_t frame = {
+            .type = HTTPD_WS_TYPE_TEXT,
+            .payload = (uint8_t *)json,
+            .len = len
+    };
+
+    for (size_t i = 0; i < clients; i++)
+    {
+        if (httpd_ws_get_fd_info(http_server_handle, client_fds[i]) == HTTPD_WS_CLIENT_WEBSOCKET)
+        {
+            httpd_ws_send_frame_async(http_server_handle, client_fds[i], &frame);
+        }
+    }
 }
 
 /**
- * Sends the index.html page.
- * @param req HTTP request for which the uri needs to be handled.
- * @return ESP_OK
+ * Wakes the push task, registered as the line_status listener.
+ */
+static void http_server_ws_notify(void)
+{
+    if (task_http_server_ws_push != NULL)
+    {
+        xTaskNotifyGive(task_http_server_ws_push);
+    }
+}
+
+/**
+ * Schedules a status push to WebSocket clients whenever the line status changes.
+ * @param parameter parameter which can be passed to the task.
  */
-static esp_err_t http_server_index_html_handler(httpd_req_t *req)
+static void http_server_ws_push_task(void *parameter)
 {
-    ESP_LOGI(TAG, "index.html requested");
+    for (;;)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
 
-    httpd_resp_set_type(req, "text/html");
-    httpd_resp_send(req, (const char *)index_html_start, index_html_end - index_html_start);
+        httpd_queue_work(http_server_handle, http_server_ws_push_work, NULL);
 
-    return ESP_OK;
+        // Coalesce bursts of changes into one frame
+        vTaskDelay(pdMS_TO_TICKS(HTTP_SERVER_WS_PUSH_INTERVAL_MS));
+    }
 }
 
 /**
- * app.css get handler is requested when accessing the web page.
+ * WebSocket handler: sends the full status after the handshake, then only drains client frames.
  * @param req HTTP request for which the uri needs to be handled.
- * @return ESP_OK
+ * @return ESP_OK on success.
  */
-static esp_err_t http_server_app_css_handler(httpd_req_t *req)
+static esp_err_t http_server_ws_handler(httpd_req_t *req)
 {
-    ESP_LOGI(TAG, "app.css requested");
+    if (req->method == HTTP_GET)
+    {
+        char json[HTTP_SERVER_STATUS_JSON_MAX];
+        line_status_t cur;
+        line_status_get(&cur);
+
+        httpd_ws_frame_t frame = {
+                .type = HTTPD_WS_TYPE_TEXT,
+                .payload = (uint8_t *)json,
+                .len = http_server_status_json(json, sizeof(json), NULL, &cur)
+        };
 
-    httpd_resp_set_type(req, "text/css");
-    httpd_resp_send(req, (const char *)app_css_start, app_css_end - app_css_start);
+        return httpd_ws_send_frame(req, &frame);
+    }
 
-    return ESP_OK;
+    // Client frames are not used (commands go through /api/hmi), read and drop them
+    uint8_t buf[HTTP_SERVER_WS_RX_MAX];
+    httpd_ws_frame_t frame = { 0 };
+    esp_err_t ret = httpd_ws_recv_frame(req, &frame, 0);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+    if (frame.len > sizeof(buf))
+    {
+        return ESP_FAIL;
+    }
+    if (frame.len > 0)
+    {
+        frame.payload = buf;
+        ret = httpd_ws_recv_frame(req, &frame, frame.len);
+    }
+
+    return ret;
+}
+
+static int http_server_asset_cmp(const void *key, const void *elem)
+{
+    const char *path = (const char *)key;
+    const web_asset_t *asset = (const web_asset_t *)elem;
+
+    return strcmp(path, asset->path);
 }
 
 /**
- * app.js get handler is requested when accessing the web page.
- * @param req HTTP request for which the uri needs to be handled.
- * @return ESP_OK
+ * Looks an URL path up in the generated asset manifest (sorted by path).
+ * @param uri request URI, a query string is ignored.
+ * @return asset or NULL if not found.
  */
-static esp_err_t http_server_app_js_handler(httpd_req_t *req)
+static const web_asset_t *http_server_find_asset(const char *uri)
 {
-    ESP_LOGI(TAG, "app.js requested");
+    char path[HTTP_SERVER_ASSET_PATH_MAX];
+    size_t len = strcspn(uri, "?#");
 
-    httpd_resp_set_type(req, "application/javascript");
-    httpd_resp_send(req, (const char *)app_js_start, app_js_end - app_js_start);
+    if (len >= sizeof(path))
+    {
+        return NULL;
+    }
+    memcpy(path, uri, len);
+    path[len] = '\0';
 
-    return ESP_OK;
+    return bsearch(path, web_assets, web_assets_count, sizeof(web_assets[0]), http_server_asset_cmp);
 }
 
 /**
- * Sends the .ico (icon) file when accessing the web page.
+ * Catch-all GET handler serving the embedded web HMI files. Sends the gzipped
+ * asset, or 304 when the client already holds this version.
  * @param req HTTP request for which the uri needs to be handled.
- * @return ESP_OK
+ * @return ESP_OK on success.
  */
-static esp_err_t http_server_favicon_ico_handler(httpd_req_t *req)
+static esp_err_t http_server_asset_handler(httpd_req_t *req)
 {
-    ESP_LOGI(TAG, "favicon.ico requested");
+    char if_none_match[HTTP_SERVER_ETAG_HDR_MAX];
+    const web_asset_t *asset = http_server_find_asset(req->uri);
 
-    httpd_resp_set_type(req, "image/x-icon");
-    httpd_resp_send(req, (const char *)favicon_ico_start, favicon_ico_end - favicon_ico_start);
+    if (asset == NULL)
+    {
+        ESP_LOGD(TAG, "%s not found", req->uri);
+        return httpd_resp_send_404(req);
+    }
 
-    return ESP_OK;
+    // Revalidate on every load; a matching ETag costs a header-only reply
+    httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+    httpd_resp_set_hdr(req, "ETag", asset->etag);
+
+    if (httpd_req_get_hdr_value_str(req, "If-None-Match", if_none_match, sizeof(if_none_match)) == ESP_OK &&
+        strstr(if_none_match, asset->etag) != NULL)
+    {
+        ESP_LOGD(TAG, "%s not modified", req->uri);
+        httpd_resp_set_status(req, "304 Not Modified");
+        return httpd_resp_send(req, NULL, 0);
+    }
+
+    ESP_LOGD(TAG, "%s requested", req->uri);
+    httpd_resp_set_type(req, asset->type);
+    httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+    return httpd_resp_send(req, (const char *)asset->start, asset->end - asset->start);
 }
 
 /**
@@ -170,18 +354,18 @@ static httpd_handle_t http_server_configure(void)
         return NULL;
     }
 
-    // Create HMI data queue
-    hmi_data_queue = xQueueCreate(10, sizeof(hmi_data_t));
-    if (!hmi_data_queue) {
-        ESP_LOGE(TAG, "Failed to create hmi_data_queue");
-        return NULL;
-    }
-
     // Create HTTP server monitor task AFTER creating queues
     xTaskCreatePinnedToCore(&http_server_monitor, "http_server_monitor", HTTP_SERVER_MONITOR_STACK_SIZE, 
                             NULL, HTTP_SERVER_MONITOR_PRIORITY, &task_http_server_monitor, 
                             HTTP_SERVER_MONITOR_CORE_ID);
 
+    // Create the WebSocket push task and subscribe it to status changes
+    line_status_get(&ws_last_status);
+    xTaskCreatePinnedToCore(&http_server_ws_push_task, "http_server_ws_push", HTTP_SERVER_WS_PUSH_STACK_SIZE,
+                            NULL, HTTP_SERVER_WS_PUSH_PRIORITY, &task_http_server_ws_push,
+                            HTTP_SERVER_WS_PUSH_CORE_ID);
+    line_status_set_listener(http_server_ws_notify);
+
     // The core that the HTTP server will run on
     config.core_id = HTTP_SERVER_TASK_CORE_ID;
 
@@ -191,8 +375,13 @@ static httpd_handle_t http_server_configure(void)
     // Bump up the stack size (default is 4096)
     config.stack_size = HTTP_SERVER_TASK_STACK_SIZE;
 
-    // Increase uri handlers
-    config.max_uri_handlers = 20;
+    // API routes plus one catch-all for the web files, independent of the number of pages
+    config.max_uri_handlers = 8;
+    config.uri_match_fn = httpd_uri_match_wildcard;
+
+    // One socket per operator tablet; a new client closes the least recently used one instead of being refused
+    config.max_open_sockets = HTTP_SERVER_MAX_OPEN_SOCKETS;
+    config.lru_purge_enable = true;
 
     // Increase the timeout limits
     config.recv_wait_timeout = 10;
@@ -208,51 +397,6 @@ static httpd_handle_t http_server_configure(void)
     {
         ESP_LOGI(TAG, "http_server_configure: Registering URI handlers");
 
-        // register query handler
-        httpd_uri_t jquery_js = {
-                .uri = "/jquery-3.3.1.min.js",
-                .method = HTTP_GET,
-                .handler = http_server_jquery_handler,
-                .user_ctx = NULL
-        };
-        httpd_register_uri_handler(http_server_handle, &jquery_js);
-
-        // register index.html handler
-        httpd_uri_t index_html = {
-                .uri = "/",
-                .method = HTTP_GET,
-                .handler = http_server_index_html_handler,
-                .user_ctx = NULL
-        };
-        httpd_register_uri_handler(http_server_handle, &index_html);
-
-        // register app.css handler
-        httpd_uri_t app_css = {
-                .uri = "/app.css",
-                .method = HTTP_GET,
-                .handler = http_server_app_css_handler,
-                .user_ctx = NULL
-        };
-        httpd_register_uri_handler(http_server_handle, &app_css);
-
-        // register app.js handler
-        httpd_uri_t app_js = {
-                .uri = "/app.js",
-                .method = HTTP_GET,
-                .handler = http_server_app_js_handler,
-                .user_ctx = NULL
-        };
-        httpd_register_uri_handler(http_server_handle, &app_js);
-
-        // register favicon.ico handler
-        httpd_uri_t favicon_ico = {
-                .uri = "/favicon.ico",
-                .method = HTTP_GET,
-                .handler = http_server_favicon_ico_handler,
-                .user_ctx = NULL
-        };
-        httpd_register_uri_handler(http_server_handle, &favicon_ico);
-        
         // Register HMI API handler
         httpd_uri_t hmi_uri = {
             .uri      = "/api/hmi",
@@ -271,6 +415,52 @@ static httpd_handle_t http_server_configure(void)
         };
         httpd_register_uri_handler(http_server_handle, &status_uri);
 
+        // Register event log download handler
+        httpd_uri_t events_uri = {
+            .uri      = "/api/events",
+            .method   = HTTP_GET,
+            .handler  = http_server_events_handler,
+            .user_ctx = NULL
+        };
+        httpd_register_uri_handler(http_server_handle, &events_uri);
+
+        // Register runtime diagnostics handler
+        httpd_uri_t diag_uri = {
+            .uri      = "/api/diag",
+            .method   = HTTP_GET,
+            .handler  = http_server_diag_handler,
+            .user_ctx = NULL
+        };
+        httpd_register_uri_handler(http_server_handle, &diag_uri);
+
+        // Register latency trace handler
+        httpd_uri_t trace_uri = {
+            .uri      = "/api/trace",
+            .method   = HTTP_GET,
+            .handler  = http_server_trace_handler,
+            .user_ctx = NULL
+        };
+        httpd_register_uri_handler(http_server_handle, &trace_uri);
+
+        // Register WebSocket status push handler
+        httpd_uri_t ws_uri = {
+            .uri          = "/ws",
+            .method       = HTTP_GET,
+            .handler      = http_server_ws_handler,
+            .user_ctx     = NULL,
+            .is_websocket = true
+        };
+        httpd_register_uri_handler(http_server_handle, &ws_uri);
+
+        // Register the catch-all web HMI file handler last so the API routes match first
+        httpd_uri_t asset_uri = {
+            .uri      = "/*",
+            .method   = HTTP_GET,
+            .handler  = http_server_asset_handler,
+            .user_ctx = NULL
+        };
+        httpd_register_uri_handler(http_server_handle, &asset_uri);
+
         return http_server_handle;
     }
 
@@ -293,6 +483,13 @@ void http_server_stop(void)
         ESP_LOGI(TAG, "http_server_stop: stopping HTTP server");
         http_server_handle = NULL;
     }
+    if (task_http_server_ws_push)
+    {
+        line_status_set_listener(NULL);
+        vTaskDelete(task_http_server_ws_push);
+        ESP_LOGI(TAG, "http_server_stop: stopping WebSocket push task");
+        task_http_server_ws_push = NULL;
+    }
     if (task_http_server_monitor)
     {
         vTaskDelete(task_http_server_monitor);
@@ -303,10 +500,6 @@ void http_server_stop(void)
         vQueueDelete(http_server_monitor_queue_handle);
         http_server_monitor_queue_handle = NULL;
     }
-    if (hmi_data_queue) {
-        vQueueDelete(hmi_data_queue);
-        hmi_data_queue = NULL;
-    }
 }
 
 BaseType_t http_server_monitor_send_message(http_server_message_e msgID)
@@ -342,61 +535,201 @@ static esp_err_t http_server_hmi_handler(httpd_req_t *req)
         return ESP_FAIL;
     }
 
-    const cJSON *data = cJSON_GetObjectItemCaseSensitive(root, "data");
-
-    hmi_data_t hmi = {0};
-
-    // Alokuj string na stercie
-    hmi.type = strdup(type->valuestring);
-    if (!hmi.type) {
-        ESP_LOGE(TAG, "Failed to allocate memory for type");
+    const hmi_cmd_desc_t *desc = hmi_cmd_find(type->valuestring);
+    if (desc == NULL) {
+        ESP_LOGW(TAG, "Unknown HMI command '%s'", type->valuestring);
         cJSON_Delete(root);
-        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Internal error");
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Unknown command");
         return ESP_FAIL;
     }
 
-    if (cJSON_IsNumber(data)) {
-        hmi.value = data->valuedouble;
-    } else {
-        hmi.value = 0.0; // lub możesz użyć NAN
+    // Argument must match the command: number, bool, or nothing
+    const cJSON *data = cJSON_GetObjectItemCaseSensitive(root, "data");
+    int32_t value = 0;
+    bool arg_ok = true;
+    switch (desc->arg) {
+        case HMI_ARG_UINT:
+        case HMI_ARG_GRAMS:
+            arg_ok = cJSON_IsNumber(data);
+            value = arg_ok ? data->valueint : 0;
+            break;
+        case HMI_ARG_BOOL:
+            arg_ok = cJSON_IsBool(data);
+            value = cJSON_IsTrue(data);
+            break;
+        default:
+            break;
     }
 
-    // Opcjonalnie: wpisz całe żądanie do cmd (np. do logów)
-    snprintf(hmi.cmd, sizeof(hmi.cmd), "%s", buf);
-
-    // Wrzuć do kolejki
-    if (xQueueSend(hmi_data_queue, &hmi, portMAX_DELAY) != pdTRUE) {
-        ESP_LOGE(TAG, "Failed to enqueue HMI data");
-        free(hmi.type);  // pamiętaj o zwolnieniu alokacji
+    logic_event_t evt = { .type = LOGIC_EVT_HMI };
+    if (!arg_ok || !hmi_cmd_build(desc, value, &evt.hmi)) {
+        ESP_LOGW(TAG, "Invalid argument for HMI command '%s'", desc->name);
         cJSON_Delete(root);
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid 'data'");
+        return ESP_FAIL;
+    }
+    cJSON_Delete(root);
+
+    // "OK" means queued: logic applies it after the events ahead of it, possibly after this returns
+    if (logic_post_event(&evt) != pdTRUE) {
+        ESP_LOGE(TAG, "Logic event queue full, HMI command dropped");
         httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Queue full");
         return ESP_FAIL;
     }
 
-    cJSON_Delete(root);
     httpd_resp_sendstr(req, "OK");
     return ESP_OK;
 }
 
-
+/**
+ * Status handler returns the current line status snapshot.
+ * @param req HTTP request for which the uri needs to be handled.
+ * @return ESP_OK
+ */
 static esp_err_t http_server_status_handler(httpd_req_t *req)
 {
-    cJSON *root = cJSON_CreateObject();
-    cJSON_AddNumberToObject(root, "weight", 12.34);
-    cJSON_AddStringToObject(root, "weightStatus", "OK");
-    cJSON_AddBoolToObject(root, "sensor1", true);
-    cJSON_AddBoolToObject(root, "sensor3", false);
-    cJSON_AddBoolToObject(root, "wrap_done", false);
-    cJSON_AddBoolToObject(root, "robot", true);
-    cJSON_AddBoolToObject(root, "inverter", true);
-    cJSON_AddNumberToObject(root, "wrapProgress", 75);
-
-    const char *json_str = cJSON_PrintUnformatted(root);
+    char json[HTTP_SERVER_STATUS_JSON_MAX];
+    line_status_t cur;
+    line_status_get(&cur);
+
+    size_t len = http_server_status_json(json, sizeof(json), NULL, &cur);
     httpd_resp_set_type(req, "application/json");
-    httpd_resp_sendstr(req, json_str);
-    
-    cJSON_free((void*)json_str);
-    cJSON_Delete(root);
+    httpd_resp_send(req, json, len);
 
     return ESP_OK;
-}
\ No newline at end of file
+}
+
+/**
+ * json_writer flush callback sending one HTTP chunk.
+ */
+static bool http_server_chunk_flush(void *ctx, const char *data, size_t len)
+{
+    return httpd_resp_send_chunk((httpd_req_t *)ctx, data, len) == ESP_OK;
+}
+
+/**
+ * Reads an unsigned query parameter.
+ * @return the value, or def if missing or not a number.
+ */
+static uint32_t http_server_query_uint(const char *query, const char *key, uint32_t def)
+{
+    char val[12];
+    char *end;
+
+    if (query == NULL || httpd_query_key_value(query, key, val, sizeof(val)) != ESP_OK)
+    {
+        return def;
+    }
+    unsigned long v = strtoul(val, &end, 10);
+    return (end == val || *end != '\0') ? def : (uint32_t)v;
+}
+
+static bool http_server_event_to_json(void *ctx, const event_log_record_t *rec)
+{
+    json_writer_t *w = (json_writer_t *)ctx;
+
+    json_writer_object_begin(w, NULL);
+    json_writer_uint(w, "seq", rec->seq);
+    json_writer_uint(w, "t", rec->time_ms);
+    json_writer_str(w, "type", event_log_type_name(rec->type));
+    json_writer_uint(w, "cube", rec->cube_id);
+    json_writer_int(w, "w", rec->weight_g);
+    if (rec->state != EVENT_LOG_STATE_NONE)
+    {
+        json_writer_uint(w, "state", rec->state);
+    }
+    json_writer_object_end(w);
+
+    return !w->overflow;
+}
+
+/**
+ * Event log handler streams records as a JSON array with chunked transfer.
+ * Query: from=<first seq> (default 0), count=<max records>.
+ * @param req HTTP request for which the uri needs to be handled.
+ * @return ESP_OK on success.
+ */
+static esp_err_t http_server_events_handler(httpd_req_t *req)
+{
+    char query[48];
+    const char *q = httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK ? query : NULL;
+    uint32_t from = http_server_query_uint(q, "from", 0);
+    uint32_t count = http_server_query_uint(q, "count", HTTP_SERVER_EVENTS_DEFAULT);
+    if (count > HTTP_SERVER_EVENTS_MAX)
+    {
+        count = HTTP_SERVER_EVENTS_MAX;
+    }
+
+    char buf[HTTP_SERVER_EVENTS_CHUNK];
+    json_writer_t w;
+    json_writer_init(&w, buf, sizeof(buf));
+    json_writer_set_flush(&w, http_server_chunk_flush, req);
+
+    httpd_resp_set_type(req, "application/json");
+    json_writer_array_begin(&w, NULL);
+    event_log_read(from, count, http_server_event_to_json, &w);
+    json_writer_array_end(&w);
+
+    if (json_writer_finish(&w) < 0)
+    {
+        ESP_LOGW(TAG, "Event download aborted");
+        return ESP_FAIL;
+    }
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+/**
+ * Diagnostics handler streams the task, queue, heap and loop-time report.
+ * @param req HTTP request for which the uri needs to be handled.
+ * @return ESP_OK on success.
+ */
+static esp_err_t http_server_diag_handler(httpd_req_t *req)
+{
+    char buf[HTTP_SERVER_EVENTS_CHUNK];
+    json_writer_t w;
+    json_writer_init(&w, buf, sizeof(buf));
+    json_writer_set_flush(&w, http_server_chunk_flush, req);
+
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+    diag_write_json(&w);
+
+    if (json_writer_finish(&w) < 0)
+    {
+        ESP_LOGW(TAG, "Diagnostics response aborted");
+        return ESP_FAIL;
+    }
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+/**
+ * Latency trace handler returns per-stage percentiles in microseconds.
+ * Query: reset=1 clears the histograms after the report.
+ * @param req HTTP request for which the uri needs to be handled.
+ * @return ESP_OK on success.
+ */
+static esp_err_t http_server_trace_handler(httpd_req_t *req)
+{
+    char query[16];
+    const char *q = httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK ? query : NULL;
+    char buf[HTTP_SERVER_EVENTS_CHUNK];
+    json_writer_t w;
+    json_writer_init(&w, buf, sizeof(buf));
+    json_writer_set_flush(&w, http_server_chunk_flush, req);
+
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+    trace_write_json(&w);
+
+    if (http_server_query_uint(q, "reset", 0) != 0)
+    {
+        trace_reset();
+    }
+
+    if (json_writer_finish(&w) < 0)
+    {
+        ESP_LOGW(TAG, "Trace response aborted");
+        return ESP_FAIL;
+    }
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
@@ -3,68 +3,163 @@
  *
  *  Created on: 11 cze 2025
  *      Author: majorBien
+ *
+ * Inputs are captured by the GPIO ISR as timestamped edges into a
+ * single-producer/single-consumer ring buffer. io_task drains the ring,
+ * debounces each channel and wakes the logic task only on real changes.
  */
 
 #include "io.h"
-#include "driver/gpio.h"
+#include "hal_io.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
 #include "esp_log.h"
-#include "logic.h" 
+#include "logic.h"
+#include "debounce.h"
+#include "tasks_common.h"
+#include "line_status.h"
+#include "dlog.h"
+#include "trace.h"
 
 #define TAG "io"
 
 inputs_t inputs;
-extern QueueHandle_t input_queue;
+
+// Edge ring buffer: written only by the ISR, read only by io_task
+static io_edge_t edge_ring[IO_EDGE_RING_SIZE];
+static volatile uint32_t edge_head = 0;
+static volatile uint32_t edge_tail = 0;
+static volatile uint32_t edge_overruns = 0;
+
+static TaskHandle_t io_task_handle = NULL;
+static debounce_t debouncer;
+
+static void IRAM_ATTR io_gpio_isr(void *arg)
+{
+    uint8_t channel = (uint8_t)(uintptr_t)arg;
+    uint32_t head = edge_head;
+    uint32_t tail = __atomic_load_n(&edge_tail, __ATOMIC_ACQUIRE);
+
+    if (head - tail < IO_EDGE_RING_SIZE) {
+        io_edge_t *e = &edge_ring[head & (IO_EDGE_RING_SIZE - 1)];
+        e->channel = channel;
+        e->level = (hal_io_read_inputs() >> channel) & 1u;
+        e->timestamp_us = esp_timer_get_time();
+        __atomic_store_n(&edge_head, head + 1, __ATOMIC_RELEASE);
+    } else {
+        edge_overruns++;
+    }
+
+    BaseType_t woken = pdFALSE;
+    if (io_task_handle != NULL) {
+        vTaskNotifyGiveFromISR(io_task_handle, &woken);
+    }
+    portYIELD_FROM_ISR(woken);
+}
+
+static bool io_edge_pop(io_edge_t *out)
+{
+    uint32_t tail = edge_tail;
+    uint32_t head = __atomic_load_n(&edge_head, __ATOMIC_ACQUIRE);
+
+    if (tail == head) {
+        return false;
+    }
+
+    *out = edge_ring[tail & (IO_EDGE_RING_SIZE - 1)];
+    __atomic_store_n(&edge_tail, tail + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
 void io_init(void)
 {
-    // Configure input pins
-    gpio_config_t input_conf = {
-        .intr_type = GPIO_INTR_DISABLE,
-        .mode = GPIO_MODE_INPUT,
-        .pin_bit_mask = (1ULL << IO_INPUT_SENSOR_1) |
-                        (1ULL << IO_INPUT_SENSOR_2) |
-                        (1ULL << IO_INPUT_SENSOR_3) |
-                        (1ULL << IO_INPUT_WRAP_DONE),
-        .pull_down_en = 0,
-        .pull_up_en = 1
-    };
-    gpio_config(&input_conf);
-
-    // Configure output pins
-    gpio_config_t output_conf = {
-        .intr_type = GPIO_INTR_DISABLE,
-        .mode = GPIO_MODE_OUTPUT,
-        .pin_bit_mask = (1ULL << IO_OUTPUT_EJECTOR) |
-                        (1ULL << IO_OUTPUT_WRAPPER) |
-                        (1ULL << IO_OUTPUT_LED_GREEN) |
-                        (1ULL << IO_OUTPUT_LED_RED) |
-                        (1ULL << IO_OUTPUT_LED_YELLOW),
-        .pull_down_en = 0,
-        .pull_up_en = 0
-    };
-    gpio_config(&output_conf);
+    hal_io_init(io_gpio_isr);
 
     ESP_LOGI(TAG, "GPIO initialized");
 }
 
 void io_task(void *pvParameters)
 {
+    uint32_t overruns_seen = 0;
+
+    debounce_init(&debouncer, IO_CH_COUNT, IO_DEBOUNCE_US, hal_io_read_inputs(), esp_timer_get_time());
 
     while (1) {
-        inputs.sensor1 = gpio_get_level(IO_INPUT_SENSOR_1);
-        inputs.sensor2 = gpio_get_level(IO_INPUT_SENSOR_2);
-        inputs.sensor3 = gpio_get_level(IO_INPUT_SENSOR_3);
-        inputs.wrap_done = gpio_get_level(IO_INPUT_WRAP_DONE);
+        // Sleep until an edge arrives or a pending level is due for confirmation
+        TickType_t wait = portMAX_DELAY;
+        int64_t deadline = debounce_next_deadline(&debouncer);
+        if (deadline >= 0) {
+            int64_t remaining_us = deadline - esp_timer_get_time();
+            wait = (remaining_us > 0) ? pdMS_TO_TICKS((remaining_us + 999) / 1000) : 0;
+            if (remaining_us > 0 && wait == 0) {
+                wait = 1;
+            }
+        }
+        ulTaskNotifyTake(pdTRUE, wait);
+
+        io_edge_t edge;
+        while (io_edge_pop(&edge)) {
+            debounce_edge(&debouncer, edge.channel, edge.level, edge.timestamp_us);
+        }
+
+        // Dropped edges may include the last one of a channel: resync with the pins
+        uint32_t overruns = edge_overruns;
+        if (overruns != overruns_seen) {
+            overruns_seen = overruns;
+            debounce_resync(&debouncer, hal_io_read_inputs(), esp_timer_get_time());
+            DLOG_RATELIMIT(1000, ESP_LOG_WARN, TAG, "Edge ring overrun, inputs resynced");
+        }
 
-        // Debug log
-        ESP_LOGI(TAG, "Sensors: T1=%d T2=%d T3=%d WrapDone=%d",
-                 inputs.sensor1, inputs.sensor2, inputs.sensor3, inputs.wrap_done);
+        uint32_t changed = debounce_update(&debouncer, esp_timer_get_time());
+        if (changed == 0) {
+            continue;
+        }
+
+        uint32_t levels = debounce_levels(&debouncer);
+        inputs.sensor1 = levels & (1u << IO_CH_SENSOR_1);
+        inputs.sensor2 = levels & (1u << IO_CH_SENSOR_2);
+        inputs.sensor3 = levels & (1u << IO_CH_SENSOR_3);
+        inputs.wrap_done = levels & (1u << IO_CH_WRAP_DONE);
+        inputs.changed = (uint8_t)changed;
+
+        // Timestamp of the earliest confirmed edge in this snapshot
+        inputs.timestamp_us = 0;
+        for (int ch = 0; ch < IO_CH_COUNT; ch++) {
+            if ((changed & (1u << ch)) &&
+                (inputs.timestamp_us == 0 || debouncer.ch[ch].changed_at_us < inputs.timestamp_us)) {
+                inputs.timestamp_us = debouncer.ch[ch].changed_at_us;
+            }
+        }
+
+        DLOGD(TAG, "Sensors: T1=%" PRId32 " T2=%" PRId32 " T3=%" PRId32 " WrapDone=%" PRId32,
+              inputs.sensor1, inputs.sensor2, inputs.sensor3, inputs.wrap_done);
+
+        line_status_set_inputs(&inputs);
 
         // put inputs to queue
-        if (logic_input_queue != NULL) {
-            inputs_t copy = inputs;
-            xQueueSend(logic_input_queue, &copy, 0);
+        logic_event_t evt = { .type = LOGIC_EVT_INPUTS, .inputs = inputs };
+        if (logic_post_event(&evt) != pdTRUE) {
+            DLOG_RATELIMIT(1000, ESP_LOG_WARN, TAG, "Logic event queue full, snapshot dropped");
+        } else {
+            trace_record(TRACE_INPUT_POST, inputs.timestamp_us);
         }
+    }
+}
 
-        vTaskDelay(pdMS_TO_TICKS(500));
+void start_io_task(void)
+{
+    if (io_task_handle == NULL) {
+        xTaskCreatePinnedToCore(io_task,
+                                "io_task",
+                                IO_TASK_STACK_SIZE,
+                                NULL,
+                                IO_TASK_PRIORITY,
+                                &io_task_handle,
+                                IO_TASK_CORE_ID);
     }
 }
+
+uint32_t io_get_edge_overruns(void)
+{
+    return edge_overruns;
+}
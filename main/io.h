@@ -9,20 +9,15 @@
 #ifndef MAIN_IO_H_
 #define MAIN_IO_H_
 
+#include <stdbool.h>
+#include <stdint.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-extern QueueHandle_t input_queue;
-// GPIO pin definitions
-#define IO_INPUT_SENSOR_1     2   // Czujnik transporter 1
-#define IO_INPUT_SENSOR_2     3   // Czujnik transporter 2
-#define IO_INPUT_SENSOR_3     4   // Czujnik transporter 3
-#define IO_INPUT_WRAP_DONE    5   // Owijarka koniec
+#include "freertos/queue.h"
+#include "hal_io.h"     // IO_CH_* / IO_OUT_* channels, pins live in the HAL binding
 
-#define IO_OUTPUT_EJECTOR     12  // Siłownik zrzutu
-#define IO_OUTPUT_WRAPPER     13  // Start owijarki
-#define IO_OUTPUT_LED_GREEN   14  // Wieża zielona
-#define IO_OUTPUT_LED_RED     15  // Wieża czerwona
-#define IO_OUTPUT_LED_YELLOW  16  // Wieża żółta
+#define IO_DEBOUNCE_US        5000  // Level must be stable for 5 ms
+#define IO_EDGE_RING_SIZE     64    // Power of two
 
 
 typedef struct inputs{
@@ -30,12 +25,26 @@ typedef struct inputs{
 	bool sensor2;
 	bool sensor3;
 	bool wrap_done;
-	
+	uint8_t changed;        // IO_CH_* bit mask of inputs that changed in this snapshot
+	int64_t timestamp_us;   // Time of the edge that produced this snapshot
 }inputs_t;
 
+// Raw edge captured in the GPIO ISR
+typedef struct {
+	uint8_t channel;
+	uint8_t level;
+	int64_t timestamp_us;
+} io_edge_t;
+
 void io_init(void);
 void io_task(void *pvParameters);
 
+// Start the input task (edge ring consumer and debouncer)
+void start_io_task(void);
+
+// Number of edges dropped because the ring buffer was full
+uint32_t io_get_edge_overruns(void);
+
 #endif /* MAIN_IO_H_ */
 
 
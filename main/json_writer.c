@@ -0,0 +1,238 @@
+/*
+ * json_writer.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ */
+
+#include "json_writer.h"
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+static bool json_writer_flush_buf(json_writer_t *w)
+{
+    if (w->len == 0) {
+        return true;
+    }
+    if (!w->flush(w->flush_ctx, w->buf, w->len)) {
+        w->overflow = true;
+        return false;
+    }
+    w->len = 0;
+    return true;
+}
+
+static void json_writer_put(json_writer_t *w, const char *s, size_t n)
+{
+    if (w->overflow) {
+        return;
+    }
+
+    // Last byte is reserved for the NUL added by json_writer_finish()
+    if (w->len + n >= w->cap) {
+        if (w->flush == NULL || !json_writer_flush_buf(w)) {
+            w->overflow = true;
+            return;
+        }
+        if (n >= w->cap) {
+            if (!w->flush(w->flush_ctx, s, n)) {
+                w->overflow = true;
+            }
+            return;
+        }
+    }
+
+    memcpy(&w->buf[w->len], s, n);
+    w->len += n;
+}
+
+static void json_writer_putc(json_writer_t *w, char c)
+{
+    json_writer_put(w, &c, 1);
+}
+
+static void json_writer_put_string(json_writer_t *w, const char *s)
+{
+    const char *run = s;
+
+    json_writer_putc(w, '"');
+    for (; *s != '\0'; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+
+        json_writer_put(w, run, (size_t)(s - run));
+        run = s + 1;
+
+        char esc[8];
+        switch (c) {
+            case '"':  json_writer_put(w, "\\\"", 2); break;
+            case '\\': json_writer_put(w, "\\\\", 2); break;
+            case '\n': json_writer_put(w, "\\n", 2); break;
+            case '\r': json_writer_put(w, "\\r", 2); break;
+            case '\t': json_writer_put(w, "\\t", 2); break;
+            default:
+                snprintf(esc, sizeof(esc), "\\u%04x", c);
+                json_writer_put(w, esc, 6);
+                break;
+        }
+    }
+    json_writer_put(w, run, (size_t)(s - run));
+    json_writer_putc(w, '"');
+}
+
+/**
+ * @brief Separator and member name in front of every value
+ */
+static void json_writer_prefix(json_writer_t *w, const char *key)
+{
+    uint8_t bit = (uint8_t)(1u << w->depth);
+
+    if (w->has_items & bit) {
+        json_writer_putc(w, ',');
+    }
+    w->has_items |= bit;
+
+    if (key != NULL) {
+        json_writer_put_string(w, key);
+        json_writer_putc(w, ':');
+    }
+}
+
+static void json_writer_open(json_writer_t *w, const char *key, char c)
+{
+    json_writer_prefix(w, key);
+    json_writer_putc(w, c);
+
+    if (w->depth + 1 >= JSON_WRITER_MAX_DEPTH) {
+        w->overflow = true;
+        return;
+    }
+    w->depth++;
+    w->has_items &= (uint8_t)~(1u << w->depth);
+}
+
+static void json_writer_close(json_writer_t *w, char c)
+{
+    if (w->depth > 0) {
+        w->depth--;
+    }
+    json_writer_putc(w, c);
+}
+
+void json_writer_init(json_writer_t *w, char *buf, size_t cap)
+{
+    memset(w, 0, sizeof(*w));
+    w->buf = buf;
+    w->cap = cap;
+    if (cap == 0) {
+        w->overflow = true;
+    }
+}
+
+void json_writer_set_flush(json_writer_t *w, json_writer_flush_t fn, void *ctx)
+{
+    w->flush = fn;
+    w->flush_ctx = ctx;
+}
+
+void json_writer_object_begin(json_writer_t *w, const char *key)
+{
+    json_writer_open(w, key, '{');
+}
+
+void json_writer_object_end(json_writer_t *w)
+{
+    json_writer_close(w, '}');
+}
+
+void json_writer_array_begin(json_writer_t *w, const char *key)
+{
+    json_writer_open(w, key, '[');
+}
+
+void json_writer_array_end(json_writer_t *w)
+{
+    json_writer_close(w, ']');
+}
+
+void json_writer_bool(json_writer_t *w, const char *key, bool value)
+{
+    json_writer_prefix(w, key);
+    if (value) {
+        json_writer_put(w, "true", 4);
+    } else {
+        json_writer_put(w, "false", 5);
+    }
+}
+
+void json_writer_int(json_writer_t *w, const char *key, int64_t value)
+{
+    char num[24];
+    int n = snprintf(num, sizeof(num), "%" PRId64, value);
+
+    json_writer_prefix(w, key);
+    json_writer_put(w, num, (size_t)n);
+}
+
+void json_writer_uint(json_writer_t *w, const char *key, uint64_t value)
+{
+    char num[24];
+    int n = snprintf(num, sizeof(num), "%" PRIu64, value);
+
+    json_writer_prefix(w, key);
+    json_writer_put(w, num, (size_t)n);
+}
+
+void json_writer_str(json_writer_t *w, const char *key, const char *value)
+{
+    json_writer_prefix(w, key);
+    if (value == NULL) {
+        json_writer_put(w, "null", 4);
+    } else {
+        json_writer_put_string(w, value);
+    }
+}
+
+void json_writer_fixed(json_writer_t *w, const char *key, int32_t value, uint8_t decimals)
+{
+    char num[24];
+    uint32_t scale = 1;
+    uint32_t mag = value < 0 ? (uint32_t)(-(int64_t)value) : (uint32_t)value;
+    int n;
+
+    if (decimals > 9) {
+        decimals = 9;
+    }
+    for (uint8_t i = 0; i < decimals; i++) {
+        scale *= 10;
+    }
+
+    if (decimals == 0) {
+        n = snprintf(num, sizeof(num), "%s%" PRIu32, value < 0 ? "-" : "", mag);
+    } else {
+        n = snprintf(num, sizeof(num), "%s%" PRIu32 ".%0*" PRIu32, value < 0 ? "-" : "",
+                     mag / scale, (int)decimals, mag % scale);
+    }
+
+    json_writer_prefix(w, key);
+    json_writer_put(w, num, (size_t)n);
+}
+
+int json_writer_finish(json_writer_t *w)
+{
+    if (!w->overflow && w->flush != NULL) {
+        json_writer_flush_buf(w);
+    }
+    if (w->overflow) {
+        if (w->cap > 0) {
+            w->buf[0] = '\0';
+        }
+        return -1;
+    }
+
+    w->buf[w->len] = '\0';
+    return (int)w->len;
+}
@@ -0,0 +1,74 @@
+/*
+ * json_writer.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ *
+ * Streaming JSON writer into a caller-owned buffer, no heap use. With a
+ * flush callback the buffer is emptied whenever it fills up (e.g. into
+ * httpd_resp_send_chunk), so output size is not limited by the buffer.
+ * Without one, output that does not fit sets the overflow flag.
+ */
+
+#ifndef MAIN_JSON_WRITER_H_
+#define MAIN_JSON_WRITER_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define JSON_WRITER_MAX_DEPTH   8
+
+/**
+ * @brief Receives a filled part of the buffer.
+ * @return false to abort writing.
+ */
+typedef bool (*json_writer_flush_t)(void *ctx, const char *data, size_t len);
+
+typedef struct {
+    char    *buf;
+    size_t   cap;
+    size_t   len;
+    bool     overflow;          // output did not fit or the flush failed
+    uint8_t  depth;
+    uint8_t  has_items;         // bit n: container at depth n already has an element
+    json_writer_flush_t flush;
+    void    *flush_ctx;
+} json_writer_t;
+
+/**
+ * @brief Start writing into buf; one byte is kept for the terminating NUL.
+ */
+void json_writer_init(json_writer_t *w, char *buf, size_t cap);
+
+/**
+ * @brief Flush into fn whenever the buffer fills up and on json_writer_finish().
+ */
+void json_writer_set_flush(json_writer_t *w, json_writer_flush_t fn, void *ctx);
+
+/*
+ * Containers and values. key is the member name inside an object and
+ * must be NULL for array elements and for the top-level value.
+ */
+void json_writer_object_begin(json_writer_t *w, const char *key);
+void json_writer_object_end(json_writer_t *w);
+void json_writer_array_begin(json_writer_t *w, const char *key);
+void json_writer_array_end(json_writer_t *w);
+
+void json_writer_bool(json_writer_t *w, const char *key, bool value);
+void json_writer_int(json_writer_t *w, const char *key, int64_t value);
+void json_writer_uint(json_writer_t *w, const char *key, uint64_t value);
+void json_writer_str(json_writer_t *w, const char *key, const char *value);
+
+/**
+ * @brief Fixed-point number: value / 10^decimals, printed without floats.
+ */
+void json_writer_fixed(json_writer_t *w, const char *key, int32_t value, uint8_t decimals);
+
+/**
+ * @brief Terminate the output and flush what is left.
+ * @return Length in the buffer (0 after a flush), or -1 on overflow.
+ */
+int json_writer_finish(json_writer_t *w);
+
+#endif /* MAIN_JSON_WRITER_H_ */
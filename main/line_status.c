@@ -0,0 +1,137 @@
+/*
+ * line_status.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ */
+
+#include "line_status.h"
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+
+/*
+ * Seqlock: writers serialise among themselves on status_lock and make
+ * status_seq odd for the duration of the update. Readers take no lock;
+ * they copy the struct and retry if the sequence was odd or moved.
+ * The writer section runs with interrupts off on its core, so a reader
+ * can only ever wait for a writer on the other core, for a few fields.
+ */
+static portMUX_TYPE status_lock = portMUX_INITIALIZER_UNLOCKED;
+static line_status_t status;
+static uint32_t status_seq = 0;
+static volatile uint32_t status_version = 0;
+static line_status_listener_t status_listener = NULL;
+
+// Field updates are done under the lock so concurrent writers never lose each other's changes
+#define LINE_STATUS_UPDATE(field, value, changed)   \
+    do {                                            \
+        if (status.field != (value)) {              \
+            status.field = (value);                 \
+            changed = true;                         \
+        }                                           \
+    } while (0)
+
+static void line_status_lock(void)
+{
+    portENTER_CRITICAL(&status_lock);
+    __atomic_store_n(&status_seq, status_seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static void line_status_unlock(bool changed)
+{
+    if (changed) {
+        status_version++;
+    }
+    __atomic_store_n(&status_seq, status_seq + 1, __ATOMIC_RELEASE);
+    portEXIT_CRITICAL(&status_lock);
+
+    if (changed && status_listener != NULL) {
+        status_listener();
+    }
+}
+
+void line_status_set_inputs(const inputs_t *inputs)
+{
+    bool changed = false;
+
+    line_status_lock();
+    LINE_STATUS_UPDATE(sensor1, inputs->sensor1, changed);
+    LINE_STATUS_UPDATE(sensor2, inputs->sensor2, changed);
+    LINE_STATUS_UPDATE(sensor3, inputs->sensor3, changed);
+    LINE_STATUS_UPDATE(wrap_done, inputs->wrap_done, changed);
+    line_status_unlock(changed);
+}
+
+void line_status_set_weight(int32_t weight_g)
+{
+    bool changed = false;
+    int32_t quantized = (weight_g / LINE_STATUS_WEIGHT_STEP_G) * LINE_STATUS_WEIGHT_STEP_G;
+
+    line_status_lock();
+    LINE_STATUS_UPDATE(weight_g, quantized, changed);
+    line_status_unlock(changed);
+}
+
+void line_status_set_weight_status(line_weight_status_t weight_status)
+{
+    bool changed = false;
+
+    line_status_lock();
+    LINE_STATUS_UPDATE(weight_status, (uint8_t)weight_status, changed);
+    line_status_unlock(changed);
+}
+
+void line_status_set_links(bool robot, bool inverter)
+{
+    bool changed = false;
+
+    line_status_lock();
+    LINE_STATUS_UPDATE(robot, robot, changed);
+    LINE_STATUS_UPDATE(inverter, inverter, changed);
+    line_status_unlock(changed);
+}
+
+void line_status_set_wrap_progress(uint8_t percent)
+{
+    bool changed = false;
+
+    line_status_lock();
+    LINE_STATUS_UPDATE(wrap_progress, percent > 100 ? 100 : percent, changed);
+    line_status_unlock(changed);
+}
+
+void line_status_set_line(uint8_t state, uint8_t layers, uint8_t max_layers, uint8_t cubes)
+{
+    bool changed = false;
+
+    line_status_lock();
+    LINE_STATUS_UPDATE(state, state, changed);
+    LINE_STATUS_UPDATE(layers, layers, changed);
+    LINE_STATUS_UPDATE(max_layers, max_layers, changed);
+    LINE_STATUS_UPDATE(cubes, cubes, changed);
+    line_status_unlock(changed);
+}
+
+void line_status_get(line_status_t *out)
+{
+    uint32_t seq;
+
+    do {
+        while ((seq = __atomic_load_n(&status_seq, __ATOMIC_ACQUIRE)) & 1u) {
+            // writer in progress on the other core
+        }
+        memcpy(out, &status, sizeof(*out));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while (__atomic_load_n(&status_seq, __ATOMIC_RELAXED) != seq);
+}
+
+uint32_t line_status_version(void)
+{
+    return status_version;
+}
+
+void line_status_set_listener(line_status_listener_t listener)
+{
+    status_listener = listener;
+}
@@ -0,0 +1,70 @@
+/*
+ * line_status.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ *
+ * Operator-visible line status, written by the control tasks and read by
+ * the HTTP server. Writers are short critical sections; readers are
+ * lock-free (seqlock) so the web server can never hold up a control task.
+ * Every change bumps a version counter and wakes the registered listener
+ * (the WebSocket push task).
+ */
+
+#ifndef MAIN_LINE_STATUS_H_
+#define MAIN_LINE_STATUS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "io.h"
+
+#define LINE_STATUS_WEIGHT_STEP_G   10      // Weight is published in 10 g steps
+
+typedef enum {
+    LINE_WEIGHT_NONE = 0,
+    LINE_WEIGHT_OK,
+    LINE_WEIGHT_REJECT,
+    LINE_WEIGHT_UNSTABLE
+} line_weight_status_t;
+
+typedef struct {
+    int32_t  weight_g;
+    uint8_t  weight_status;     // line_weight_status_t of the last weighed cube
+    bool     sensor1;
+    bool     sensor2;
+    bool     sensor3;
+    bool     wrap_done;
+    bool     robot;             // robot link connected
+    bool     inverter;          // inverter Modbus connection up
+    uint8_t  wrap_progress;     // percent
+    uint8_t  state;             // system_state_t
+    uint8_t  layers;
+    uint8_t  max_layers;
+    uint8_t  cubes;             // cubes in flight
+} line_status_t;
+
+typedef void (*line_status_listener_t)(void);
+
+void line_status_set_inputs(const inputs_t *inputs);
+void line_status_set_weight(int32_t weight_g);
+void line_status_set_weight_status(line_weight_status_t status);
+void line_status_set_links(bool robot, bool inverter);
+void line_status_set_wrap_progress(uint8_t percent);
+void line_status_set_line(uint8_t state, uint8_t layers, uint8_t max_layers, uint8_t cubes);
+
+/**
+ * @brief Copy a consistent snapshot of the status without taking a lock.
+ */
+void line_status_get(line_status_t *out);
+
+/**
+ * @brief Counter incremented on every change.
+ */
+uint32_t line_status_version(void);
+
+/**
+ * @brief Register the function called after each change (task context).
+ */
+void line_status_set_listener(line_status_listener_t listener);
+
+#endif /* MAIN_LINE_STATUS_H_ */
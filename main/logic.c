@@ -12,126 +12,624 @@
 #include "freertos/task.h"
 #include "freertos/queue.h"
 #include "esp_log.h"
-#include "driver/gpio.h"
+#include "esp_timer.h"
+#include "hal_io.h"
 #include "tcp.h"
 #include "tasks_common.h"
 #include "adc.h"
 #include "http_server.h"
+#include "cube_tracker.h"
+#include "line_status.h"
+#include "event_log.h"
+#include "dlog.h"
+#include "diag.h"
+#include "trace.h"
+#include "throughput.h"
+#include "pallet_plan.h"
+#include "conveyor.h"
+#include "outputs.h"
+#include "checkweigh.h"
 #include <string.h>     
 
 QueueHandle_t tcp_command_queue;
 
 #define TAG "logic"
 
-extern QueueHandle_t input_queue;
-extern QueueHandle_t hmi_data_queue;
+#define WEIGHT_MIN_G    49000
+#define WEIGHT_MAX_G    51000
+
+#define EJECTOR_OFFSET_MM   150     // T2 sensor to the centre of the ejector paddle
+#define EJECTOR_STROKE_MM   200     // belt travel while the ejector stays out
+#define LED_RED_MS          500
+#define LED_GREEN_MS        1000
 
 static system_state_t current_state = STATE_IDLE;
-static uint8_t layer_count = 0;
 static uint8_t max_layers = 5;  // Default value, can be changed via HMI
+// Build station: the pallet the robot is stacking, independent of the wrap station
+static struct {
+    uint16_t next_slot;     // next slot to hand to the robot, taken on ACK
+    uint16_t cubes;         // cubes placed
+} build;
+static uint16_t wrap_cubes = 0;     // cubes on the pallet at the wrap station
+static bool line_running = true;    // STOP from the panel holds the robot and the wrapper
+static bool service_mode = false;   // manual operation, automatic sequencing suspended
+static cube_tracker_t cubes;
+static uint16_t weighing_id = 0;    // Cube on the scale being weighed, 0 if none
+static uint16_t robot_cube_id = 0;  // Cube offered to the robot and not yet acknowledged
+                                    // (or rejected); replies are matched by cube_t.robot_seq
+// Checkweigher calibration: reference cubes of ref_g are measured and ejected
+static struct {
+    int32_t ref_g;          // 0 when not calibrating
+    checkweigh_cal_t cal;
+} calib;
+
+BaseType_t logic_post_event_wait(const logic_event_t *evt, TickType_t wait)
+{
+    if (logic_event_queue == NULL) {
+        return pdFALSE;
+    }
+    return xQueueSend(logic_event_queue, evt, wait);
+}
+
+BaseType_t logic_post_event(const logic_event_t *evt)
+{
+    return logic_post_event_wait(evt, 0);
+}
+
+/*
+ * Ejector actions run in the esp_timer task when the belt reaches the
+ * scheduled position. Strokes of closely spaced cubes may overlap, so the
+ * ejector retracts only when the last one ends.
+ */
+static uint8_t ejects_active = 0;                  // esp_timer task only
+
+static void logic_ejector_on_cb(void *arg)
+{
+    ejects_active++;
+    hal_io_write_outputs(IO_OUT_BIT(IO_OUT_EJECTOR), 0);
+    // Lateness against the moment the belt reached the stroke position, carried in arg
+    trace_record(TRACE_EJECT_GPIO, conveyor_time_at((int32_t)(intptr_t)arg));
+}
+
+static void logic_ejector_off_cb(void *arg)
+{
+    if (ejects_active > 0 && --ejects_active == 0) {
+        hal_io_write_outputs(0, IO_OUT_BIT(IO_OUT_EJECTOR));
+    }
+
+    logic_event_t evt = { .type = LOGIC_EVT_EJECTED };
+    if (xQueueSendToFront(logic_event_queue, &evt, 0) != pdTRUE) {
+        DLOG_RATELIMIT(1000, ESP_LOG_ERROR, TAG, "Logic event queue full, eject report dropped");
+    }
+}
+
+/**
+ * Push the cube off the belt when it is in front of the ejector, measured
+ * from its T2 edge, and retract once it has travelled past.
+ */
+static void logic_eject(const cube_t *c, int64_t edge_us)
+{
+    int32_t at_t2 = conveyor_position_at(edge_us);
+    int32_t on_at = at_t2 + CONVEYOR_MM(EJECTOR_OFFSET_MM);
+    // Each action carries its own stroke position, however many ejects are pending
+    void *arg = (void *)(intptr_t)on_at;
+
+    // Retract first, so the ejector is never extended without a scheduled end
+    if (conveyor_schedule(at_t2 + CONVEYOR_MM(EJECTOR_OFFSET_MM + EJECTOR_STROKE_MM),
+                          logic_ejector_off_cb, arg) != ESP_OK) {
+        DLOGE(TAG, "Too many ejects pending, cube %" PRIu32 " not ejected", c->id);
+        return;
+    }
+    if (conveyor_schedule(on_at, logic_ejector_on_cb, arg) != ESP_OK) {
+        // Without the stroke the retract would report an eject that never happened
+        conveyor_cancel(logic_ejector_off_cb, arg);
+        DLOGE(TAG, "Too many ejects pending, cube %" PRIu32 " not ejected", c->id);
+    }
+}
+
+static void logic_log(event_log_type_t type, uint16_t cube_id, int32_t weight_g)
+{
+    event_log_add(type, cube_id, weight_g, (uint8_t)current_state);
+    throughput_count(type);
+}
+
+_Static_assert(HMI_LAYERS_MAX <= PALLET_PLAN_MAX_LAYERS, "pallet plan too short for the HMI layer range");
+
+static uint8_t logic_layers_done(void)
+{
+    return (uint8_t)(build.cubes / PALLET_CUBES_PER_LAYER);
+}
+
+static bool logic_rising(const inputs_t *inputs, int channel, bool level)
+{
+    return (inputs->changed & (1u << channel)) && level;
+}
+
+/**
+ * Hand the full pallet over to the wrap station and give the robot an
+ * empty one.
+ */
+static void logic_start_wrap(void)
+{
+    wrap_cubes = build.cubes;
+    build.next_slot = 0;
+    build.cubes = 0;
+
+    tcp_command_t cmd_i = { .type = CMD_INVERTER_START };
+    xQueueSend(tcp_command_queue, &cmd_i, 0);
+    hal_io_write_outputs(IO_OUT_BIT(IO_OUT_WRAPPER), 0);
+    line_status_set_wrap_progress(0);
+    DLOGI(TAG, "Wrapper started");
+    logic_log(EVENT_LOG_WRAP_START, 0, wrap_cubes);
+    current_state = STATE_WAIT_WRAP_DONE;
+}
+
+/**
+ * Start weighing the oldest cube on the scale that has no verdict yet.
+ */
+static void logic_weigh_next(void)
+{
+    if (weighing_id != 0) {
+        return;
+    }
+
+    cube_t *c = cube_tracker_oldest_unweighed(&cubes);
+    if (c != NULL) {
+        weighing_id = c->id;
+        adc_weigh_start(c->id);
+    }
+}
+
+/**
+ * Hand the oldest cube waiting at T3 to the robot, one at a time, as long
+ * as it still fits on the current pallet and the robot link has a free
+ * command slot (accepted cubes hold theirs until DONE). origin_us is the
+ * T3 edge when called for a cube that just arrived, 0 otherwise (not traced).
+ */
+static void logic_dispatch_robot(int64_t origin_us)
+{
+    if (!line_running || service_mode) {
+        return;
+    }
+    if (robot_cube_id != 0) {
+        return;
+    }
+    if (build.next_slot >= pallet_plan_slots(max_layers)) {
+        return;
+    }
+    if (cube_tracker_count_in(&cubes, CUBE_ZONE_ROBOT) >= ROBOT_LINK_MAX_PENDING) {
+        return;
+    }
+
+    cube_t *c = cube_tracker_oldest_in(&cubes, CUBE_ZONE_PICKUP);
+    if (c == NULL) {
+        return;
+    }
+
+    DLOGI(TAG, "Cube %" PRIu32 " ready for pickup by robot, slot %" PRIu32, c->id, build.next_slot);
+    tcp_command_t cmd_r = {
+        .type = CMD_ROBOT_PLACE,
+        .origin_us = origin_us,
+        .slot = build.next_slot,
+        .pose = *pallet_plan_slot(build.next_slot),
+        .cube_id = c->id,
+    };
+    if (xQueueSend(tcp_command_queue, &cmd_r, 0) != pdTRUE) {
+        DLOGE(TAG, "TCP command queue full, cube %" PRIu32 " not offered", c->id);
+        return;
+    }
+    trace_record(TRACE_PLACE_DECIDE, origin_us);
+    robot_cube_id = c->id;
+}
+
+/**
+ * Hand the pallet over once it is complete, the robot is idle and the
+ * wrap station is free.
+ */
+static void logic_check_pallet_full(void)
+{
+    if (!line_running || service_mode) {
+        return;
+    }
+    if (current_state != STATE_WAIT_WRAP_DONE && build.next_slot >= pallet_plan_slots(max_layers) &&
+        robot_cube_id == 0 && cube_tracker_count_in(&cubes, CUBE_ZONE_ROBOT) == 0) {
+        logic_start_wrap();
+        logic_dispatch_robot(0);
+    }
+}
+
+static void logic_on_t1(const inputs_t *inputs)
+{
+    cube_t *c = cube_tracker_add(&cubes, inputs->timestamp_us);
+    if (c == NULL) {
+        DLOGE(TAG, "Too many cubes on the line, new cube not tracked");
+        return;
+    }
+
+    DLOGI(TAG, "Cube %" PRIu32 " on T1, %" PRIu32 " in flight", c->id, cube_tracker_count(&cubes));
+    logic_log(EVENT_LOG_CUBE_IN, c->id, 0);
+    logic_weigh_next();
+}
+
+static void logic_on_t2(const inputs_t *inputs)
+{
+    cube_t *c = cube_tracker_oldest_in(&cubes, CUBE_ZONE_WEIGH);
+    if (c == NULL) {
+        DLOGW(TAG, "Untracked cube on T2");
+        return;
+    }
+
+    if (c->verdict == CUBE_VERDICT_PENDING) {
+        // Left the scale before the reading settled
+        DLOGW(TAG, "Cube %" PRIu32 " left the scale unweighed", c->id);
+        logic_log(EVENT_LOG_UNSTABLE, c->id, 0);
+        if (weighing_id == c->id) {
+            adc_weigh_cancel();
+            weighing_id = 0;
+        }
+        c->verdict = CUBE_VERDICT_REJECT;
+    }
+
+    if (c->verdict == CUBE_VERDICT_REJECT) {
+        DLOGW(TAG, "Cube %" PRIu32 " rejected, ejecting", c->id);
+        trace_record(TRACE_EJECT_DECIDE, inputs->timestamp_us);
+        logic_log(EVENT_LOG_EJECT, c->id, c->weight_g);
+        logic_eject(c, inputs->timestamp_us);
+        cube_tracker_remove(&cubes, c);
+    } else {
+        c->zone = CUBE_ZONE_TRANSFER;
+    }
+
+    logic_weigh_next();
+}
+
+static void logic_on_t3(const inputs_t *inputs)
+{
+    cube_t *c = cube_tracker_oldest_in(&cubes, CUBE_ZONE_TRANSFER);
+    if (c == NULL) {
+        DLOGW(TAG, "Untracked cube on T3");
+        return;
+    }
+
+    c->zone = CUBE_ZONE_PICKUP;
+    logic_dispatch_robot(inputs->timestamp_us);
+}
+
+/**
+ * Pick up pending work after the line was released by the operator.
+ */
+static void logic_resume(void)
+{
+    logic_dispatch_robot(0);
+    logic_check_pallet_full();
+}
+
+static void logic_cmd_start(const hmi_cmd_t *cmd)
+{
+    line_running = true;
+    DLOGI(TAG, "Line started from HMI");
+    logic_resume();
+}
+
+static void logic_cmd_stop(const hmi_cmd_t *cmd)
+{
+    line_running = false;
+    DLOGI(TAG, "Line stopped from HMI");
+}
+
+static void logic_cmd_set_layers(const hmi_cmd_t *cmd)
+{
+    max_layers = cmd->layers;
+    DLOGI(TAG, "max_layers now %" PRId32, max_layers);
+    logic_resume();
+}
+
+static void logic_cmd_service_mode(const hmi_cmd_t *cmd)
+{
+    service_mode = cmd->enable;
+    DLOGI(TAG, "Service mode %s", DLOG_STR(service_mode ? "on" : "off"));
+    if (!service_mode) {
+        logic_resume();
+    }
+}
+
+static void logic_cmd_reset_errors(const hmi_cmd_t *cmd)
+{
+    outputs_pulse(IO_OUT_LED_RED, 0);
+    line_status_set_weight_status(LINE_WEIGHT_NONE);
+    cubes.lost = 0;
+    DLOGI(TAG, "Errors reset from HMI");
+}
+
+/**
+ * A non-zero reference mass starts a calibration (or restarts it with the
+ * new mass); 0 fits the offsets from the reference cubes weighed so far.
+ */
+static void logic_cmd_calibrate_weight(const hmi_cmd_t *cmd)
+{
+    if (cmd->ref_g != 0) {
+        calib.ref_g = cmd->ref_g;
+        checkweigh_cal_reset(&calib.cal);
+        DLOGI(TAG, "Weight calibration with %" PRId32 " g reference cubes", calib.ref_g);
+        return;
+    }
+    if (calib.ref_g == 0) {
+        return;
+    }
+    calib.ref_g = 0;
+
+    checkweigh_comp_t comp;
+    if (!checkweigh_cal_fit(&calib.cal, &comp)) {
+        DLOGW(TAG, "Weight calibration needs %" PRId32 " reference cubes in motion, got %" PRId32,
+              CHECKWEIGH_CAL_MIN_CUBES, calib.cal.n);
+        return;
+    }
+    if (adc_weigh_set_comp(&comp) != ESP_OK) {
+        DLOGE(TAG, "Weight calibration not saved");
+    }
+    DLOGI(TAG, "Weight calibration from %" PRId32 " cubes: %" PRId32 " g + %" PRId32 " mg per mm/s",
+          calib.cal.n, comp.offset_g, comp.slope_mg_mm_s);
+}
+
+typedef void (*logic_cmd_handler_t)(const hmi_cmd_t *cmd);
+
+static const logic_cmd_handler_t logic_cmd_handlers[HMI_CMD_COUNT] = {
+    [HMI_CMD_START]            = logic_cmd_start,
+    [HMI_CMD_STOP]             = logic_cmd_stop,
+    [HMI_CMD_SET_LAYERS]       = logic_cmd_set_layers,
+    [HMI_CMD_SERVICE_MODE]     = logic_cmd_service_mode,
+    [HMI_CMD_RESET_ERRORS]     = logic_cmd_reset_errors,
+    [HMI_CMD_CALIBRATE_WEIGHT] = logic_cmd_calibrate_weight,
+};
+
+static void logic_handle_hmi(const hmi_cmd_t *cmd)
+{
+    logic_log(EVENT_LOG_HMI_CMD, cmd->id, hmi_cmd_arg(cmd));
+    if (cmd->id < HMI_CMD_COUNT && logic_cmd_handlers[cmd->id] != NULL) {
+        logic_cmd_handlers[cmd->id](cmd);
+    }
+}
+
+static void logic_handle_inputs(const inputs_t *inputs)
+{
+    if (logic_rising(inputs, IO_CH_SENSOR_1, inputs->sensor1)) {
+        logic_on_t1(inputs);
+    }
+    if (logic_rising(inputs, IO_CH_SENSOR_2, inputs->sensor2)) {
+        logic_on_t2(inputs);
+    }
+    if (logic_rising(inputs, IO_CH_SENSOR_3, inputs->sensor3)) {
+        logic_on_t3(inputs);
+    }
+
+    switch (current_state) {
+        case STATE_IDLE:
+            break;
+
+        case STATE_WAIT_WRAP_DONE:
+            // Edge, not level: the next pallet can be handed over while the signal is still high
+            if (logic_rising(inputs, IO_CH_WRAP_DONE, inputs->wrap_done)) {
+                hal_io_write_outputs(0, IO_OUT_BIT(IO_OUT_WRAPPER));
+                outputs_pulse(IO_OUT_LED_GREEN, LED_GREEN_MS);
+                DLOGI(TAG, "Wrapping completed");
+                logic_log(EVENT_LOG_WRAP_DONE, 0, wrap_cubes);
+                line_status_set_wrap_progress(100);
+                wrap_cubes = 0;
+                current_state = STATE_IDLE;
+                // A full pallet may be waiting at the build station
+                logic_check_pallet_full();
+            }
+            break;
+
+    }
+}
+
+static void logic_handle_weigh(const weigh_result_t *res)
+{
+    if (res->cube_id != weighing_id) {
+        return;     // cancelled measurement
+    }
+    weighing_id = 0;
+
+    cube_t *c = cube_tracker_oldest_unweighed(&cubes);
+    if (c == NULL || c->id != res->cube_id) {
+        logic_weigh_next();
+        return;
+    }
+
+    c->weight_g = res->mean_g;
+    DLOGI(TAG, "Cube %" PRIu32 " weight: %" PRId32 " g (sd %" PRId32 " g, %" PRIu32 " ms)", c->id,
+          res->mean_g, res->stddev_g, res->settle_ms);
+
+    if (calib.ref_g != 0) {
+        // Reference cubes never go to the pallet; only stable passages in motion are used
+        if (res->status == WEIGH_RESULT_STABLE && res->speed_mm_s != 0) {
+            checkweigh_cal_add(&calib.cal, res->speed_mm_s, res->raw_g - calib.ref_g);
+            DLOGI(TAG, "Reference cube %" PRId32 ": error %" PRId32 " g", calib.cal.n, res->raw_g - calib.ref_g);
+        }
+        c->verdict = CUBE_VERDICT_REJECT;
+        line_status_set_weight_status(LINE_WEIGHT_NONE);
+    } else if (res->status != WEIGH_RESULT_STABLE) {
+        DLOGW(TAG, "Weight did not settle");
+        logic_log(EVENT_LOG_UNSTABLE, c->id, res->mean_g);
+        c->verdict = CUBE_VERDICT_REJECT;
+        line_status_set_weight_status(LINE_WEIGHT_UNSTABLE);
+    } else if (res->mean_g < WEIGHT_MIN_G || res->mean_g > WEIGHT_MAX_G) {
+        DLOGW(TAG, "Incorrect weight");
+        logic_log(EVENT_LOG_REJECT, c->id, res->mean_g);
+        c->verdict = CUBE_VERDICT_REJECT;
+        line_status_set_weight_status(LINE_WEIGHT_REJECT);
+    } else {
+        logic_log(EVENT_LOG_ACCEPT, c->id, res->mean_g);
+        c->verdict = CUBE_VERDICT_ACCEPT;
+        line_status_set_weight_status(LINE_WEIGHT_OK);
+    }
+
+    logic_weigh_next();
+}
+
+/**
+ * The robot took the cube from T3: its slot is used from now on.
+ */
+static void logic_robot_accepted(cube_t *c, uint16_t seq)
+{
+    DLOGI(TAG, "Robot accepted cube %" PRIu32 " (#%" PRIu32 ")", c->id, seq);
+    c->zone = CUBE_ZONE_ROBOT;
+    build.next_slot++;
+    if (robot_cube_id == c->id) {
+        robot_cube_id = 0;
+    }
+}
+
+static void logic_handle_robot(const robot_event_t *evt)
+{
+    bool by_id = (evt->reply == ROBOT_REPLY_QUEUED || evt->reply == ROBOT_REPLY_NOT_SENT);
+    cube_t *c = by_id ? cube_tracker_find(&cubes, evt->cube_id) : cube_tracker_find_robot_seq(&cubes, evt->seq);
+
+    if (c == NULL) {
+        DLOGW(TAG, "Robot reply %" PRId32 " for #%" PRIu32 " matches no cube", evt->reply, evt->seq);
+        return;
+    }
+
+    switch (evt->reply) {
+        case ROBOT_REPLY_QUEUED:
+            c->robot_seq = evt->seq;
+            return;
+
+        case ROBOT_REPLY_NOT_SENT:
+            /*
+             * The link is full of commands waiting for their replies; each
+             * of them ends in another robot event, which dispatches again.
+             * Retrying now would only fail the same way.
+             */
+            DLOGW(TAG, "Robot link busy, cube %" PRIu32 " waits at T3", c->id);
+            logic_log(EVENT_LOG_ROBOT_FAULT, c->id, evt->reply);
+            if (robot_cube_id == c->id) {
+                robot_cube_id = 0;
+            }
+            return;
+
+        case ROBOT_REPLY_ACK:
+            if (c->zone == CUBE_ZONE_PICKUP) {
+                logic_robot_accepted(c, evt->seq);
+            }
+            break;
+
+        case ROBOT_REPLY_DONE:
+            // The ACK may have been lost; DONE implies it
+            if (c->zone == CUBE_ZONE_PICKUP) {
+                logic_robot_accepted(c, evt->seq);
+            }
+            logic_log(EVENT_LOG_PLACED, c->id, c->weight_g);
+            cube_tracker_remove(&cubes, c);
+            build.cubes++;
+            DLOGI(TAG, "Cubes placed: %" PRIu32 ", layers %" PRIu32 " / %" PRIu32, build.cubes, logic_layers_done(), max_layers);
+            break;
+
+        case ROBOT_REPLY_ERROR:
+        case ROBOT_REPLY_TIMEOUT:
+        case ROBOT_REPLY_DISCONNECTED:
+            logic_log(EVENT_LOG_ROBOT_FAULT, c->id, evt->reply);
+            if (c->zone == CUBE_ZONE_PICKUP) {
+                // Not taken by the robot, the cube is still at T3; dispatch again below
+                DLOGW(TAG, "Robot did not accept cube %" PRIu32 " (#%" PRIu32 "), retrying", c->id, evt->seq);
+                c->robot_seq = 0;
+                if (robot_cube_id == c->id) {
+                    robot_cube_id = 0;
+                }
+                break;
+            }
+            // Its slot stays used: the robot may have left the block on the pallet
+            DLOGE(TAG, "Robot failed to place cube %" PRIu32 " (#%" PRIu32 ")", c->id, evt->seq);
+            cube_tracker_remove(&cubes, c);
+            break;
+    }
+
+    logic_check_pallet_full();
+    logic_dispatch_robot(0);
+}
+
+/**
+ * Yellow lamp: steady in service mode, slow blink while a pallet is
+ * being wrapped, off otherwise.
+ */
+static void logic_update_lamps(void)
+{
+    outputs_pattern_t yellow = OUTPUTS_OFF;
+
+    if (service_mode) {
+        yellow = OUTPUTS_ON;
+    } else if (current_state == STATE_WAIT_WRAP_DONE) {
+        yellow = OUTPUTS_BLINK_SLOW;
+    }
+    outputs_set_pattern(IO_OUT_LED_YELLOW, yellow);
+}
+
+void logic_init(void)
+{
+    if (tcp_command_queue == NULL) {
+        tcp_command_queue = xQueueCreate(10, sizeof(tcp_command_t));
+        configASSERT(tcp_command_queue != NULL);
+        diag_register_queue(DIAG_QUEUE_TCP_COMMAND, "tcp_command", tcp_command_queue);
+    }
+
+    current_state = STATE_IDLE;
+    memset(&build, 0, sizeof(build));
+    wrap_cubes = 0;
+    line_running = true;
+    service_mode = false;
+    weighing_id = 0;
+    robot_cube_id = 0;
+    calib.ref_g = 0;
+    cube_tracker_init(&cubes);
+    pallet_plan_init();
+}
+
+void logic_process(const logic_event_t *evt)
+{
+    switch (evt->type) {
+        case LOGIC_EVT_INPUTS:
+            trace_record(TRACE_INPUT_RECV, evt->inputs.timestamp_us);
+            logic_handle_inputs(&evt->inputs);
+            break;
+
+        case LOGIC_EVT_WEIGH_DONE:
+            logic_handle_weigh(&evt->weigh);
+            break;
+
+        case LOGIC_EVT_ROBOT:
+            logic_handle_robot(&evt->robot);
+            break;
+
+        case LOGIC_EVT_HMI:
+            logic_handle_hmi(&evt->hmi);
+            break;
+
+        case LOGIC_EVT_EJECTED:
+            outputs_pulse(IO_OUT_LED_RED, LED_RED_MS);
+            DLOGI(TAG, "Rejected cube ejected");
+            break;
+    }
+
+    logic_update_lamps();
+    line_status_set_line(current_state, logic_layers_done(), max_layers, cube_tracker_count(&cubes));
+}
 
 void logic_task(void *pvParameters) {
-    inputs_t inputs;
-    float weight = 0;
-    tcp_command_queue = xQueueCreate(10, sizeof(tcp_command_t));
-    configASSERT(tcp_command_queue != NULL);
-    
+    logic_event_t evt;
+
+    logic_init();
+
     while (1) {
-        if (xQueueReceive(input_queue, &inputs, portMAX_DELAY)) {
-            switch (current_state) {
-                case STATE_IDLE:
-                    if (inputs.sensor1) {
-                        ESP_LOGI(TAG, "Cube on T1, start");
-                        current_state = STATE_MEASURING;
-                    }
-                    break;
-
-                case STATE_MEASURING:
-                    weight = read_weight();
-                    ESP_LOGI(TAG, "Cube weight: %.2f kg", weight);
-
-                    if (weight < 49.0f || weight > 51.0f) {
-                        ESP_LOGW(TAG, "Incorrect weight, ejecting");
-                        current_state = STATE_EJECT_REJECTED;
-                    } else {
-                        current_state = STATE_READY_FOR_ROBOT;
-                    }
-                    break;
-
-                case STATE_READY_FOR_ROBOT:
-                    if (inputs.sensor3) {
-                        ESP_LOGI(TAG, "Cube ready for pickup by robot");
-                        tcp_command_t cmd_r = { .type = CMD_ROBOT_PLACE };
-                        xQueueSend(tcp_command_queue, &cmd_r, 0);
-                        current_state = STATE_WAIT_FOR_LAYER;
-                    }
-                    break;
-
-                case STATE_WAIT_FOR_LAYER:
-                    layer_count++;
-                    ESP_LOGI(TAG, "Layers placed: %d / %d", layer_count, max_layers);
-
-                    if (layer_count >= max_layers) {
-                        tcp_command_t cmd_i = { .type = CMD_INVERTER_START };
-                        xQueueSend(tcp_command_queue, &cmd_i, 0);
-                        current_state = STATE_WAIT_WRAP_DONE;
-                    } else {
-                        current_state = STATE_IDLE;
-                    }
-                    break;
-
-                case STATE_WRAPPING:
-                    if (inputs.wrap_done) {
-                        ESP_LOGI(TAG, "Wrapping completed");
-                        gpio_set_level(IO_OUTPUT_LED_GREEN, 1);
-                        vTaskDelay(pdMS_TO_TICKS(1000));
-                        gpio_set_level(IO_OUTPUT_LED_GREEN, 0);
-                        layer_count = 0;
-                        current_state = STATE_IDLE;
-                    }
-                    break;
-
-                case STATE_EJECT_REJECTED:
-                    gpio_set_level(IO_OUTPUT_EJECTOR, 1);
-                    vTaskDelay(pdMS_TO_TICKS(700));
-                    gpio_set_level(IO_OUTPUT_EJECTOR, 0);
-                    gpio_set_level(IO_OUTPUT_LED_RED, 1);
-                    vTaskDelay(pdMS_TO_TICKS(500));
-                    gpio_set_level(IO_OUTPUT_LED_RED, 0);
-                    ESP_LOGI(TAG, "Rejected cube ejected");
-                    current_state = STATE_IDLE;
-                    break;
-
-                case STATE_WAIT_WRAP_DONE:
-                    gpio_set_level(IO_OUTPUT_WRAPPER, 1);
-                    ESP_LOGI(TAG, "Wrapper started");
-
-                    if (inputs.wrap_done) {
-                        gpio_set_level(IO_OUTPUT_WRAPPER, 0);
-                        ESP_LOGI(TAG, "Wrap sensor triggered");
-                        current_state = STATE_WRAPPING;
-                    } else {
-                        vTaskDelay(pdMS_TO_TICKS(200));
-                    }
-                    break;
-
-                case STATE_HMI_DATA_EXCHANGE: {
-                    hmi_data_t cmd;
-                    if (xQueueReceive(hmi_data_queue, &cmd, 0)) {
-                        ESP_LOGI(TAG, "HMI cmd: %s=%.2f", cmd.type, cmd.value);
-                        if (strcmp(cmd.type, "set_max_layers") == 0) {
-                            max_layers = (uint8_t)cmd.value;
-                            ESP_LOGI(TAG, "max_layers now %d", max_layers);
-                        }
-                        free(cmd.type);
-                    }
-                    current_state = STATE_IDLE;
-                    break;
-                }
-            } 
-        }   
-    }      
-}           
+        diag_queue_sample(DIAG_QUEUE_LOGIC_EVENT);
+        if (xQueueReceive(logic_event_queue, &evt, portMAX_DELAY)) {
+            int64_t start_us = esp_timer_get_time();
+
+            logic_process(&evt);
+            diag_loop_record(DIAG_LOOP_LOGIC, (uint32_t)(esp_timer_get_time() - start_us));
+        }
+    }
+}
 
 void start_logic_task(void) {
     xTaskCreatePinnedToCore(logic_task,
@@ -11,6 +11,11 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/queue.h"
+#include "io.h"
+#include "weigh_detector.h"
+#include "robot_link.h"
+#include "hmi_cmd.h"
+#include "pallet_plan.h"
 
 // Maximum number of layers on the pallet (set from the control panel)
 typedef enum {
@@ -19,16 +24,10 @@ typedef enum {
     LAYERS_10 = 10
 } pallet_layer_count_t;
 
-// Possible states of the machine
+// State of the wrap station; the build station keeps palletizing in both
 typedef enum {
-    STATE_IDLE = 0,
-    STATE_MEASURING,
-    STATE_EJECT_REJECTED,
-    STATE_READY_FOR_ROBOT,
-    STATE_WAIT_FOR_LAYER,
-    STATE_WRAPPING,
-    STATE_WAIT_WRAP_DONE,
-    STATE_HMI_DATA_EXCHANGE
+    STATE_IDLE = 0,             // wrap station free, next full pallet is handed over at once
+    STATE_WAIT_WRAP_DONE        // previous pallet being wrapped
 } system_state_t;
 
 
@@ -41,10 +40,48 @@ typedef enum {
 typedef struct {
     tcp_command_type_t type;
     float payload;  
+    int64_t origin_us;      // sensor edge that led to the command, for latency tracing; 0 if none
+    uint16_t slot;          // CMD_ROBOT_PLACE: pallet slot and its target pose
+    pallet_pose_t pose;
+    uint16_t cube_id;       // CMD_ROBOT_PLACE: reported back with the sequence number
 } tcp_command_t;
 
 extern QueueHandle_t tcp_command_queue;
 
+// Events consumed by logic_task
+typedef enum {
+    LOGIC_EVT_INPUTS = 0,       // debounced input change from io_task
+    LOGIC_EVT_WEIGH_DONE,       // settled (or timed out) weighing from adc_task
+    LOGIC_EVT_ROBOT,            // robot reply or link failure from tcp_client_task
+    LOGIC_EVT_HMI,              // operator command from the web panel
+    LOGIC_EVT_EJECTED           // ejector retracted after a reject (conveyor position action)
+} logic_event_type_t;
+
+typedef struct {
+    logic_event_type_t type;
+    union {
+        inputs_t inputs;
+        weigh_result_t weigh;
+        robot_event_t robot;
+        hmi_cmd_t hmi;
+    };
+} logic_event_t;
+
+// Queue of logic_event_t, created in app_main
+extern QueueHandle_t logic_event_queue;
+
+// Post an event to the logic task without blocking
+BaseType_t logic_post_event(const logic_event_t *evt);
+
+// Post an event, waiting up to wait ticks for room in the queue (events that must not be lost)
+BaseType_t logic_post_event_wait(const logic_event_t *evt, TickType_t wait);
+
+// Create the command queue and start from an empty line; run by logic_task before its loop
+void logic_init(void);
+
+// Handle one event: the body of the logic_task loop, callable directly by a simulation
+void logic_process(const logic_event_t *evt);
+
 // Initialization and start of the logic task
 void logic_task(void *pvParameters);
 
@@ -53,7 +90,5 @@ void logic_set_max_layers(pallet_layer_count_t layers);
 
 //start ogic task
 void start_logic_task(void);
-// Queue for passing data from io_task
-extern QueueHandle_t logic_input_queue;
 
 #endif /* MAIN_LOGIC_H_ */
\ No newline at end of file
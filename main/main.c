@@ -20,12 +20,18 @@
 #include "freertos/task.h"
 #include "freertos/queue.h"
 #include "io.h"
+#include "event_log.h"
+#include "dlog.h"
+#include "diag.h"
+#include "conveyor.h"
+#include "outputs.h"
 
-QueueHandle_t input_queue;
+QueueHandle_t logic_event_queue;
 
 void app_main(void)
 {
-		input_queue = xQueueCreate(10, sizeof(inputs_t));
+		logic_event_queue = xQueueCreate(32, sizeof(logic_event_t));
+	diag_register_queue(DIAG_QUEUE_LOGIC_EVENT, "logic_event", logic_event_queue);
     // Initialize NVS
 	esp_err_t ret = nvs_flash_init();
 	if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND)
@@ -35,8 +41,18 @@ void app_main(void)
 	}
 	ESP_ERROR_CHECK(ret);
 
+	// Deferred logging used by the control tasks
+	dlog_init();
+
+	// Production event log, before any task can record events
+	event_log_init();
+
     
     // Start tasks
+    io_init();
+    conveyor_init();
+    outputs_init();
+    start_io_task();
     adc_task_start();
     start_logic_task();
 	//eth_app_task();
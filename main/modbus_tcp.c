@@ -0,0 +1,352 @@
+/*
+ * modbus_tcp.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ */
+
+#include "modbus_tcp.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "lwip/sockets.h"
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+
+#define TAG "modbus_tcp"
+
+#define MBAP_HEADER_LEN     7       // Transaction, protocol, length, unit
+
+void modbus_tcp_init(modbus_tcp_client_t *c, const char *name, const char *ip, uint16_t port, uint8_t unit_id)
+{
+    memset(c, 0, sizeof(*c));
+    c->name = name;
+    c->addr.sin_family = AF_INET;
+    c->addr.sin_addr.s_addr = inet_addr(ip);
+    c->addr.sin_port = htons(port);
+    c->unit_id = unit_id;
+    c->sock = -1;
+    c->backoff_ms = MODBUS_TCP_BACKOFF_MIN_MS;
+    c->next_tid = 1;
+}
+
+static void modbus_tcp_complete(modbus_pending_t *p, modbus_req_status_t status, uint8_t exception,
+                                const uint16_t *regs, uint16_t count)
+{
+    p->used = false;
+    if (p->cb) {
+        p->cb(p->ctx, status, exception, regs, count);
+    }
+}
+
+static void modbus_tcp_disconnect(modbus_tcp_client_t *c, int64_t now)
+{
+    if (c->sock >= 0) {
+        close(c->sock);
+        c->sock = -1;
+    }
+    c->connected = false;
+    c->connecting = false;
+    c->rx_len = 0;
+    c->next_connect_us = now + (int64_t)c->backoff_ms * 1000;
+    c->backoff_ms = (c->backoff_ms * 2 > MODBUS_TCP_BACKOFF_MAX_MS) ? MODBUS_TCP_BACKOFF_MAX_MS : c->backoff_ms * 2;
+
+    // Answers to requests already on the wire are lost; unsent ones wait for the reconnect
+    for (int i = 0; i < MODBUS_TCP_MAX_PENDING; i++) {
+        modbus_pending_t *p = &c->pending[i];
+        if (p->used && p->sent) {
+            modbus_tcp_complete(p, MODBUS_REQ_DISCONNECTED, 0, NULL, 0);
+        }
+    }
+}
+
+static void modbus_tcp_start_connect(modbus_tcp_client_t *c, int64_t now)
+{
+    c->sock = socket(AF_INET, SOCK_STREAM, IPPROTO_IP);
+    if (c->sock < 0) {
+        ESP_LOGE(TAG, "%s: failed to create socket: errno %d", c->name, errno);
+        modbus_tcp_disconnect(c, now);
+        return;
+    }
+
+    int flags = fcntl(c->sock, F_GETFL, 0);
+    fcntl(c->sock, F_SETFL, flags | O_NONBLOCK);
+
+    int nodelay = 1;
+    setsockopt(c->sock, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+
+    if (connect(c->sock, (struct sockaddr *)&c->addr, sizeof(c->addr)) == 0) {
+        c->connected = true;
+        c->backoff_ms = MODBUS_TCP_BACKOFF_MIN_MS;
+        ESP_LOGI(TAG, "%s: connected", c->name);
+    } else if (errno == EINPROGRESS) {
+        c->connecting = true;
+        c->connect_deadline_us = now + (int64_t)MODBUS_TCP_CONNECT_TIMEOUT_MS * 1000;
+    } else {
+        ESP_LOGE(TAG, "%s: connect failed: errno %d", c->name, errno);
+        modbus_tcp_disconnect(c, now);
+    }
+}
+
+static void modbus_tcp_finish_connect(modbus_tcp_client_t *c, bool writable, int64_t now)
+{
+    if (writable) {
+        int err = 0;
+        socklen_t len = sizeof(err);
+        getsockopt(c->sock, SOL_SOCKET, SO_ERROR, &err, &len);
+        if (err == 0) {
+            c->connecting = false;
+            c->connected = true;
+            c->backoff_ms = MODBUS_TCP_BACKOFF_MIN_MS;
+            ESP_LOGI(TAG, "%s: connected", c->name);
+        } else {
+            ESP_LOGE(TAG, "%s: connect failed: errno %d", c->name, err);
+            modbus_tcp_disconnect(c, now);
+        }
+    } else if (now >= c->connect_deadline_us) {
+        ESP_LOGE(TAG, "%s: connect timeout", c->name);
+        modbus_tcp_disconnect(c, now);
+    }
+}
+
+static void modbus_tcp_send_pending(modbus_tcp_client_t *c, int64_t now)
+{
+    for (int i = 0; i < MODBUS_TCP_MAX_PENDING && c->connected; i++) {
+        modbus_pending_t *p = &c->pending[i];
+        if (!p->used || p->sent) {
+            continue;
+        }
+
+        int sent = send(c->sock, p->frame, p->frame_len, 0);
+        if (sent != p->frame_len) {
+            ESP_LOGE(TAG, "%s: send failed: errno %d", c->name, errno);
+            modbus_tcp_disconnect(c, now);
+            return;
+        }
+        p->sent = true;
+    }
+}
+
+static void modbus_tcp_handle_frame(modbus_tcp_client_t *c, const uint8_t *f, uint16_t len)
+{
+    uint16_t tid = (uint16_t)(f[0] << 8 | f[1]);
+    uint8_t fc = f[7];
+
+    modbus_pending_t *p = NULL;
+    for (int i = 0; i < MODBUS_TCP_MAX_PENDING; i++) {
+        if (c->pending[i].used && c->pending[i].sent && c->pending[i].tid == tid) {
+            p = &c->pending[i];
+            break;
+        }
+    }
+    if (p == NULL) {
+        ESP_LOGW(TAG, "%s: unexpected transaction %u (late or duplicate answer)", c->name, tid);
+        return;
+    }
+
+    if (fc == (p->fc | 0x80)) {
+        modbus_tcp_complete(p, MODBUS_REQ_EXCEPTION, len > 8 ? f[8] : 0, NULL, 0);
+        return;
+    }
+
+    if (fc != p->fc) {
+        ESP_LOGW(TAG, "%s: function mismatch in transaction %u", c->name, tid);
+        modbus_tcp_complete(p, MODBUS_REQ_EXCEPTION, 0, NULL, 0);
+        return;
+    }
+
+    if (fc == MODBUS_FC_READ_HOLDING) {
+        uint16_t regs[MODBUS_TCP_MAX_READ_REGS];
+        uint8_t bytes = len > 8 ? f[8] : 0;
+        uint16_t count = bytes / 2;
+
+        if (count != p->count || 9u + bytes > len) {
+            modbus_tcp_complete(p, MODBUS_REQ_EXCEPTION, 0, NULL, 0);
+            return;
+        }
+        for (uint16_t i = 0; i < count; i++) {
+            regs[i] = (uint16_t)(f[9 + 2 * i] << 8 | f[10 + 2 * i]);
+        }
+        modbus_tcp_complete(p, MODBUS_REQ_OK, 0, regs, count);
+    } else {
+        modbus_tcp_complete(p, MODBUS_REQ_OK, 0, NULL, 0);
+    }
+}
+
+static void modbus_tcp_receive(modbus_tcp_client_t *c, int64_t now)
+{
+    int n = recv(c->sock, c->rx + c->rx_len, sizeof(c->rx) - c->rx_len, 0);
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+        ESP_LOGW(TAG, "%s: connection closed", c->name);
+        modbus_tcp_disconnect(c, now);
+        return;
+    }
+    if (n < 0) {
+        return;
+    }
+    c->rx_len += n;
+
+    while (c->rx_len >= MBAP_HEADER_LEN + 1) {
+        uint16_t pdu_len = (uint16_t)(c->rx[4] << 8 | c->rx[5]);
+        uint16_t total = 6 + pdu_len;
+
+        if (pdu_len < 2 || total > sizeof(c->rx)) {
+            ESP_LOGE(TAG, "%s: malformed frame, resynchronising", c->name);
+            modbus_tcp_disconnect(c, now);
+            return;
+        }
+        if (c->rx_len < total) {
+            break;
+        }
+
+        modbus_tcp_handle_frame(c, c->rx, total);
+        memmove(c->rx, c->rx + total, c->rx_len - total);
+        c->rx_len -= total;
+    }
+}
+
+static void modbus_tcp_check_timeouts(modbus_tcp_client_t *c, int64_t now)
+{
+    for (int i = 0; i < MODBUS_TCP_MAX_PENDING; i++) {
+        modbus_pending_t *p = &c->pending[i];
+        if (p->used && now >= p->deadline_us) {
+            ESP_LOGW(TAG, "%s: transaction %u timed out", c->name, p->tid);
+            modbus_tcp_complete(p, MODBUS_REQ_TIMEOUT, 0, NULL, 0);
+        }
+    }
+}
+
+void modbus_tcp_poll(modbus_tcp_client_t *c, bool readable, bool writable)
+{
+    int64_t now = esp_timer_get_time();
+
+    if (!c->connected && !c->connecting && now >= c->next_connect_us) {
+        modbus_tcp_start_connect(c, now);
+    }
+    if (c->connecting) {
+        modbus_tcp_finish_connect(c, writable, now);
+    }
+    if (c->connected && readable) {
+        modbus_tcp_receive(c, now);
+    }
+    if (c->connected) {
+        modbus_tcp_send_pending(c, now);
+    }
+
+    modbus_tcp_check_timeouts(c, now);
+}
+
+static modbus_pending_t *modbus_tcp_alloc(modbus_tcp_client_t *c, uint8_t fc, uint16_t count,
+                                          uint32_t timeout_ms, modbus_tcp_cb_t cb, void *ctx)
+{
+    for (int i = 0; i < MODBUS_TCP_MAX_PENDING; i++) {
+        modbus_pending_t *p = &c->pending[i];
+        if (p->used) {
+            continue;
+        }
+
+        p->used = true;
+        p->sent = false;
+        p->tid = c->next_tid++;
+        if (c->next_tid == 0) {
+            c->next_tid = 1;
+        }
+        p->fc = fc;
+        p->count = count;
+        p->deadline_us = esp_timer_get_time() + (int64_t)timeout_ms * 1000;
+        p->cb = cb;
+        p->ctx = ctx;
+
+        // MBAP header, length is filled in by modbus_tcp_finish_frame()
+        p->frame[0] = p->tid >> 8;
+        p->frame[1] = p->tid & 0xFF;
+        p->frame[2] = 0x00;
+        p->frame[3] = 0x00;
+        p->frame[6] = c->unit_id;
+        p->frame[7] = fc;
+        p->frame_len = 8;
+        return p;
+    }
+
+    ESP_LOGW(TAG, "%s: no free request slot", c->name);
+    return NULL;
+}
+
+static void modbus_tcp_put16(modbus_pending_t *p, uint16_t v)
+{
+    p->frame[p->frame_len++] = v >> 8;
+    p->frame[p->frame_len++] = v & 0xFF;
+}
+
+static void modbus_tcp_finish_frame(modbus_pending_t *p)
+{
+    uint16_t len = p->frame_len - 6;
+    p->frame[4] = len >> 8;
+    p->frame[5] = len & 0xFF;
+}
+
+esp_err_t modbus_tcp_read_holding(modbus_tcp_client_t *c, uint16_t addr, uint16_t count,
+                                  uint32_t timeout_ms, modbus_tcp_cb_t cb, void *ctx)
+{
+    if (count == 0 || count > MODBUS_TCP_MAX_READ_REGS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    modbus_pending_t *p = modbus_tcp_alloc(c, MODBUS_FC_READ_HOLDING, count, timeout_ms, cb, ctx);
+    if (p == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    modbus_tcp_put16(p, addr);
+    modbus_tcp_put16(p, count);
+    modbus_tcp_finish_frame(p);
+    return ESP_OK;
+}
+
+esp_err_t modbus_tcp_write_single(modbus_tcp_client_t *c, uint16_t addr, uint16_t value,
+                                  uint32_t timeout_ms, modbus_tcp_cb_t cb, void *ctx)
+{
+    modbus_pending_t *p = modbus_tcp_alloc(c, MODBUS_FC_WRITE_SINGLE, 1, timeout_ms, cb, ctx);
+    if (p == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    modbus_tcp_put16(p, addr);
+    modbus_tcp_put16(p, value);
+    modbus_tcp_finish_frame(p);
+    return ESP_OK;
+}
+
+esp_err_t modbus_tcp_write_multiple(modbus_tcp_client_t *c, uint16_t addr, const uint16_t *values,
+                                    uint16_t count, uint32_t timeout_ms, modbus_tcp_cb_t cb, void *ctx)
+{
+    if (count == 0 || count > MODBUS_TCP_MAX_WRITE_REGS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    modbus_pending_t *p = modbus_tcp_alloc(c, MODBUS_FC_WRITE_MULTIPLE, count, timeout_ms, cb, ctx);
+    if (p == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    modbus_tcp_put16(p, addr);
+    modbus_tcp_put16(p, count);
+    p->frame[p->frame_len++] = (uint8_t)(count * 2);
+    for (uint16_t i = 0; i < count; i++) {
+        modbus_tcp_put16(p, values[i]);
+    }
+    modbus_tcp_finish_frame(p);
+    return ESP_OK;
+}
+
+int modbus_tcp_fd(const modbus_tcp_client_t *c)
+{
+    return (c->connected || c->connecting) ? c->sock : -1;
+}
+
+bool modbus_tcp_wants_write(const modbus_tcp_client_t *c)
+{
+    return c->connecting;
+}
+
+bool modbus_tcp_connected(const modbus_tcp_client_t *c)
+{
+    return c->connected;
+}
@@ -0,0 +1,113 @@
+/*
+ * modbus_tcp.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ *
+ * Non-blocking Modbus TCP client with a long-lived connection, several
+ * outstanding requests matched by transaction ID and per-request timeouts.
+ * The owner task drives it with select(): add the socket from
+ * modbus_tcp_fd() to the read set (and to the write set while
+ * modbus_tcp_wants_write() is true), then call modbus_tcp_poll().
+ */
+
+#ifndef MAIN_MODBUS_TCP_H_
+#define MAIN_MODBUS_TCP_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "lwip/sockets.h"
+
+#define MODBUS_TCP_MAX_PENDING      8       // Outstanding requests per connection
+#define MODBUS_TCP_MAX_READ_REGS    125     // Protocol limit for function 0x03
+#define MODBUS_TCP_MAX_WRITE_REGS   16      // Kept small so requests fit in the pending slot
+#define MODBUS_TCP_FRAME_MAX        (7 + 6 + 2 * MODBUS_TCP_MAX_WRITE_REGS)
+#define MODBUS_TCP_RX_MAX           (7 + 2 + 2 * MODBUS_TCP_MAX_READ_REGS)
+
+#define MODBUS_TCP_CONNECT_TIMEOUT_MS   1000
+#define MODBUS_TCP_BACKOFF_MIN_MS       100
+#define MODBUS_TCP_BACKOFF_MAX_MS       2000
+
+// Function codes
+#define MODBUS_FC_READ_HOLDING      0x03
+#define MODBUS_FC_WRITE_SINGLE      0x06
+#define MODBUS_FC_WRITE_MULTIPLE    0x10
+
+typedef enum {
+    MODBUS_REQ_OK = 0,
+    MODBUS_REQ_EXCEPTION,       // device answered with an exception code
+    MODBUS_REQ_TIMEOUT,
+    MODBUS_REQ_DISCONNECTED     // connection lost before the answer arrived
+} modbus_req_status_t;
+
+/**
+ * Completion callback, called from modbus_tcp_poll() in the owner task.
+ * @param regs registers read (function 0x03 only), otherwise NULL.
+ */
+typedef void (*modbus_tcp_cb_t)(void *ctx, modbus_req_status_t status, uint8_t exception,
+                                const uint16_t *regs, uint16_t count);
+
+typedef struct {
+    bool            used;
+    bool            sent;
+    uint16_t        tid;
+    uint8_t         fc;
+    uint16_t        count;
+    int64_t         deadline_us;
+    modbus_tcp_cb_t cb;
+    void           *ctx;
+    uint8_t         frame[MODBUS_TCP_FRAME_MAX];
+    uint16_t        frame_len;
+} modbus_pending_t;
+
+typedef struct {
+    const char         *name;
+    struct sockaddr_in  addr;
+    uint8_t             unit_id;
+    int                 sock;
+    bool                connecting;
+    bool                connected;
+    int64_t             connect_deadline_us;
+    int64_t             next_connect_us;
+    uint32_t            backoff_ms;
+    uint16_t            next_tid;
+    modbus_pending_t    pending[MODBUS_TCP_MAX_PENDING];
+    uint8_t             rx[MODBUS_TCP_RX_MAX];
+    uint16_t            rx_len;
+} modbus_tcp_client_t;
+
+void modbus_tcp_init(modbus_tcp_client_t *c, const char *name, const char *ip, uint16_t port, uint8_t unit_id);
+
+/**
+ * @brief Queue a request. Requests submitted while disconnected are sent
+ *        once the connection is (re)established, within their timeout.
+ * @return ESP_OK, ESP_ERR_NO_MEM if all pending slots are in use,
+ *         ESP_ERR_INVALID_ARG on a bad register count.
+ */
+esp_err_t modbus_tcp_read_holding(modbus_tcp_client_t *c, uint16_t addr, uint16_t count,
+                                  uint32_t timeout_ms, modbus_tcp_cb_t cb, void *ctx);
+esp_err_t modbus_tcp_write_single(modbus_tcp_client_t *c, uint16_t addr, uint16_t value,
+                                  uint32_t timeout_ms, modbus_tcp_cb_t cb, void *ctx);
+esp_err_t modbus_tcp_write_multiple(modbus_tcp_client_t *c, uint16_t addr, const uint16_t *values,
+                                    uint16_t count, uint32_t timeout_ms, modbus_tcp_cb_t cb, void *ctx);
+
+/**
+ * @return socket to watch with select(), or -1.
+ */
+int modbus_tcp_fd(const modbus_tcp_client_t *c);
+
+/**
+ * @return true while a non-blocking connect is in progress.
+ */
+bool modbus_tcp_wants_write(const modbus_tcp_client_t *c);
+
+bool modbus_tcp_connected(const modbus_tcp_client_t *c);
+
+/**
+ * @brief Process socket readiness, reconnects and request timeouts.
+ * @param readable / writable results of select() for modbus_tcp_fd().
+ */
+void modbus_tcp_poll(modbus_tcp_client_t *c, bool readable, bool writable);
+
+#endif /* MAIN_MODBUS_TCP_H_ */
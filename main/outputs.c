@@ -0,0 +1,154 @@
+/*
+ * outputs.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ */
+
+#include "outputs.h"
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_timer.h"
+#include "hal_io.h"
+
+typedef struct {
+    uint32_t on_ms;
+    uint32_t off_ms;
+} outputs_blink_t;
+
+typedef struct {
+    uint8_t  pattern;           // outputs_pattern_t
+    bool     phase_on;          // current half of a blink pattern
+    int64_t  phase_end_us;      // next blink edge, 0 if not blinking
+    int64_t  pulse_end_us;      // end of the active pulse, 0 if none
+} outputs_channel_t;
+
+static const outputs_blink_t blink[OUTPUTS_PATTERN_COUNT] = {
+    [OUTPUTS_BLINK_SLOW] = { 500, 500 },
+    [OUTPUTS_BLINK_FAST] = { 125, 125 },
+};
+
+static outputs_channel_t channels[IO_OUT_COUNT];
+static uint32_t managed = 0;        // channels handed to the engine; others are left alone
+static esp_timer_handle_t outputs_timer = NULL;
+static portMUX_TYPE outputs_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static bool outputs_level(const outputs_channel_t *c)
+{
+    if (c->pulse_end_us != 0) {
+        return true;
+    }
+    switch (c->pattern) {
+        case OUTPUTS_ON:
+            return true;
+        case OUTPUTS_BLINK_SLOW:
+        case OUTPUTS_BLINK_FAST:
+            return c->phase_on;
+        default:
+            return false;
+    }
+}
+
+/*
+ * Advance every channel to now, write the changed outputs in one call
+ * and re-arm the timer for the earliest next edge. Called with the lock held.
+ */
+static void outputs_update(int64_t now)
+{
+    uint32_t set = 0;
+    uint32_t clear = 0;
+    int64_t next = INT64_MAX;
+    uint32_t current = hal_io_read_outputs();
+
+    for (int ch = 0; ch < IO_OUT_COUNT; ch++) {
+        outputs_channel_t *c = &channels[ch];
+
+        if (!(managed & IO_OUT_BIT(ch))) {
+            continue;
+        }
+        if (c->pulse_end_us != 0 && now >= c->pulse_end_us) {
+            c->pulse_end_us = 0;
+        }
+        if (c->phase_end_us != 0) {
+            const outputs_blink_t *b = &blink[c->pattern];
+            // Catch up by whole phases so a late callback does not shift the pattern
+            while (now >= c->phase_end_us) {
+                c->phase_on = !c->phase_on;
+                c->phase_end_us += (int64_t)(c->phase_on ? b->on_ms : b->off_ms) * 1000;
+            }
+            if (c->phase_end_us < next) {
+                next = c->phase_end_us;
+            }
+        }
+        if (c->pulse_end_us != 0 && c->pulse_end_us < next) {
+            next = c->pulse_end_us;
+        }
+
+        bool on = outputs_level(c);
+        if (on && !(current & IO_OUT_BIT(ch))) {
+            set |= IO_OUT_BIT(ch);
+        } else if (!on && (current & IO_OUT_BIT(ch))) {
+            clear |= IO_OUT_BIT(ch);
+        }
+    }
+
+    if (set | clear) {
+        hal_io_write_outputs(set, clear);
+    }
+
+    esp_timer_stop(outputs_timer);
+    if (next != INT64_MAX) {
+        esp_timer_start_once(outputs_timer, next > now ? (uint64_t)(next - now) : 1);
+    }
+}
+
+static void outputs_timer_cb(void *arg)
+{
+    portENTER_CRITICAL(&outputs_mux);
+    outputs_update(esp_timer_get_time());
+    portEXIT_CRITICAL(&outputs_mux);
+}
+
+void outputs_set_pattern(uint8_t ch, outputs_pattern_t pattern)
+{
+    if (ch >= IO_OUT_COUNT || pattern >= OUTPUTS_PATTERN_COUNT) {
+        return;
+    }
+
+    portENTER_CRITICAL(&outputs_mux);
+    outputs_channel_t *c = &channels[ch];
+    managed |= IO_OUT_BIT(ch);
+    if (c->pattern != pattern) {
+        int64_t now = esp_timer_get_time();
+        c->pattern = (uint8_t)pattern;
+        // Blinks start with the on phase
+        c->phase_on = true;
+        c->phase_end_us = blink[pattern].on_ms ? now + (int64_t)blink[pattern].on_ms * 1000 : 0;
+        outputs_update(now);
+    }
+    portEXIT_CRITICAL(&outputs_mux);
+}
+
+void outputs_pulse(uint8_t ch, uint32_t ms)
+{
+    if (ch >= IO_OUT_COUNT) {
+        return;
+    }
+
+    portENTER_CRITICAL(&outputs_mux);
+    int64_t now = esp_timer_get_time();
+    managed |= IO_OUT_BIT(ch);
+    channels[ch].pulse_end_us = ms ? now + (int64_t)ms * 1000 : 0;
+    outputs_update(now);
+    portEXIT_CRITICAL(&outputs_mux);
+}
+
+void outputs_init(void)
+{
+    esp_timer_create_args_t args = {
+        .callback = outputs_timer_cb,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "outputs",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&args, &outputs_timer));
+}
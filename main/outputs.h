@@ -0,0 +1,45 @@
+/*
+ * outputs.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ *
+ * Timed output engine: pulses and blink patterns for the IO_OUT_*
+ * channels, run by one esp_timer that is re-armed for the next edge of
+ * any channel. Callers only state what they want and return at once;
+ * edge timing is set by the esp_timer, not by the FreeRTOS tick or
+ * the logic queue. Outputs switching at the same moment change in one
+ * HAL write. A channel belongs to the engine from its first call here;
+ * other outputs are never touched.
+ */
+
+#ifndef MAIN_OUTPUTS_H_
+#define MAIN_OUTPUTS_H_
+
+#include <stdint.h>
+
+typedef enum {
+    OUTPUTS_OFF = 0,
+    OUTPUTS_ON,
+    OUTPUTS_BLINK_SLOW,     // 1 Hz
+    OUTPUTS_BLINK_FAST,     // 4 Hz
+    OUTPUTS_PATTERN_COUNT
+} outputs_pattern_t;
+
+/**
+ * @brief Create the scheduler timer.
+ */
+void outputs_init(void);
+
+/**
+ * @brief Base pattern of a channel, shown whenever no pulse is active.
+ */
+void outputs_set_pattern(uint8_t ch, outputs_pattern_t pattern);
+
+/**
+ * @brief Switch a channel on for ms, then back to its pattern; restarts a running pulse,
+ * ms = 0 cancels it.
+ */
+void outputs_pulse(uint8_t ch, uint32_t ms);
+
+#endif /* MAIN_OUTPUTS_H_ */
@@ -0,0 +1,59 @@
+/*
+ * pallet_plan.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ */
+
+#include "pallet_plan.h"
+
+#define LONG    PALLET_BLOCK_LENGTH_MM
+#define SHORT   PALLET_BLOCK_WIDTH_MM
+
+_Static_assert(2 * LONG == PALLET_LENGTH_MM && 4 * SHORT == PALLET_WIDTH_MM,
+               "layout A must fill the pallet");
+_Static_assert(6 * SHORT == PALLET_LENGTH_MM && LONG + SHORT == PALLET_WIDTH_MM,
+               "layout B must fill the pallet");
+
+// Centres and rotation within one layer, placing order from the far edge
+static const pallet_pose_t layout_a[PALLET_CUBES_PER_LAYER] = {
+    { LONG / 2,        SHORT / 2,             0, 0 },
+    { LONG + LONG / 2, SHORT / 2,             0, 0 },
+    { LONG / 2,        SHORT + SHORT / 2,     0, 0 },
+    { LONG + LONG / 2, SHORT + SHORT / 2,     0, 0 },
+    { LONG / 2,        2 * SHORT + SHORT / 2, 0, 0 },
+    { LONG + LONG / 2, 2 * SHORT + SHORT / 2, 0, 0 },
+    { LONG / 2,        3 * SHORT + SHORT / 2, 0, 0 },
+    { LONG + LONG / 2, 3 * SHORT + SHORT / 2, 0, 0 },
+};
+
+static const pallet_pose_t layout_b[PALLET_CUBES_PER_LAYER] = {
+    { SHORT / 2,             LONG / 2,         0, 90 },
+    { SHORT + SHORT / 2,     LONG / 2,         0, 90 },
+    { 2 * SHORT + SHORT / 2, LONG / 2,         0, 90 },
+    { 3 * SHORT + SHORT / 2, LONG / 2,         0, 90 },
+    { 4 * SHORT + SHORT / 2, LONG / 2,         0, 90 },
+    { 5 * SHORT + SHORT / 2, LONG / 2,         0, 90 },
+    { LONG / 2,              LONG + SHORT / 2, 0, 0 },
+    { LONG + LONG / 2,       LONG + SHORT / 2, 0, 0 },
+};
+
+static pallet_pose_t slots[PALLET_PLAN_SLOTS];
+
+void pallet_plan_init(void)
+{
+    for (uint16_t layer = 0; layer < PALLET_PLAN_MAX_LAYERS; layer++) {
+        const pallet_pose_t *layout = (layer & 1) ? layout_b : layout_a;
+
+        for (uint16_t i = 0; i < PALLET_CUBES_PER_LAYER; i++) {
+            pallet_pose_t *p = &slots[layer * PALLET_CUBES_PER_LAYER + i];
+            *p = layout[i];
+            p->z_mm = (int16_t)(layer * PALLET_BLOCK_HEIGHT_MM);
+        }
+    }
+}
+
+const pallet_pose_t *pallet_plan_slot(uint16_t slot)
+{
+    return &slots[slot < PALLET_PLAN_SLOTS ? slot : PALLET_PLAN_SLOTS - 1];
+}
@@ -0,0 +1,56 @@
+/*
+ * pallet_plan.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ *
+ * Stacking pattern of 600x200x300 mm blocks on a 1200x800 mm Euro pallet,
+ * 8 blocks per layer in alternating layouts:
+ *   A (even layers): 2 x 4 blocks lengthwise along the pallet
+ *   B (odd layers):  6 blocks crosswise over y 0..600 and 2 lengthwise
+ *                    along the y 600..800 edge, covering the A joints
+ * The slot table for the highest supported stack is built once by
+ * pallet_plan_init(); a stack of n layers uses its first n * 8 slots.
+ */
+
+#ifndef MAIN_PALLET_PLAN_H_
+#define MAIN_PALLET_PLAN_H_
+
+#include <stdint.h>
+
+#define PALLET_LENGTH_MM            1200    // x
+#define PALLET_WIDTH_MM             800     // y
+#define PALLET_BLOCK_LENGTH_MM      600
+#define PALLET_BLOCK_WIDTH_MM       200
+#define PALLET_BLOCK_HEIGHT_MM      300
+#define PALLET_CUBES_PER_LAYER      8
+#define PALLET_PLAN_MAX_LAYERS      20
+#define PALLET_PLAN_SLOTS           (PALLET_PLAN_MAX_LAYERS * PALLET_CUBES_PER_LAYER)
+
+// Target pose of one block in the pallet frame (origin at a deck corner)
+typedef struct {
+    int16_t  x_mm;          // block centre
+    int16_t  y_mm;
+    int16_t  z_mm;          // underside of the block above the deck
+    uint16_t rot_deg;       // 0: long side along x, 90: along y
+} pallet_pose_t;
+
+/**
+ * @brief Build the slot table.
+ */
+void pallet_plan_init(void);
+
+/**
+ * @brief Pose of a slot; slot must be below PALLET_PLAN_SLOTS.
+ */
+const pallet_pose_t *pallet_plan_slot(uint16_t slot);
+
+/**
+ * @brief Number of slots of a stack with the given number of layers.
+ */
+static inline uint16_t pallet_plan_slots(uint8_t layers)
+{
+    return (uint16_t)layers * PALLET_CUBES_PER_LAYER;
+}
+
+#endif /* MAIN_PALLET_PLAN_H_ */
@@ -0,0 +1,306 @@
+/*
+ * robot_link.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ */
+
+#include "robot_link.h"
+#include "logic.h"
+#include "trace.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "lwip/sockets.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+
+#define TAG "robot_link"
+
+typedef struct {
+    bool     used;
+    bool     sent;
+    bool     acked;
+    uint16_t seq;
+    int64_t  deadline_us;
+    int64_t  origin_us;     // for latency tracing, 0 if not traced
+    char     line[ROBOT_LINK_LINE_MAX];
+    uint16_t len;
+} robot_pending_t;
+
+static struct sockaddr_in robot_addr;
+static int sock = -1;
+static bool connecting = false;
+static bool connected = false;
+static int64_t connect_deadline_us = 0;
+static int64_t next_connect_us = 0;
+static uint32_t backoff_ms = ROBOT_LINK_BACKOFF_MIN_MS;
+static uint16_t next_seq = 1;
+static robot_pending_t pending[ROBOT_LINK_MAX_PENDING];
+static char rx[ROBOT_LINK_LINE_MAX * 2];
+static uint16_t rx_len = 0;
+
+static void robot_link_report(robot_pending_t *p, robot_reply_t reply)
+{
+    logic_event_t evt = {
+        .type = LOGIC_EVT_ROBOT,
+        .robot = { .seq = p->seq, .reply = reply },
+    };
+
+    if (reply != ROBOT_REPLY_ACK) {
+        p->used = false;
+    }
+    // Logic never waits for this task, so blocking here cannot deadlock
+    logic_post_event_wait(&evt, portMAX_DELAY);
+}
+
+static void robot_link_disconnect(int64_t now)
+{
+    if (sock >= 0) {
+        close(sock);
+        sock = -1;
+    }
+    connected = false;
+    connecting = false;
+    rx_len = 0;
+    next_connect_us = now + (int64_t)backoff_ms * 1000;
+    backoff_ms = (backoff_ms * 2 > ROBOT_LINK_BACKOFF_MAX_MS) ? ROBOT_LINK_BACKOFF_MAX_MS : backoff_ms * 2;
+
+    // The robot may or may not have received these, let the logic decide
+    for (int i = 0; i < ROBOT_LINK_MAX_PENDING; i++) {
+        if (pending[i].used && pending[i].sent) {
+            robot_link_report(&pending[i], ROBOT_REPLY_DISCONNECTED);
+        }
+    }
+}
+
+static void robot_link_connected_ok(void)
+{
+    connecting = false;
+    connected = true;
+    backoff_ms = ROBOT_LINK_BACKOFF_MIN_MS;
+    ESP_LOGI(TAG, "Connected to robot");
+}
+
+static void robot_link_start_connect(int64_t now)
+{
+    sock = socket(AF_INET, SOCK_STREAM, IPPROTO_IP);
+    if (sock < 0) {
+        ESP_LOGE(TAG, "Failed to create socket: errno %d", errno);
+        robot_link_disconnect(now);
+        return;
+    }
+
+    int flags = fcntl(sock, F_GETFL, 0);
+    fcntl(sock, F_SETFL, flags | O_NONBLOCK);
+
+    int nodelay = 1;
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+
+    if (connect(sock, (struct sockaddr *)&robot_addr, sizeof(robot_addr)) == 0) {
+        robot_link_connected_ok();
+    } else if (errno == EINPROGRESS) {
+        connecting = true;
+        connect_deadline_us = now + (int64_t)ROBOT_LINK_CONNECT_TIMEOUT_MS * 1000;
+    } else {
+        ESP_LOGE(TAG, "Connection to robot failed: errno %d", errno);
+        robot_link_disconnect(now);
+    }
+}
+
+static void robot_link_finish_connect(bool writable, int64_t now)
+{
+    if (writable) {
+        int err = 0;
+        socklen_t len = sizeof(err);
+        getsockopt(sock, SOL_SOCKET, SO_ERROR, &err, &len);
+        if (err == 0) {
+            robot_link_connected_ok();
+        } else {
+            ESP_LOGE(TAG, "Connection to robot failed: errno %d", err);
+            robot_link_disconnect(now);
+        }
+    } else if (now >= connect_deadline_us) {
+        ESP_LOGE(TAG, "Connection to robot timed out");
+        robot_link_disconnect(now);
+    }
+}
+
+static void robot_link_send_pending(int64_t now)
+{
+    for (int i = 0; i < ROBOT_LINK_MAX_PENDING && connected; i++) {
+        robot_pending_t *p = &pending[i];
+        if (!p->used || p->sent) {
+            continue;
+        }
+
+        int sent = send(sock, p->line, p->len, 0);
+        if (sent != p->len) {
+            ESP_LOGE(TAG, "Send to robot failed: errno %d", errno);
+            robot_link_disconnect(now);
+            return;
+        }
+        p->sent = true;
+        trace_record(TRACE_PLACE_SEND, p->origin_us);
+        p->deadline_us = now + (int64_t)ROBOT_LINK_ACK_TIMEOUT_MS * 1000;
+        ESP_LOGI(TAG, "Command #%u sent to robot", p->seq);
+    }
+}
+
+static void robot_link_handle_line(char *line, int64_t now)
+{
+    char *end = NULL;
+    unsigned long seq = strtoul(line, &end, 10);
+    if (end == line || *end != ' ') {
+        ESP_LOGW(TAG, "Malformed reply: %s", line);
+        return;
+    }
+    const char *word = end + 1;
+
+    robot_pending_t *p = NULL;
+    for (int i = 0; i < ROBOT_LINK_MAX_PENDING; i++) {
+        if (pending[i].used && pending[i].sent && pending[i].seq == seq) {
+            p = &pending[i];
+            break;
+        }
+    }
+    if (p == NULL) {
+        ESP_LOGW(TAG, "Reply for unknown command #%lu", seq);
+        return;
+    }
+
+    if (strncmp(word, "ACK", 3) == 0) {
+        p->acked = true;
+        p->deadline_us = now + (int64_t)ROBOT_LINK_DONE_TIMEOUT_MS * 1000;
+        robot_link_report(p, ROBOT_REPLY_ACK);
+    } else if (strncmp(word, "DONE", 4) == 0) {
+        robot_link_report(p, ROBOT_REPLY_DONE);
+    } else if (strncmp(word, "ERROR", 5) == 0) {
+        ESP_LOGE(TAG, "Robot rejected #%u: %s", p->seq, word);
+        robot_link_report(p, ROBOT_REPLY_ERROR);
+    } else {
+        ESP_LOGW(TAG, "Unknown reply: %s", line);
+    }
+}
+
+static void robot_link_receive(int64_t now)
+{
+    int n = recv(sock, rx + rx_len, sizeof(rx) - 1 - rx_len, 0);
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+        ESP_LOGW(TAG, "Robot closed the connection");
+        robot_link_disconnect(now);
+        return;
+    }
+    if (n < 0) {
+        return;
+    }
+    rx_len += n;
+    rx[rx_len] = '\0';
+
+    char *start = rx;
+    char *nl;
+    while ((nl = strchr(start, '\n')) != NULL) {
+        *nl = '\0';
+        if (nl > start && nl[-1] == '\r') {
+            nl[-1] = '\0';
+        }
+        robot_link_handle_line(start, now);
+        start = nl + 1;
+    }
+
+    rx_len -= (uint16_t)(start - rx);
+    memmove(rx, start, rx_len);
+
+    if (rx_len >= sizeof(rx) - 1) {
+        ESP_LOGE(TAG, "Reply line too long, discarding");
+        rx_len = 0;
+    }
+}
+
+static void robot_link_check_timeouts(int64_t now)
+{
+    for (int i = 0; i < ROBOT_LINK_MAX_PENDING; i++) {
+        robot_pending_t *p = &pending[i];
+        if (p->used && now >= p->deadline_us) {
+            ESP_LOGE(TAG, "Command #%u: no %s from robot", p->seq, p->acked ? "DONE" : "ACK");
+            robot_link_report(p, ROBOT_REPLY_TIMEOUT);
+        }
+    }
+}
+
+void robot_link_init(const char *ip, uint16_t port)
+{
+    memset(&robot_addr, 0, sizeof(robot_addr));
+    robot_addr.sin_family = AF_INET;
+    robot_addr.sin_addr.s_addr = inet_addr(ip);
+    robot_addr.sin_port = htons(port);
+}
+
+esp_err_t robot_link_send(const char *command, int64_t origin_us, uint16_t *seq)
+{
+    for (int i = 0; i < ROBOT_LINK_MAX_PENDING; i++) {
+        robot_pending_t *p = &pending[i];
+        if (p->used) {
+            continue;
+        }
+
+        int len = snprintf(p->line, sizeof(p->line), "%u %s\n", next_seq, command);
+        if (len < 0 || len >= (int)sizeof(p->line)) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+
+        p->used = true;
+        p->sent = false;
+        p->acked = false;
+        p->seq = next_seq;
+        p->len = (uint16_t)len;
+        p->origin_us = origin_us;
+        // Unsent commands wait for the link at most this long
+        p->deadline_us = esp_timer_get_time() + (int64_t)ROBOT_LINK_DONE_TIMEOUT_MS * 1000;
+
+        if (seq != NULL) {
+            *seq = next_seq;
+        }
+        next_seq = (next_seq == UINT16_MAX) ? 1 : next_seq + 1;
+        return ESP_OK;
+    }
+
+    return ESP_ERR_NO_MEM;
+}
+
+int robot_link_fd(void)
+{
+    return (connected || connecting) ? sock : -1;
+}
+
+bool robot_link_wants_write(void)
+{
+    return connecting;
+}
+
+bool robot_link_connected(void)
+{
+    return connected;
+}
+
+void robot_link_poll(bool readable, bool writable)
+{
+    int64_t now = esp_timer_get_time();
+
+    if (!connected && !connecting && now >= next_connect_us) {
+        robot_link_start_connect(now);
+    }
+    if (connecting) {
+        robot_link_finish_connect(writable, now);
+    }
+    if (connected && readable) {
+        robot_link_receive(now);
+    }
+    if (connected) {
+        robot_link_send_pending(now);
+    }
+
+    robot_link_check_timeouts(now);
+}
@@ -0,0 +1,68 @@
+/*
+ * robot_link.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ *
+ * Persistent, non-blocking text link to the robot controller.
+ *
+ * Commands are sent as "<seq> <COMMAND>\n", the robot answers every
+ * command with "<seq> ACK" when it accepts the job, "<seq> DONE" when the
+ * cube is placed, or "<seq> ERROR <reason>". Replies are forwarded to the
+ * logic task as LOGIC_EVT_ROBOT events; the post waits for room in the
+ * queue, a lost reply would leave its cube assigned to the robot. The link is driven by the TCP
+ * client task through select(), like modbus_tcp.
+ */
+
+#ifndef MAIN_ROBOT_LINK_H_
+#define MAIN_ROBOT_LINK_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#define ROBOT_LINK_MAX_PENDING          4
+#define ROBOT_LINK_LINE_MAX             96
+#define ROBOT_LINK_ACK_TIMEOUT_MS       1000
+#define ROBOT_LINK_DONE_TIMEOUT_MS      30000
+#define ROBOT_LINK_CONNECT_TIMEOUT_MS   1000
+#define ROBOT_LINK_BACKOFF_MIN_MS       100
+#define ROBOT_LINK_BACKOFF_MAX_MS       2000
+
+typedef enum {
+    ROBOT_REPLY_ACK = 0,
+    ROBOT_REPLY_DONE,
+    ROBOT_REPLY_ERROR,
+    ROBOT_REPLY_TIMEOUT,        // no ACK/DONE within the deadline
+    ROBOT_REPLY_DISCONNECTED,   // link lost with the command outstanding
+    ROBOT_REPLY_QUEUED,         // not from the robot: the command for cube_id got seq on the link
+    ROBOT_REPLY_NOT_SENT        // not from the robot: no room on the link for the command for cube_id
+} robot_reply_t;
+
+typedef struct {
+    uint16_t      seq;
+    robot_reply_t reply;
+    uint16_t      cube_id;      // ROBOT_REPLY_QUEUED and ROBOT_REPLY_NOT_SENT only
+} robot_event_t;
+
+void robot_link_init(const char *ip, uint16_t port);
+
+/**
+ * @brief Queue a command line (without sequence number and newline).
+ * @param origin_us sensor edge the command answers, traced when the line is sent; 0 if none.
+ * @param[out] seq sequence number assigned to the command, may be NULL.
+ * @return ESP_OK, ESP_ERR_NO_MEM if too many commands are outstanding,
+ *         ESP_ERR_INVALID_SIZE if the line does not fit.
+ */
+esp_err_t robot_link_send(const char *command, int64_t origin_us, uint16_t *seq);
+
+int robot_link_fd(void);
+bool robot_link_wants_write(void);
+bool robot_link_connected(void);
+
+/**
+ * @brief Process socket readiness, reconnects and command timeouts.
+ */
+void robot_link_poll(bool readable, bool writable);
+
+#endif /* MAIN_ROBOT_LINK_H_ */
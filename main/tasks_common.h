@@ -15,13 +15,17 @@
 #define ETH_APP_TASK_CORE_ID				0
 
 #define TCP_CLIENT_TASK_STACK_SIZE			4096
-#define TCP_CLIENT_TASK_PRIORITY			6
-#define TCP_CLIENT_TASK_CORE_ID				0
+#define TCP_CLIENT_TASK_PRIORITY			5
+#define TCP_CLIENT_TASK_CORE_ID				tskNO_AFFINITY
 
 #define LOGIC_TASK_STACK_SIZE				4096
 #define LOGIC_TASK_PRIORITY					8
 #define LOGIC_TASK_CORE_ID					0
 
+#define IO_TASK_STACK_SIZE					3072
+#define IO_TASK_PRIORITY					9
+#define IO_TASK_CORE_ID						0
+
 #define ADC_TASK_STACK_SIZE					4096
 #define ADC_TASK_PRIORITY					10
 #define ADC_TASK_CORE_ID					0
@@ -41,5 +45,20 @@
 #define HTTP_SERVER_MONITOR_PRIORITY		3
 #define HTTP_SERVER_MONITOR_CORE_ID			1
 
+// HTTP Server WebSocket push task
+#define HTTP_SERVER_WS_PUSH_STACK_SIZE		4096
+#define HTTP_SERVER_WS_PUSH_PRIORITY		3
+#define HTTP_SERVER_WS_PUSH_CORE_ID			1
+
+// Event log flush task
+#define EVENT_LOG_TASK_STACK_SIZE			3072
+#define EVENT_LOG_TASK_PRIORITY				2
+#define EVENT_LOG_TASK_CORE_ID				1
+
+// Deferred log output task
+#define DLOG_TASK_STACK_SIZE				3072
+#define DLOG_TASK_PRIORITY					1
+#define DLOG_TASK_CORE_ID					1
+
 #endif /* MAIN_TASKS_COMMON_H_ */
 
@@ -4,6 +4,8 @@
  * Features:
  * - Dedicated task for TCP communications
  * - Device-specific protocol implementations
+ * - Persistent Modbus TCP connection to the inverter (modbus_tcp.c)
+ * - Persistent robot link with acknowledged commands (robot_link.c)
  * - Automatic reconnection handling
  * - Command queuing system
  *
@@ -12,141 +14,162 @@
  */
 
 #include "tcp.h"
+#include "tasks_common.h"
+#include "modbus_tcp.h"
+#include "robot_link.h"
+#include "line_status.h"
+#include "event_log.h"
+#include "dlog.h"
+#include "diag.h"
+#include "trace.h"
 #include "esp_log.h"
 #include "lwip/sockets.h"
 #include "lwip/netdb.h"
+#include <stdio.h>
 #include <string.h>
 #include <errno.h>
 
 #define TAG "TCP_CLIENT"
 
-// Device connection parameters
+// Device connection parameters; the host build points them at the stand-in servers
+#ifndef ROBOT_IP
 #define ROBOT_IP "192.168.1.100"   // Robot controller IP
 #define ROBOT_PORT 5020             // Robot controller port
+#endif
+#ifndef INVERTER_IP
 #define INVERTER_IP "192.168.1.101" // Delta inverter IP
 #define INVERTER_PORT 502           // Modbus TCP port (standard)
+#endif
 
 // Delta inverter Modbus commands
 #define DELTA_INVERTER_ADDRESS 0x01
-#define DELTA_START_COMMAND 0x06    // Write single register
 #define DELTA_START_REGISTER 0x2000 // Example start control register
+#define DELTA_START_VALUE 0x0001    // 1 = start
+#define DELTA_REQUEST_TIMEOUT_MS 500
 
-static void tcp_client_task(void *pvParameters) {
-    struct sockaddr_in robot_addr = {
-        .sin_addr.s_addr = inet_addr(ROBOT_IP),
-        .sin_family = AF_INET,
-        .sin_port = htons(ROBOT_PORT)
-    };
-    
-    struct sockaddr_in inverter_addr = {
-        .sin_addr.s_addr = inet_addr(INVERTER_IP),
-        .sin_family = AF_INET,
-        .sin_port = htons(INVERTER_PORT)
+#define TCP_POLL_INTERVAL_MS 10     // select() timeout, bounds command pick-up latency
+
+static modbus_tcp_client_t inverter;
+
+static void tcp_inverter_start_done(void *ctx, modbus_req_status_t status, uint8_t exception,
+                                    const uint16_t *regs, uint16_t count)
+{
+    if (status != MODBUS_REQ_OK) {
+        event_log_add(EVENT_LOG_INVERTER_FAULT, 0, (int32_t)status << 8 | exception, EVENT_LOG_STATE_NONE);
+    }
+
+    switch (status) {
+        case MODBUS_REQ_OK:
+            DLOGI(TAG, "Inverter start acknowledged");
+            break;
+        case MODBUS_REQ_EXCEPTION:
+            DLOGE(TAG, "Inverter start rejected, exception 0x%02" PRIx32, exception);
+            break;
+        case MODBUS_REQ_TIMEOUT:
+            DLOGE(TAG, "Inverter start timed out");
+            break;
+        case MODBUS_REQ_DISCONNECTED:
+            DLOGE(TAG, "Inverter connection lost during start");
+            break;
+    }
+}
+
+/**
+ * Tell logic what became of a PLACE_CUBE: replies only carry the sequence
+ * number, and a command that never reached the link gets no reply at all.
+ */
+static void tcp_report_robot(uint16_t cube_id, uint16_t seq, robot_reply_t reply)
+{
+    logic_event_t evt = {
+        .type = LOGIC_EVT_ROBOT,
+        .robot = { .seq = seq, .reply = reply, .cube_id = cube_id },
     };
+    logic_post_event_wait(&evt, portMAX_DELAY);
+}
 
-    while (1) {
-        tcp_command_t cmd;
-        if (xQueueReceive(tcp_command_queue, &cmd, pdMS_TO_TICKS(1000))) {
-            int sock = -1;
-            int addr_family = AF_INET;
-            int ip_protocol = IPPROTO_IP;
-            
-            // Select appropriate device
-            struct sockaddr_in *dest_addr = NULL;
-            const char *device_type = "";
-            
-            if (cmd.type == CMD_ROBOT_PLACE) {
-                dest_addr = &robot_addr;
-                device_type = "robot";
-            } else if (cmd.type == CMD_INVERTER_START) {
-                dest_addr = &inverter_addr;
-                device_type = "inverter";
-            } else {
-                continue;  // Unknown command type
+static void tcp_handle_command(const tcp_command_t *cmd) {
+    switch (cmd->type) {
+        case CMD_ROBOT_PLACE: {
+            uint16_t seq = 0;
+            char line[ROBOT_LINK_LINE_MAX];
+            trace_record(TRACE_PLACE_HANDOFF, cmd->origin_us);
+            // PLACE_CUBE <slot> <x mm> <y mm> <z mm> <rotation deg>
+            snprintf(line, sizeof(line), "PLACE_CUBE %u %d %d %d %u", cmd->slot,
+                     cmd->pose.x_mm, cmd->pose.y_mm, cmd->pose.z_mm, cmd->pose.rot_deg);
+            if (robot_link_send(line, cmd->origin_us, &seq) != ESP_OK) {
+                DLOGE(TAG, "Robot command queue full");
+                tcp_report_robot(cmd->cube_id, 0, ROBOT_REPLY_NOT_SENT);
+                break;
             }
-            
-            // Create socket
-            sock = socket(addr_family, SOCK_STREAM, ip_protocol);
-            if (sock < 0) {
-                ESP_LOGE(TAG, "Failed to create socket: errno %d", errno);
-                continue;
+            DLOGI(TAG, "PLACE_CUBE slot %" PRIu32 " queued as #%" PRIu32, cmd->slot, seq);
+            tcp_report_robot(cmd->cube_id, seq, ROBOT_REPLY_QUEUED);
+            break;
+        }
+
+        case CMD_INVERTER_START:
+            if (modbus_tcp_write_single(&inverter, DELTA_START_REGISTER, DELTA_START_VALUE,
+                                        DELTA_REQUEST_TIMEOUT_MS, tcp_inverter_start_done, NULL) != ESP_OK) {
+                DLOGE(TAG, "Inverter request queue full");
             }
-            
-            // Connect to device
-            if (connect(sock, (struct sockaddr *)dest_addr, sizeof(*dest_addr)) != 0) {
-                ESP_LOGE(TAG, "Connection to %s failed: errno %d", device_type, errno);
-                close(sock);
-                vTaskDelay(pdMS_TO_TICKS(1000));  // Wait before retrying
-                continue;
+            break;
+
+        case CMD_NONE:
+            DLOGI(TAG, "Nothing to send");
+            break;
+    }
+}
+
+static void tcp_client_task(void *pvParameters) {
+    robot_link_init(ROBOT_IP, ROBOT_PORT);
+    modbus_tcp_init(&inverter, "inverter", INVERTER_IP, INVERTER_PORT, DELTA_INVERTER_ADDRESS);
+
+    while (1) {
+        tcp_command_t cmd;
+        diag_queue_sample(DIAG_QUEUE_TCP_COMMAND);
+        while (tcp_command_queue != NULL && xQueueReceive(tcp_command_queue, &cmd, 0)) {
+            tcp_handle_command(&cmd);
+        }
+
+        fd_set rfds, wfds;
+        FD_ZERO(&rfds);
+        FD_ZERO(&wfds);
+        int maxfd = -1;
+
+        int inverter_fd = modbus_tcp_fd(&inverter);
+        if (inverter_fd >= 0) {
+            FD_SET(inverter_fd, &rfds);
+            if (modbus_tcp_wants_write(&inverter)) {
+                FD_SET(inverter_fd, &wfds);
             }
-            
-            ESP_LOGI(TAG, "Connected to %s", device_type);
-            
-            // Device-specific command formatting
-            uint8_t buffer[128];
-            int len = 0;
-            
-            switch (cmd.type) {
-                case CMD_ROBOT_PLACE:
-                    // Format: "PLACE_CUBE\n" (simple text protocol)
-                    len = snprintf((char *)buffer, sizeof(buffer), "PLACE_CUBE\n");
-                    break;
-                    
-                case CMD_INVERTER_START:
-                    // Format: Modbus TCP frame for Delta inverter
-                    // Transaction ID (arbitrary)
-                    buffer[0] = 0x00;
-                    buffer[1] = 0x01;
-                    
-                    // Protocol ID (0 for Modbus)
-                    buffer[2] = 0x00;
-                    buffer[3] = 0x00;
-                    
-                    // Length (remaining bytes)
-                    buffer[4] = 0x00;
-                    buffer[5] = 0x06;
-                    
-                    // Unit ID
-                    buffer[6] = DELTA_INVERTER_ADDRESS;
-                    
-                    // Function code (Write Single Register)
-                    buffer[7] = DELTA_START_COMMAND;
-                    
-                    // Register address
-                    buffer[8] = (DELTA_START_REGISTER >> 8) & 0xFF;
-                    buffer[9] = DELTA_START_REGISTER & 0xFF;
-                    
-                    // Start command value (1 = start)
-                    buffer[10] = 0x00;
-                    buffer[11] = 0x01;
-                    
-                    len = 12;
-                    break;
-                    
-                    case CMD_NONE:
-                    ESP_LOGI(TAG, "Nothing to send");
-                    break;
+            maxfd = inverter_fd;
+        }
+
+        int robot_fd = robot_link_fd();
+        if (robot_fd >= 0) {
+            FD_SET(robot_fd, &rfds);
+            if (robot_link_wants_write()) {
+                FD_SET(robot_fd, &wfds);
             }
-            
-            // Send command
-            int err = send(sock, buffer, len, 0);
-            if (err < 0) {
-                ESP_LOGE(TAG, "Send to %s failed: errno %d", device_type, errno);
-            } else {
-                ESP_LOGI(TAG, "Command sent to %s (%d bytes)", device_type, err);
-                
-                // For Modbus, wait for response
-                if (cmd.type == CMD_INVERTER_START) {
-                    uint8_t response[256];
-                    int received = recv(sock, response, sizeof(response) - 1, 0);
-                    if (received > 0) {
-                        ESP_LOGI(TAG, "Inverter response received (%d bytes)", received);
-                    }
-                }
+            if (robot_fd > maxfd) {
+                maxfd = robot_fd;
             }
-            
-            close(sock);
         }
+
+        int ready = 0;
+        if (maxfd >= 0) {
+            struct timeval tv = { .tv_sec = 0, .tv_usec = TCP_POLL_INTERVAL_MS * 1000 };
+            ready = select(maxfd + 1, &rfds, &wfds, NULL, &tv);
+        } else {
+            vTaskDelay(pdMS_TO_TICKS(TCP_POLL_INTERVAL_MS));
+        }
+
+        robot_link_poll(ready > 0 && robot_fd >= 0 && FD_ISSET(robot_fd, &rfds),
+                        ready > 0 && robot_fd >= 0 && FD_ISSET(robot_fd, &wfds));
+        modbus_tcp_poll(&inverter,
+                        ready > 0 && inverter_fd >= 0 && FD_ISSET(inverter_fd, &rfds),
+                        ready > 0 && inverter_fd >= 0 && FD_ISSET(inverter_fd, &wfds));
+
+        line_status_set_links(robot_link_connected(), modbus_tcp_connected(&inverter));
     }
 }
 
@@ -0,0 +1,107 @@
+/*
+ * throughput.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ */
+
+#include "throughput.h"
+#include "esp_timer.h"
+
+#define MINUTE_MS   60000
+
+typedef enum {
+    RATE_IN = 0,
+    RATE_PLACED,
+    RATE_REJECTED,
+    RATE_COUNT
+} throughput_rate_t;
+
+typedef struct {
+    uint32_t minute;            // minutes since boot this bucket holds
+    uint32_t count[RATE_COUNT];
+} throughput_bucket_t;
+
+static uint32_t totals[EVENT_LOG_TYPE_COUNT];
+static throughput_bucket_t window[THROUGHPUT_WINDOW_MIN];
+
+static const char *const rate_names[RATE_COUNT] = {
+    [RATE_IN]       = "inPerHour",
+    [RATE_PLACED]   = "placedPerHour",
+    [RATE_REJECTED] = "rejectedPerHour",
+};
+
+static uint32_t throughput_now_ms(void)
+{
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+void throughput_count(event_log_type_t type)
+{
+    throughput_rate_t rate;
+
+    if (type >= EVENT_LOG_TYPE_COUNT) {
+        return;
+    }
+    totals[type]++;
+
+    switch (type) {
+        case EVENT_LOG_CUBE_IN:  rate = RATE_IN;       break;
+        case EVENT_LOG_PLACED:   rate = RATE_PLACED;   break;
+        case EVENT_LOG_REJECT:
+        case EVENT_LOG_UNSTABLE: rate = RATE_REJECTED; break;
+        default:
+            return;
+    }
+
+    uint32_t minute = throughput_now_ms() / MINUTE_MS;
+    throughput_bucket_t *b = &window[minute % THROUGHPUT_WINDOW_MIN];
+    if (b->minute != minute) {
+        b->count[RATE_IN] = 0;
+        b->count[RATE_PLACED] = 0;
+        b->count[RATE_REJECTED] = 0;
+        b->minute = minute;
+    }
+    b->count[rate]++;
+}
+
+void throughput_write_json(json_writer_t *w, const char *key)
+{
+    uint32_t now_ms = throughput_now_ms();
+    uint32_t minute = now_ms / MINUTE_MS;
+    uint32_t sums[RATE_COUNT] = { 0 };
+
+    for (int i = 0; i < THROUGHPUT_WINDOW_MIN; i++) {
+        const throughput_bucket_t *b = &window[i];
+        if (b->minute + THROUGHPUT_WINDOW_MIN > minute && b->minute <= minute) {
+            for (int r = 0; r < RATE_COUNT; r++) {
+                sums[r] += b->count[r];
+            }
+        }
+    }
+
+    // Full minutes in the window plus the current partial one, less right after boot
+    uint32_t span_ms = (THROUGHPUT_WINDOW_MIN - 1) * MINUTE_MS + now_ms % MINUTE_MS;
+    if (span_ms > now_ms) {
+        span_ms = now_ms;
+    }
+
+    json_writer_object_begin(w, key);
+    json_writer_object_begin(w, "totals");
+    for (int t = 0; t < EVENT_LOG_TYPE_COUNT; t++) {
+        if (t != EVENT_LOG_BOOT) {
+            json_writer_uint(w, event_log_type_name(t), totals[t]);
+        }
+    }
+    json_writer_object_end(w);
+
+    for (int r = 0; r < RATE_COUNT; r++) {
+        json_writer_uint(w, rate_names[r], span_ms ? (uint64_t)sums[r] * 3600000u / span_ms : 0);
+    }
+
+    // Share of weighed cubes rejected, percent with one decimal
+    uint32_t weighed = totals[EVENT_LOG_ACCEPT] + totals[EVENT_LOG_REJECT] + totals[EVENT_LOG_UNSTABLE];
+    uint32_t rejected = totals[EVENT_LOG_REJECT] + totals[EVENT_LOG_UNSTABLE];
+    json_writer_fixed(w, "rejectRate", weighed ? (int32_t)((uint64_t)rejected * 1000 / weighed) : 0, 1);
+    json_writer_object_end(w);
+}
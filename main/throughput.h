@@ -0,0 +1,32 @@
+/*
+ * throughput.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ *
+ * Line throughput counters fed from the logic task's production events:
+ * totals per event type since boot and hourly rates over a sliding
+ * 60-minute window of one-minute buckets. Together with the latency
+ * trace this is the benchmark for performance changes on the real line.
+ */
+
+#ifndef MAIN_THROUGHPUT_H_
+#define MAIN_THROUGHPUT_H_
+
+#include <stdint.h>
+#include "event_log.h"
+#include "json_writer.h"
+
+#define THROUGHPUT_WINDOW_MIN   60
+
+/**
+ * @brief Count one production event; called from the logic task only.
+ */
+void throughput_count(event_log_type_t type);
+
+/**
+ * @brief Write totals, cubes per hour and reject rate as one JSON object.
+ */
+void throughput_write_json(json_writer_t *w, const char *key);
+
+#endif /* MAIN_THROUGHPUT_H_ */
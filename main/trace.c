@@ -0,0 +1,117 @@
+/*
+ * trace.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ */
+
+#include "trace.h"
+#include <string.h>
+#include "esp_timer.h"
+
+typedef struct {
+    uint32_t buckets[TRACE_BUCKETS];
+    uint32_t count;
+    uint32_t max_us;
+} trace_hist_t;
+
+static trace_hist_t hist[TRACE_STAGE_COUNT];
+
+static const char *const stage_names[TRACE_STAGE_COUNT] = {
+    [TRACE_INPUT_POST]    = "input_post",
+    [TRACE_INPUT_RECV]    = "input_recv",
+    [TRACE_EJECT_DECIDE]  = "eject_decide",
+    [TRACE_EJECT_GPIO]    = "eject_gpio",
+    [TRACE_PLACE_DECIDE]  = "place_decide",
+    [TRACE_PLACE_HANDOFF] = "place_handoff",
+    [TRACE_PLACE_SEND]    = "place_send",
+};
+
+/*
+ * Log-linear buckets: values below 2^TRACE_SUB_BITS have one bucket each,
+ * every further power of two is split into 2^TRACE_SUB_BITS equal parts.
+ */
+static uint32_t trace_bucket(uint32_t us)
+{
+    if (us < (1u << TRACE_SUB_BITS)) {
+        return us;
+    }
+
+    uint32_t msb = 31 - (uint32_t)__builtin_clz(us);
+    uint32_t sub = (us >> (msb - TRACE_SUB_BITS)) & ((1u << TRACE_SUB_BITS) - 1);
+    uint32_t idx = ((msb - TRACE_SUB_BITS + 1) << TRACE_SUB_BITS) + sub;
+
+    return idx < TRACE_BUCKETS ? idx : TRACE_BUCKETS - 1;
+}
+
+// Largest value that falls into the bucket
+static uint32_t trace_bucket_upper(uint32_t idx)
+{
+    if (idx < (1u << TRACE_SUB_BITS)) {
+        return idx;
+    }
+
+    uint32_t msb = (idx >> TRACE_SUB_BITS) - 1 + TRACE_SUB_BITS;
+    uint32_t sub = idx & ((1u << TRACE_SUB_BITS) - 1);
+    uint32_t width = 1u << (msb - TRACE_SUB_BITS);
+
+    return (((1u << TRACE_SUB_BITS) + sub) << (msb - TRACE_SUB_BITS)) + width - 1;
+}
+
+void trace_record(trace_stage_t stage, int64_t origin_us)
+{
+    if (origin_us == 0) {
+        return;
+    }
+
+    int64_t dt = esp_timer_get_time() - origin_us;
+    uint32_t us = dt < 0 ? 0 : (dt > UINT32_MAX ? UINT32_MAX : (uint32_t)dt);
+    trace_hist_t *h = &hist[stage];
+
+    h->buckets[trace_bucket(us)]++;
+    h->count++;
+    if (us > h->max_us) {
+        h->max_us = us;
+    }
+}
+
+void trace_reset(void)
+{
+    memset(hist, 0, sizeof(hist));
+}
+
+static uint32_t trace_percentile(const trace_hist_t *h, uint32_t count, uint32_t permille)
+{
+    // Rank of the sample, rounded up so p99 of 10 samples is the largest
+    uint64_t rank = ((uint64_t)count * permille + 999) / 1000;
+    uint64_t seen = 0;
+
+    for (uint32_t i = 0; i < TRACE_BUCKETS; i++) {
+        seen += h->buckets[i];
+        if (seen >= rank) {
+            uint32_t upper = trace_bucket_upper(i);
+            return upper < h->max_us ? upper : h->max_us;
+        }
+    }
+    return h->max_us;
+}
+
+void trace_write_json(json_writer_t *w)
+{
+    json_writer_object_begin(w, NULL);
+    for (int s = 0; s < TRACE_STAGE_COUNT; s++) {
+        const trace_hist_t *h = &hist[s];
+        uint32_t count = h->count;
+
+        json_writer_object_begin(w, stage_names[s]);
+        json_writer_uint(w, "count", count);
+        if (count > 0) {
+            json_writer_uint(w, "p50", trace_percentile(h, count, 500));
+            json_writer_uint(w, "p90", trace_percentile(h, count, 900));
+            json_writer_uint(w, "p99", trace_percentile(h, count, 990));
+            json_writer_uint(w, "max", h->max_us);
+        }
+        json_writer_object_end(w);
+    }
+    json_writer_object_end(w);
+}
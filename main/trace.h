@@ -0,0 +1,58 @@
+/*
+ * trace.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ *
+ * End-to-end latency tracing. Every trace point measures the time from
+ * the sensor edge that started the chain (the ISR timestamp carried in
+ * inputs_t) to the moment the stage completes, and adds it to the
+ * stage's histogram. Each stage is recorded by one task only, so the
+ * histograms need no locking. Served with percentiles at /api/trace.
+ *
+ * eject_gpio is the exception: the ejector fires at a belt position, so
+ * T2 to output would only measure belt travel. It is timed from the
+ * moment the belt reached the stroke position (from the encoder speed),
+ * which is the lateness of the position trigger.
+ *
+ * Timestamps are esp_timer microseconds: the stages run on both cores
+ * and the CPU cycle counters are not synchronised between them.
+ */
+
+#ifndef MAIN_TRACE_H_
+#define MAIN_TRACE_H_
+
+#include <stdint.h>
+#include "json_writer.h"
+
+#define TRACE_SUB_BITS      2       // 4 buckets per power of two, <= 25 % error
+#define TRACE_MAX_LOG2_US   24      // latencies above ~16 s land in the last bucket
+#define TRACE_BUCKETS       ((TRACE_MAX_LOG2_US - TRACE_SUB_BITS + 1) << TRACE_SUB_BITS)
+
+typedef enum {
+    TRACE_INPUT_POST = 0,   // edge -> debounced snapshot posted by io_task
+    TRACE_INPUT_RECV,       // edge -> snapshot taken by logic_task
+    TRACE_EJECT_DECIDE,     // T2 edge -> reject decision in logic_task
+    TRACE_EJECT_GPIO,       // belt at the stroke position -> ejector output set
+    TRACE_PLACE_DECIDE,     // T3 edge -> PLACE_CUBE queued for tcp_client_task
+    TRACE_PLACE_HANDOFF,    // T3 edge -> command taken by tcp_client_task
+    TRACE_PLACE_SEND,       // T3 edge -> PLACE_CUBE written to the robot socket
+    TRACE_STAGE_COUNT
+} trace_stage_t;
+
+/**
+ * @brief Record the latency of a stage since origin_us; ignored when origin_us is 0.
+ */
+void trace_record(trace_stage_t stage, int64_t origin_us);
+
+/**
+ * @brief Clear all histograms. Samples recorded concurrently may be lost.
+ */
+void trace_reset(void);
+
+/**
+ * @brief Write count, p50, p90, p99 and max (microseconds) per stage as one JSON object.
+ */
+void trace_write_json(json_writer_t *w);
+
+#endif /* MAIN_TRACE_H_ */
@@ -71,6 +71,9 @@ function handleMsg(o) {
   ['sensor1','sensor3','wrap_done','robot','inverter'].forEach(id => {
     if (o[id] !== undefined) setLamp(id, o[id]);
   });
+  ['layers','maxLayers'].forEach(id => {
+    if (o[id] !== undefined) document.getElementById(id).innerText = o[id];
+  });
   if (o.wrapProgress !== undefined) {
     document.getElementById('progressBar').style.width = o.wrapProgress + '%';
     document.getElementById('progress').innerText      = o.wrapProgress + '%';
@@ -96,5 +99,35 @@ function fetchStatus() {
     .then(data => handleMsg(data))
     .catch(() => log('Fetch error getting status', true));
 }
-setInterval(fetchStatus, 1000);
-fetchStatus();
+
+/**
+ * Status push over WebSocket; falls back to polling while the socket is down
+ */
+let pollTimer = null;
+
+function startPolling() {
+  if (pollTimer === null) {
+    fetchStatus();
+    pollTimer = setInterval(fetchStatus, 1000);
+  }
+}
+
+function stopPolling() {
+  if (pollTimer !== null) {
+    clearInterval(pollTimer);
+    pollTimer = null;
+  }
+}
+
+function connectStatusSocket() {
+  const ws = new WebSocket(`ws://${location.host}/ws`);
+  ws.onopen    = () => stopPolling();
+  ws.onmessage = ev => handleMsg(JSON.parse(ev.data));
+  ws.onclose   = () => {
+    startPolling();
+    setTimeout(connectStatusSocket, 3000);
+  };
+}
+
+startPolling();
+connectStatusSocket();
@@ -0,0 +1,150 @@
+/*
+ * weigh_detector.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ */
+
+#include "weigh_detector.h"
+#include <string.h>
+
+uint32_t weigh_isqrt64(uint64_t v)
+{
+    uint64_t r = 0;
+    uint64_t bit = 1ull << 62;
+
+    while (bit > v) {
+        bit >>= 2;
+    }
+    while (bit != 0) {
+        if (v >= r + bit) {
+            v -= r + bit;
+            r = (r >> 1) + bit;
+        } else {
+            r >>= 1;
+        }
+        bit >>= 2;
+    }
+
+    return (uint32_t)r;
+}
+
+void weigh_detector_init(weigh_detector_t *d, const weigh_config_t *cfg)
+{
+    memset(d, 0, sizeof(*d));
+    d->cfg = *cfg;
+    if (d->cfg.window_len < 2) {
+        d->cfg.window_len = 2;
+    }
+    if (d->cfg.window_len > WEIGH_WINDOW_MAX) {
+        d->cfg.window_len = WEIGH_WINDOW_MAX;
+    }
+    if (d->cfg.sample_rate_hz == 0) {
+        d->cfg.sample_rate_hz = 1;
+    }
+}
+
+void weigh_detector_arm(weigh_detector_t *d, uint16_t cube_id)
+{
+    d->cube_id = cube_id;
+    d->idx = 0;
+    d->fill = 0;
+    d->light = 0;
+    d->sum = 0;
+    d->sum_sq = 0;
+    d->elapsed = 0;
+    d->armed = true;
+}
+
+void weigh_detector_disarm(weigh_detector_t *d)
+{
+    d->armed = false;
+}
+
+bool weigh_detector_armed(const weigh_detector_t *d)
+{
+    return d->armed;
+}
+
+/**
+ * @brief Drift over the window: difference of the half-window means, in g/s
+ */
+static int32_t weigh_detector_slope(const weigh_detector_t *d)
+{
+    uint16_t n = d->fill;
+    uint16_t half = n / 2;
+    uint16_t oldest = (uint16_t)((d->idx + d->cfg.window_len - n) % d->cfg.window_len);
+    int64_t first = 0;
+    int64_t second = 0;
+
+    for (uint16_t i = 0; i < half * 2; i++) {
+        int32_t v = d->window[(oldest + i) % d->cfg.window_len];
+        if (i < half) {
+            first += v;
+        } else {
+            second += v;
+        }
+    }
+
+    // Half-window means are 'half' samples apart
+    int64_t diff = (second - first) / half;
+    int64_t slope = diff * (int64_t)d->cfg.sample_rate_hz / half;
+    return (int32_t)(slope < 0 ? -slope : slope);
+}
+
+bool weigh_detector_push(weigh_detector_t *d, int32_t sample_g, weigh_result_t *out)
+{
+    if (!d->armed) {
+        return false;
+    }
+
+    uint16_t len = d->cfg.window_len;
+
+    if (d->fill == len) {
+        int32_t old = d->window[d->idx];
+        d->sum -= old;
+        d->sum_sq -= (int64_t)old * old;
+        if (old < d->cfg.min_load_g) {
+            d->light--;
+        }
+    } else {
+        d->fill++;
+    }
+    d->window[d->idx] = sample_g;
+    d->idx = (uint16_t)((d->idx + 1) % len);
+    d->sum += sample_g;
+    d->sum_sq += (int64_t)sample_g * sample_g;
+    if (sample_g < d->cfg.min_load_g) {
+        d->light++;
+    }
+    d->elapsed++;
+
+    uint32_t elapsed_ms = (uint32_t)((uint64_t)d->elapsed * 1000u / d->cfg.sample_rate_hz);
+    bool timed_out = elapsed_ms >= d->cfg.timeout_ms;
+
+    if (d->fill < len && !timed_out) {
+        return false;
+    }
+
+    int64_t n = d->fill;
+    int64_t var_n2 = n * d->sum_sq - d->sum * d->sum;
+    uint32_t stddev = weigh_isqrt64(var_n2 > 0 ? (uint64_t)var_n2 : 0) / (uint32_t)n;
+    bool stable = d->fill == len && d->light == 0 &&
+                  (int32_t)stddev <= d->cfg.max_stddev_g &&
+                  weigh_detector_slope(d) <= d->cfg.max_slope_g_s;
+
+    if (!stable && !timed_out) {
+        return false;
+    }
+
+    out->status = stable ? WEIGH_RESULT_STABLE : WEIGH_RESULT_TIMEOUT;
+    out->mean_g = (int32_t)(d->sum / n);
+    out->raw_g = out->mean_g;
+    out->speed_mm_s = 0;
+    out->stddev_g = (int32_t)stddev;
+    out->samples = d->fill;
+    out->settle_ms = elapsed_ms;
+    out->cube_id = d->cube_id;
+    d->armed = false;
+    return true;
+}
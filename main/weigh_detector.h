@@ -0,0 +1,87 @@
+/*
+ * weigh_detector.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ *
+ * Weight settling detector. Once armed it watches the filtered weight
+ * stream and produces a single result as soon as the reading is stable
+ * (bounded spread and slope over a sliding window) or the timeout expires.
+ * A window holding any sample below the minimum load is never stable, so
+ * a platform still empty at arming is not weighed as a cube.
+ */
+
+#ifndef MAIN_WEIGH_DETECTOR_H_
+#define MAIN_WEIGH_DETECTOR_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define WEIGH_WINDOW_MAX    64
+
+typedef enum {
+    WEIGH_RESULT_STABLE = 0,
+    WEIGH_RESULT_TIMEOUT
+} weigh_status_t;
+
+typedef struct {
+    weigh_status_t status;
+    int32_t  mean_g;        // mean over the final window, compensated
+    int32_t  raw_g;         // mean before speed compensation
+    int32_t  speed_mm_s;    // belt speed during the measurement, 0 for a static weighing
+    int32_t  stddev_g;      // standard deviation over the final window
+    uint32_t samples;       // samples in the final window
+    uint32_t settle_ms;     // time from arming to the result
+    uint16_t cube_id;       // tag given to weigh_detector_arm()
+} weigh_result_t;
+
+typedef struct {
+    uint16_t window_len;        // samples in the sliding window (<= WEIGH_WINDOW_MAX)
+    uint32_t sample_rate_hz;    // rate of weigh_detector_push() calls
+    int32_t  max_stddev_g;      // spread limit for a stable reading
+    int32_t  max_slope_g_s;     // drift limit for a stable reading, grams per second
+    uint32_t timeout_ms;        // give up and report the last window after this time
+    int32_t  min_load_g;        // platform counts as loaded from here
+} weigh_config_t;
+
+typedef struct {
+    weigh_config_t cfg;
+    int32_t  window[WEIGH_WINDOW_MAX];
+    uint16_t idx;
+    uint16_t fill;
+    uint16_t light;             // samples in the window below min_load_g
+    int64_t  sum;
+    int64_t  sum_sq;
+    uint32_t elapsed;           // samples since arming
+    uint16_t cube_id;
+    bool     armed;
+} weigh_detector_t;
+
+/**
+ * @brief Integer square root, floor(sqrt(v)).
+ */
+uint32_t weigh_isqrt64(uint64_t v);
+
+void weigh_detector_init(weigh_detector_t *d, const weigh_config_t *cfg);
+
+/**
+ * @brief Start a new measurement, discarding any history.
+ * @param cube_id tag copied into the result.
+ */
+void weigh_detector_arm(weigh_detector_t *d, uint16_t cube_id);
+
+/**
+ * @brief Abort a measurement in progress.
+ */
+void weigh_detector_disarm(weigh_detector_t *d);
+
+bool weigh_detector_armed(const weigh_detector_t *d);
+
+/**
+ * @brief Feed one filtered sample.
+ *
+ * @return true when a result was written to @p out; the detector disarms itself.
+ */
+bool weigh_detector_push(weigh_detector_t *d, int32_t sample_g, weigh_result_t *out);
+
+#endif /* MAIN_WEIGH_DETECTOR_H_ */
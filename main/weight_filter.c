@@ -0,0 +1,88 @@
+/*
+ * weight_filter.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ */
+
+#include "weight_filter.h"
+#include <string.h>
+
+void weight_filter_init(weight_filter_t *f, uint8_t median_n, uint8_t iir_shift)
+{
+    if (median_n < 1) {
+        median_n = 1;
+    }
+    if (median_n > WEIGHT_FILTER_MEDIAN_MAX) {
+        median_n = WEIGHT_FILTER_MEDIAN_MAX;
+    }
+    if ((median_n & 1u) == 0) {
+        median_n--;
+    }
+
+    f->median_n = median_n;
+    f->iir_shift = (iir_shift > 15) ? 15 : iir_shift;
+    weight_filter_reset(f);
+}
+
+void weight_filter_reset(weight_filter_t *f)
+{
+    memset(f->window, 0, sizeof(f->window));
+    f->idx = 0;
+    f->fill = 0;
+    f->iir_q16 = 0;
+    f->primed = false;
+}
+
+static uint16_t weight_filter_median(const weight_filter_t *f)
+{
+    uint16_t sorted[WEIGHT_FILTER_MEDIAN_MAX];
+    uint8_t n = f->fill;
+
+    // Insertion sort, n <= 15
+    for (uint8_t i = 0; i < n; i++) {
+        uint16_t v = f->window[i];
+        int8_t j = (int8_t)i - 1;
+        while (j >= 0 && sorted[j] > v) {
+            sorted[j + 1] = sorted[j];
+            j--;
+        }
+        sorted[j + 1] = v;
+    }
+
+    return sorted[n / 2];
+}
+
+int32_t weight_filter_push(weight_filter_t *f, uint16_t raw)
+{
+    f->window[f->idx] = raw;
+    f->idx = (uint8_t)((f->idx + 1) % f->median_n);
+    if (f->fill < f->median_n) {
+        f->fill++;
+    }
+
+    int32_t x_q16 = (int32_t)weight_filter_median(f) << WEIGHT_FILTER_Q;
+
+    if (!f->primed || f->iir_shift == 0) {
+        // Start from the first value instead of ramping up from zero
+        f->iir_q16 = x_q16;
+        f->primed = true;
+    } else {
+        f->iir_q16 += (x_q16 - f->iir_q16) >> f->iir_shift;
+    }
+
+    return f->iir_q16;
+}
+
+uint32_t weight_filter_settle_samples(const weight_filter_t *f, uint8_t bits)
+{
+    uint32_t median_delay = f->median_n / 2u + 1u;
+
+    if (f->iir_shift == 0) {
+        return median_delay;
+    }
+
+    // (1 - 2^-k)^n < 2^-bits  =>  n > bits * ln(2) * 2^k, ln(2) ~ 710/1024
+    uint32_t iir = ((uint32_t)bits * (1u << f->iir_shift) * 710u + 1023u) / 1024u;
+    return median_delay + iir;
+}
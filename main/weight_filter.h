@@ -0,0 +1,56 @@
+/*
+ * weight_filter.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: majorBien
+ *
+ * Fixed point filter chain for the scale signal: median-of-N spike
+ * rejection followed by a first order IIR low-pass.
+ */
+
+#ifndef MAIN_WEIGHT_FILTER_H_
+#define MAIN_WEIGHT_FILTER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define WEIGHT_FILTER_MEDIAN_MAX    15
+#define WEIGHT_FILTER_Q             16      // Output is raw counts in Q16
+
+typedef struct {
+    uint16_t window[WEIGHT_FILTER_MEDIAN_MAX];
+    uint8_t  median_n;      // odd, 1..WEIGHT_FILTER_MEDIAN_MAX
+    uint8_t  idx;
+    uint8_t  fill;
+    uint8_t  iir_shift;     // IIR coefficient alpha = 1 / 2^iir_shift
+    int32_t  iir_q16;       // filter state, raw counts in Q16
+    bool     primed;
+} weight_filter_t;
+
+/**
+ * @brief Initialise the filter chain.
+ *
+ * @param median_n   Median window length, rounded down to an odd value
+ * @param iir_shift  IIR smoothing, 0 disables the low-pass stage
+ */
+void weight_filter_init(weight_filter_t *f, uint8_t median_n, uint8_t iir_shift);
+
+/**
+ * @brief Drop the filter history (e.g. after an ADC overrun).
+ */
+void weight_filter_reset(weight_filter_t *f);
+
+/**
+ * @brief Push one raw sample through the chain.
+ *
+ * @return Filtered value, raw counts in Q16.
+ */
+int32_t weight_filter_push(weight_filter_t *f, uint16_t raw);
+
+/**
+ * @brief Number of samples needed after a step until the output is within
+ *        1/2^bits of the final value (median delay + IIR settle time).
+ */
+uint32_t weight_filter_settle_samples(const weight_filter_t *f, uint8_t bits);
+
+#endif /* MAIN_WEIGHT_FILTER_H_ */